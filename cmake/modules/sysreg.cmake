@@ -0,0 +1,31 @@
+cmake_minimum_required(VERSION 3.22)
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(SYSREG_GENERATOR ${CMAKE_CURRENT_LIST_DIR}/../../utils/sysreg_gen.py)
+
+# Generate the system register map header (sysreg_map.h) from the register schema.
+#   TARGET      custom target producing the header
+#   SCHEMA      register schema (json)
+#   OUTPUT_DIR  directory for the generated header (exported as SYSREG_GENERATED_DIR)
+#   DOC         optional design document; adds a `<TARGET>-docs` target rewriting its register table
+function(sysreg_generate)
+  cmake_parse_arguments(SYSREG "" "TARGET;SCHEMA;OUTPUT_DIR;DOC" "" ${ARGN})
+  set(SYSREG_HEADER ${SYSREG_OUTPUT_DIR}/sysreg_map.h)
+  add_custom_command(
+    OUTPUT ${SYSREG_HEADER}
+    COMMAND ${Python3_EXECUTABLE} ${SYSREG_GENERATOR} --schema ${SYSREG_SCHEMA} --header ${SYSREG_HEADER}
+    DEPENDS ${SYSREG_SCHEMA} ${SYSREG_GENERATOR}
+    COMMENT "Generating system register map from ${SYSREG_SCHEMA}"
+  )
+  add_custom_target(${SYSREG_TARGET} DEPENDS ${SYSREG_HEADER})
+  if(SYSREG_DOC)
+    add_custom_target(
+      ${SYSREG_TARGET}-docs
+      COMMAND ${Python3_EXECUTABLE} ${SYSREG_GENERATOR} --schema ${SYSREG_SCHEMA} --doc ${SYSREG_DOC}
+      DEPENDS ${SYSREG_SCHEMA} ${SYSREG_GENERATOR}
+      COMMENT "Updating system register table in ${SYSREG_DOC}"
+    )
+  endif()
+  set(SYSREG_GENERATED_DIR ${SYSREG_OUTPUT_DIR} PARENT_SCOPE)
+endfunction()
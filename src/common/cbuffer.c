@@ -14,9 +14,39 @@
 #include <assert.h>
 #include <string.h> // memcpy
 
+// NOTE: internal function no null ptr assertions
+// power of two capacities wrap with a mask instead of a division
+static inline size_t advance(const struct cbuffer_handle *cb, size_t idx, size_t n) {
+  return cb->mask ? (idx + n) & cb->mask : (idx + n) % cb->size;
+}
+
+// NOTE: internal function no null ptr assertions
+static inline size_t next(const struct cbuffer_handle *cb, size_t idx) { return advance(cb, idx, 1); }
+
+// NOTE: internal function no null ptr assertions
+static inline void *elem_at(const struct cbuffer_handle *cb, size_t idx) {
+  return (uint8_t *)cb->buffer + idx * cb->elem_size;
+}
+
+// NOTE: internal function no null ptr assertions
+// copy n elements into ring storage starting at idx in at most two segments split at the wrap point
+static void copy_in(void *buffer, size_t size, size_t elem_size, size_t idx, const void *data, size_t n) {
+  const size_t first = size - idx < n ? size - idx : n;
+  memcpy((uint8_t *)buffer + idx * elem_size, data, first * elem_size);
+  memcpy(buffer, (const uint8_t *)data + first * elem_size, (n - first) * elem_size);
+}
+
+// NOTE: internal function no null ptr assertions
+// copy n elements out of ring storage starting at idx in at most two segments split at the wrap point
+static void copy_out(const void *buffer, size_t size, size_t elem_size, size_t idx, void *data, size_t n) {
+  const size_t first = size - idx < n ? size - idx : n;
+  memcpy(data, (const uint8_t *)buffer + idx * elem_size, first * elem_size);
+  memcpy((uint8_t *)data + first * elem_size, buffer, (n - first) * elem_size);
+}
+
 // NOTE: internal function no null ptr assertions
 static inline uint8_t is_full(struct cbuffer_handle *cb) {
-  return ((cb->head + 1) % cb->size) == cb->tail;
+  return next(cb, cb->head) == cb->tail;
 }
 
 // NOTE: internal function no null ptr assertions
@@ -29,16 +59,49 @@ void cbuffer_init(struct cbuffer_handle *cbuffer, void *buffer, size_t elem_size
   cbuffer->buffer = buffer;
   cbuffer->size = size;
   cbuffer->elem_size = elem_size;
+  cbuffer->mask = (size & (size - 1)) == 0 ? size - 1 : 0;
+}
+
+cbuffer_status_t cbuffer_reserve(struct cbuffer_handle *cbuffer, void **slot) {
+  assert(cbuffer && slot);
+  if (is_full(cbuffer)) {
+    return CBUFFER_OVERFLOW;
+  }
+  *slot = elem_at(cbuffer, cbuffer->head);
+  return CBUFFER_SUCCESS;
+}
+
+void cbuffer_commit(struct cbuffer_handle *cbuffer) {
+  assert(cbuffer && !is_full(cbuffer));
+  cbuffer->head = next(cbuffer, cbuffer->head);
+}
+
+cbuffer_status_t cbuffer_peek(struct cbuffer_handle *cbuffer, const void **slot) {
+  assert(cbuffer && slot);
+  if (is_empty(cbuffer)) {
+    return CBUFFER_UNDERFLOW;
+  }
+  *slot = elem_at(cbuffer, cbuffer->tail);
+  return CBUFFER_SUCCESS;
+}
+
+cbuffer_status_t cbuffer_release(struct cbuffer_handle *cbuffer) {
+  assert(cbuffer && !is_empty(cbuffer));
+  cbuffer->tail = next(cbuffer, cbuffer->tail);
+  if (is_empty(cbuffer)) {
+    return CBUFFER_EMPTY;
+  }
+  return CBUFFER_SUCCESS;
 }
 
 cbuffer_status_t cbuffer_push(struct cbuffer_handle *cbuffer, const void *data) {
   assert(cbuffer);
-  if (is_full(cbuffer)) {
+  const size_t head = next(cbuffer, cbuffer->head);
+  if (head == cbuffer->tail) {
     return CBUFFER_OVERFLOW;
   }
-  size_t index = (cbuffer->head * cbuffer->elem_size) % (cbuffer->size * cbuffer->elem_size);
-  memcpy((uint8_t *)cbuffer->buffer + index, data, cbuffer->elem_size);
-  cbuffer->head = (cbuffer->head + 1) % cbuffer->size;
+  memcpy(elem_at(cbuffer, cbuffer->head), data, cbuffer->elem_size);
+  cbuffer->head = head;
   return CBUFFER_SUCCESS;
 }
 
@@ -47,11 +110,228 @@ cbuffer_status_t cbuffer_pop(struct cbuffer_handle *cbuffer, void *data) {
   if (is_empty(cbuffer)) {
     return CBUFFER_UNDERFLOW;
   }
-  size_t index = (cbuffer->tail * cbuffer->elem_size) % (cbuffer->size * cbuffer->elem_size);
-  memcpy(data, (uint8_t *)cbuffer->buffer + index, cbuffer->elem_size);
-  cbuffer->tail = (cbuffer->tail + 1) % cbuffer->size;
+  memcpy(data, elem_at(cbuffer, cbuffer->tail), cbuffer->elem_size);
+  cbuffer->tail = next(cbuffer, cbuffer->tail);
   if (is_empty(cbuffer)) {
     return CBUFFER_EMPTY;
   }
   return CBUFFER_SUCCESS;
 }
+
+size_t cbuffer_count(const struct cbuffer_handle *cbuffer) {
+  assert(cbuffer);
+  return cbuffer->mask ? (cbuffer->head - cbuffer->tail) & cbuffer->mask : (cbuffer->head + cbuffer->size - cbuffer->tail) % cbuffer->size;
+}
+
+size_t cbuffer_space(const struct cbuffer_handle *cbuffer) {
+  // one slot is kept free to tell a full buffer from an empty one
+  return cbuffer->size - 1 - cbuffer_count(cbuffer);
+}
+
+size_t cbuffer_push_n(struct cbuffer_handle *cbuffer, const void *data, size_t n) {
+  assert(cbuffer && data);
+  const size_t space = cbuffer_space(cbuffer);
+  n = n < space ? n : space;
+  copy_in(cbuffer->buffer, cbuffer->size, cbuffer->elem_size, cbuffer->head, data, n);
+  cbuffer->head = advance(cbuffer, cbuffer->head, n);
+  return n;
+}
+
+size_t cbuffer_pop_n(struct cbuffer_handle *cbuffer, void *data, size_t n) {
+  assert(cbuffer && data);
+  const size_t count = cbuffer_count(cbuffer);
+  n = n < count ? n : count;
+  copy_out(cbuffer->buffer, cbuffer->size, cbuffer->elem_size, cbuffer->tail, data, n);
+  cbuffer->tail = advance(cbuffer, cbuffer->tail, n);
+  return n;
+}
+
+// NOTE: internal function no null ptr assertions
+static inline size_t spsc_advance(const struct cbuffer_spsc *cb, size_t idx, size_t n) {
+  return cb->mask ? (idx + n) & cb->mask : (idx + n) % cb->size;
+}
+
+// NOTE: internal function no null ptr assertions
+static inline size_t spsc_next(const struct cbuffer_spsc *cb, size_t idx) { return spsc_advance(cb, idx, 1); }
+
+// NOTE: internal function no null ptr assertions
+static inline size_t spsc_count(const struct cbuffer_spsc *cb, size_t head, size_t tail) {
+  return cb->mask ? (head - tail) & cb->mask : (head + cb->size - tail) % cb->size;
+}
+
+void cbuffer_spsc_init(struct cbuffer_spsc *cbuffer, void *buffer, size_t elem_size, size_t size) {
+  assert(cbuffer && buffer);
+  cbuffer->buffer = buffer;
+  cbuffer->size = size;
+  cbuffer->elem_size = elem_size;
+  cbuffer->mask = (size & (size - 1)) == 0 ? size - 1 : 0;
+  cbuffer->overwrite = false;
+  cbuffer->tail_cache = 0;
+  cbuffer->head_cache = 0;
+  __atomic_store_n(&cbuffer->overwritten, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&cbuffer->head, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&cbuffer->tail, 0, __ATOMIC_RELEASE);
+}
+
+void cbuffer_spsc_set_overwrite(struct cbuffer_spsc *cbuffer) {
+  assert(cbuffer);
+  cbuffer->overwrite = true;
+}
+
+size_t cbuffer_spsc_overwritten(const struct cbuffer_spsc *cbuffer) {
+  assert(cbuffer);
+  return __atomic_load_n(&cbuffer->overwritten, __ATOMIC_RELAXED);
+}
+
+// NOTE: internal function no null ptr assertions
+// count elements lost in overwrite mode; only the producer writes the count
+static inline void spsc_count_overwritten(struct cbuffer_spsc *cb, size_t n) {
+  __atomic_store_n(&cb->overwritten, __atomic_load_n(&cb->overwritten, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// NOTE: internal function no null ptr assertions
+// drop the n oldest elements in overwrite mode. The count is stored before the tail and both before
+// the slot writes that follow, so a snapshot that observes either the new tail or a rewritten slot
+// also observes the count.
+static void spsc_drop(struct cbuffer_spsc *cb, size_t n) {
+  spsc_count_overwritten(cb, n);
+  cb->tail_cache = spsc_advance(cb, cb->tail_cache, n);
+  __atomic_store_n(&cb->tail, cb->tail_cache, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+cbuffer_status_t cbuffer_spsc_reserve(struct cbuffer_spsc *cbuffer, void **slot) {
+  assert(cbuffer && slot);
+  // only the producer writes head
+  const size_t head = __atomic_load_n(&cbuffer->head, __ATOMIC_RELAXED);
+  const size_t next = spsc_next(cbuffer, head);
+  if (next == cbuffer->tail_cache && cbuffer->overwrite) {
+    // the producer owns the tail in overwrite mode so the cached copy is exact
+    spsc_drop(cbuffer, 1);
+  } else if (next == cbuffer->tail_cache) {
+    // looks full: refresh the consumer's progress, acquiring its reads of the slot
+    cbuffer->tail_cache = __atomic_load_n(&cbuffer->tail, __ATOMIC_ACQUIRE);
+    if (next == cbuffer->tail_cache) {
+      return CBUFFER_OVERFLOW;
+    }
+  }
+  *slot = (uint8_t *)cbuffer->buffer + head * cbuffer->elem_size;
+  return CBUFFER_SUCCESS;
+}
+
+void cbuffer_spsc_commit(struct cbuffer_spsc *cbuffer) {
+  assert(cbuffer);
+  const size_t head = __atomic_load_n(&cbuffer->head, __ATOMIC_RELAXED);
+  // publish the element written to the slot
+  __atomic_store_n(&cbuffer->head, spsc_next(cbuffer, head), __ATOMIC_RELEASE);
+}
+
+cbuffer_status_t cbuffer_spsc_push(struct cbuffer_spsc *cbuffer, const void *data) {
+  void *slot;
+  if (cbuffer_spsc_reserve(cbuffer, &slot) != CBUFFER_SUCCESS) {
+    return CBUFFER_OVERFLOW;
+  }
+  memcpy(slot, data, cbuffer->elem_size);
+  cbuffer_spsc_commit(cbuffer);
+  return CBUFFER_SUCCESS;
+}
+
+size_t cbuffer_spsc_push_n(struct cbuffer_spsc *cbuffer, const void *data, size_t n) {
+  assert(cbuffer && data);
+  const size_t head = __atomic_load_n(&cbuffer->head, __ATOMIC_RELAXED);
+  if (!cbuffer->overwrite) {
+    cbuffer->tail_cache = __atomic_load_n(&cbuffer->tail, __ATOMIC_ACQUIRE);
+  }
+  const size_t space = cbuffer->size - 1 - spsc_count(cbuffer, head, cbuffer->tail_cache);
+  if (n > space && !cbuffer->overwrite) {
+    n = space;
+  } else if (n > space) {
+    // only the newest size - 1 elements of the block can be kept
+    const size_t capacity = cbuffer->size - 1;
+    if (n > capacity) {
+      spsc_count_overwritten(cbuffer, n - capacity);
+      data = (const uint8_t *)data + (n - capacity) * cbuffer->elem_size;
+      n = capacity;
+    }
+    if (n > space) {
+      spsc_drop(cbuffer, n - space);
+    }
+  }
+  copy_in(cbuffer->buffer, cbuffer->size, cbuffer->elem_size, head, data, n);
+  // publish the whole block at once
+  __atomic_store_n(&cbuffer->head, spsc_advance(cbuffer, head, n), __ATOMIC_RELEASE);
+  return n;
+}
+
+cbuffer_status_t cbuffer_spsc_peek(struct cbuffer_spsc *cbuffer, const void **slot) {
+  assert(cbuffer && slot && !cbuffer->overwrite);
+  // only the consumer writes tail
+  const size_t tail = __atomic_load_n(&cbuffer->tail, __ATOMIC_RELAXED);
+  if (tail == cbuffer->head_cache) {
+    // looks empty: refresh the producer's progress, acquiring its writes to the slot
+    cbuffer->head_cache = __atomic_load_n(&cbuffer->head, __ATOMIC_ACQUIRE);
+    if (tail == cbuffer->head_cache) {
+      return CBUFFER_UNDERFLOW;
+    }
+  }
+  *slot = (const uint8_t *)cbuffer->buffer + tail * cbuffer->elem_size;
+  return CBUFFER_SUCCESS;
+}
+
+cbuffer_status_t cbuffer_spsc_release(struct cbuffer_spsc *cbuffer) {
+  assert(cbuffer);
+  const size_t tail = spsc_next(cbuffer, __atomic_load_n(&cbuffer->tail, __ATOMIC_RELAXED));
+  // hand the slot back to the producer once it has been read
+  __atomic_store_n(&cbuffer->tail, tail, __ATOMIC_RELEASE);
+  if (tail == cbuffer->head_cache) {
+    return CBUFFER_EMPTY;
+  }
+  return CBUFFER_SUCCESS;
+}
+
+cbuffer_status_t cbuffer_spsc_pop(struct cbuffer_spsc *cbuffer, void *data) {
+  const void *slot;
+  if (cbuffer_spsc_peek(cbuffer, &slot) != CBUFFER_SUCCESS) {
+    return CBUFFER_UNDERFLOW;
+  }
+  memcpy(data, slot, cbuffer->elem_size);
+  return cbuffer_spsc_release(cbuffer);
+}
+
+size_t cbuffer_spsc_pop_n(struct cbuffer_spsc *cbuffer, void *data, size_t n) {
+  assert(cbuffer && data && !cbuffer->overwrite);
+  const size_t tail = __atomic_load_n(&cbuffer->tail, __ATOMIC_RELAXED);
+  const size_t head = __atomic_load_n(&cbuffer->head, __ATOMIC_ACQUIRE);
+  cbuffer->head_cache = head;
+  const size_t count = spsc_count(cbuffer, head, tail);
+  n = n < count ? n : count;
+  copy_out(cbuffer->buffer, cbuffer->size, cbuffer->elem_size, tail, data, n);
+  // release the whole block at once
+  __atomic_store_n(&cbuffer->tail, spsc_advance(cbuffer, tail, n), __ATOMIC_RELEASE);
+  return n;
+}
+
+size_t cbuffer_spsc_snapshot(const struct cbuffer_spsc *cbuffer, void *data, size_t n) {
+  assert(cbuffer && data && cbuffer->overwrite);
+  size_t overwritten, tail, head;
+  // the tail only moves with the overwritten count, so an unchanged count means consistent indices
+  do {
+    overwritten = __atomic_load_n(&cbuffer->overwritten, __ATOMIC_ACQUIRE);
+    tail = __atomic_load_n(&cbuffer->tail, __ATOMIC_ACQUIRE);
+    head = __atomic_load_n(&cbuffer->head, __ATOMIC_ACQUIRE);
+  } while (overwritten != __atomic_load_n(&cbuffer->overwritten, __ATOMIC_ACQUIRE));
+  const size_t count = spsc_count(cbuffer, head, tail);
+  const size_t skip = count > n ? count - n : 0;
+  n = count - skip;
+  copy_out(cbuffer->buffer, cbuffer->size, cbuffer->elem_size, spsc_advance(cbuffer, tail, skip), data, n);
+  // the producer only rewrites slots it has dropped, oldest first: every element dropped during the
+  // copy may be torn, so leave out that many from the front of the window
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  const size_t dropped = __atomic_load_n(&cbuffer->overwritten, __ATOMIC_RELAXED) - overwritten;
+  const size_t torn = dropped > skip ? dropped - skip : 0;
+  if (torn >= n) {
+    return 0;
+  }
+  memmove(data, (const uint8_t *)data + torn * cbuffer->elem_size, (n - torn) * cbuffer->elem_size);
+  return n - torn;
+}
@@ -12,6 +12,7 @@
 #ifndef __CBUFFER_H__
 #define __CBUFFER_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 
 typedef int cbuffer_status_t;
@@ -22,10 +23,20 @@ typedef int cbuffer_status_t;
 #define CBUFFER_OVERFLOW (cbuffer_status_t)3
 #define CBUFFER_UNDERFLOW (cbuffer_status_t)4
 
+// separates the producer and consumer indices of a cbuffer_spsc (Cortex-M7 D-cache line is 32 bytes)
+#ifndef CBUFFER_CACHE_LINE
+#ifdef UNITTEST
+#define CBUFFER_CACHE_LINE 64
+#else
+#define CBUFFER_CACHE_LINE 32
+#endif
+#endif
+
 struct cbuffer_handle {
   void *buffer;     // buffer data
   size_t size;      // buffer size
   size_t elem_size; // element size
+  size_t mask;      // size - 1 if size is a power of two, 0 otherwise
   size_t head;      // head position idx
   size_t tail;      // tail position idx
 };
@@ -34,4 +45,144 @@ void cbuffer_init(struct cbuffer_handle *cbuffer, void *buffer, size_t elem_size
 cbuffer_status_t cbuffer_push(struct cbuffer_handle *cbuffer, const void *data);
 cbuffer_status_t cbuffer_pop(struct cbuffer_handle *cbuffer, void *data);
 
+/**
+ * @brief Reserve the slot at the head so the producer can write an element in place (e.g. from a
+ * DMA transfer or an encoder). The element becomes visible to the consumer on cbuffer_commit.
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @param[out] slot reserved element storage
+ * @return CBUFFER_SUCCESS or CBUFFER_OVERFLOW if the buffer is full
+ */
+cbuffer_status_t cbuffer_reserve(struct cbuffer_handle *cbuffer, void **slot);
+
+/**
+ * @brief Publish the element written to the slot returned by the last cbuffer_reserve
+ *
+ * @param[in] cbuffer circular buffer handle
+ */
+void cbuffer_commit(struct cbuffer_handle *cbuffer);
+
+/**
+ * @brief Access the oldest element in place without copying it out. The slot stays valid until
+ * cbuffer_release.
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @param[out] slot oldest element storage
+ * @return CBUFFER_SUCCESS or CBUFFER_UNDERFLOW if the buffer is empty
+ */
+cbuffer_status_t cbuffer_peek(struct cbuffer_handle *cbuffer, const void **slot);
+
+/**
+ * @brief Free the slot returned by the last cbuffer_peek
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @return CBUFFER_EMPTY if it was the last element, CBUFFER_SUCCESS otherwise
+ */
+cbuffer_status_t cbuffer_release(struct cbuffer_handle *cbuffer);
+
+/**
+ * @brief Number of elements stored
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @return element count
+ */
+size_t cbuffer_count(const struct cbuffer_handle *cbuffer);
+
+/**
+ * @brief Number of elements that can be pushed before the buffer is full
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @return free element slots
+ */
+size_t cbuffer_space(const struct cbuffer_handle *cbuffer);
+
+/**
+ * @brief Push a block of elements with at most two copies split at the wrap point. Pushes as many
+ * elements as fit.
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @param[in] data contiguous elements
+ * @param[in] n number of elements
+ * @return number of elements pushed
+ */
+size_t cbuffer_push_n(struct cbuffer_handle *cbuffer, const void *data, size_t n);
+
+/**
+ * @brief Pop a block of elements with at most two copies split at the wrap point. Pops as many
+ * elements as are stored.
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @param[out] data contiguous element storage
+ * @param[in] n maximum number of elements
+ * @return number of elements popped
+ */
+size_t cbuffer_pop_n(struct cbuffer_handle *cbuffer, void *data, size_t n);
+
+/**
+ * @brief Single-producer single-consumer circular buffer. One context (task or ISR) pushes and
+ * another pops without locks or masking interrupts: the producer publishes the head with release
+ * semantics after writing an element and the consumer publishes the tail with release semantics
+ * after reading one. Each side keeps its index and a cached copy of the other side's index on its
+ * own cache line. pop and release return CBUFFER_EMPTY when no further element had been observed;
+ * the producer may have pushed one since.
+ */
+struct cbuffer_spsc {
+  void *buffer;     // buffer data
+  size_t size;      // buffer size
+  size_t elem_size; // element size
+  size_t mask;      // size - 1 if size is a power of two, 0 otherwise
+  bool overwrite;   // drop the oldest element instead of rejecting a push when full
+  // producer owned
+  size_t head __attribute__((aligned(CBUFFER_CACHE_LINE))); // head position idx
+  size_t tail_cache;                                         // last observed tail
+  size_t overwritten;                                        // elements dropped in overwrite mode
+  // consumer owned
+  size_t tail __attribute__((aligned(CBUFFER_CACHE_LINE))); // tail position idx
+  size_t head_cache;                                         // last observed head
+};
+
+void cbuffer_spsc_init(struct cbuffer_spsc *cbuffer, void *buffer, size_t elem_size, size_t size);
+// producer side
+cbuffer_status_t cbuffer_spsc_push(struct cbuffer_spsc *cbuffer, const void *data);
+cbuffer_status_t cbuffer_spsc_reserve(struct cbuffer_spsc *cbuffer, void **slot);
+void cbuffer_spsc_commit(struct cbuffer_spsc *cbuffer);
+size_t cbuffer_spsc_push_n(struct cbuffer_spsc *cbuffer, const void *data, size_t n);
+
+/**
+ * @brief Switch a ring to overwrite-oldest mode (flight recorder history). A push to a full ring
+ * drops the oldest element and counts it instead of failing. The producer then owns the tail as
+ * well, so the ring is read with cbuffer_spsc_snapshot rather than the consumer side functions.
+ * Call after init and before the ring is shared.
+ *
+ * @param[in] cbuffer circular buffer handle
+ */
+void cbuffer_spsc_set_overwrite(struct cbuffer_spsc *cbuffer);
+
+/**
+ * @brief Number of elements dropped in overwrite mode since init
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @return overwritten element count (wraps)
+ */
+size_t cbuffer_spsc_overwritten(const struct cbuffer_spsc *cbuffer);
+
+/**
+ * @brief Copy the most recent elements of an overwrite mode ring to a linear buffer, oldest first,
+ * without stopping the producer. Elements the producer overwrote during the copy are left out, so
+ * the result is always a consistent, contiguous run ending at the newest element observed. Safe
+ * from any context, including a fault handler.
+ *
+ * @param[in] cbuffer circular buffer handle
+ * @param[out] data contiguous element storage
+ * @param[in] n maximum number of elements
+ * @return number of elements copied
+ */
+size_t cbuffer_spsc_snapshot(const struct cbuffer_spsc *cbuffer, void *data, size_t n);
+
+// consumer side (reject mode only)
+cbuffer_status_t cbuffer_spsc_pop(struct cbuffer_spsc *cbuffer, void *data);
+cbuffer_status_t cbuffer_spsc_peek(struct cbuffer_spsc *cbuffer, const void **slot);
+cbuffer_status_t cbuffer_spsc_release(struct cbuffer_spsc *cbuffer);
+size_t cbuffer_spsc_pop_n(struct cbuffer_spsc *cbuffer, void *data, size_t n);
+
 #endif // __CBUFFER_H__
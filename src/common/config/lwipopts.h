@@ -53,10 +53,26 @@ a lot of data that needs to be copied, this should be set high. */
 /* Relocate the LwIP RAM heap pointer */
 #define LWIP_RAM_HEAP_POINTER (0x30004000)
 
+/* Pools are sized for the log server, the only socket user: one listener,
+   LOGFAN_MAX_CLIENTS (4) clients, as many connections waiting in the accept
+   backlog and one UDP stream. DHCP takes one more raw UDP pcb. */
+
+/* MEMP_NUM_NETCONN: the number of struct netconns (one per socket).
+   listener + 4 clients + 4 backlog + UDP stream */
+#define MEMP_NUM_NETCONN 10
+
 /* MEMP_NUM_TCP_PCB: the number of simultaneously active TCP
-   connections. */
+   connections. 4 clients + 4 backlog + 2 closing; lwIP reclaims TIME_WAIT
+   pcbs when the pool runs out. */
 #define MEMP_NUM_TCP_PCB 10
 
+/* MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP connections. */
+#define MEMP_NUM_TCP_PCB_LISTEN 1
+
+/* MEMP_NUM_UDP_PCB: the number of UDP protocol control blocks. DHCP + log
+   stream */
+#define MEMP_NUM_UDP_PCB 2
+
 /* MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP
    segments. */
 #define MEMP_NUM_TCP_SEG TCP_SND_QUEUELEN
@@ -1,8 +1,15 @@
 
 #include "dtc.h"
+#include "timebase.h"
+
+#define DTC_HISTORY_LEN 16
+
+// most recent events, stamped at the time they were posted
+static struct dtc_event dtc_history[DTC_HISTORY_LEN];
+static uint32_t dtc_posted;
 
 void dtc_post_event(const enum DTCID event) {
-  // store event
+  const uint32_t slot = __atomic_fetch_add(&dtc_posted, 1, __ATOMIC_RELAXED) % DTC_HISTORY_LEN;
+  dtc_history[slot] = (struct dtc_event){.timestamp = timebase_now(), .event = event};
   // Not sure if this should be sync or async but event needs to be transmitted to host
 }
-
@@ -11,7 +11,7 @@ enum DTCID {
 };
 
 struct dtc_event {
-  uint32_t timestamp;
+  uint64_t timestamp; // timebase ticks
   enum DTCID event;
 };
 
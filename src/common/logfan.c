@@ -0,0 +1,199 @@
+/**
+ * @file logfan.c
+ * @brief Shared ring of formatted log lines with per-client read cursors
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "logfan.h"
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @brief Each line is stored behind a 6 byte header (16 bit length, 32 bit append time) without
+ * padding; lines wrap around the end of the buffer.
+ */
+#define LOGFAN_HEADER_SIZE 6u
+#define LOGFAN_MAX_LINE_LEN 0xFFFFu
+
+struct line_header {
+  uint16_t len;
+  uint32_t time;
+};
+
+static void _copy_in(struct logfan *fan, uint32_t pos, const void *data, size_t len) {
+  uint32_t offset = pos & (fan->size - 1);
+  size_t first = fan->size - offset < len ? fan->size - offset : len;
+  memcpy(fan->buffer + offset, data, first);
+  memcpy(fan->buffer, (const uint8_t *)data + first, len - first);
+}
+
+static void _copy_out(const struct logfan *fan, uint32_t pos, void *data, size_t len) {
+  uint32_t offset = pos & (fan->size - 1);
+  size_t first = fan->size - offset < len ? fan->size - offset : len;
+  memcpy(data, fan->buffer + offset, first);
+  memcpy((uint8_t *)data + first, fan->buffer, len - first);
+}
+
+static struct line_header _header(const struct logfan *fan, uint32_t pos) {
+  uint8_t raw[LOGFAN_HEADER_SIZE];
+  struct line_header header;
+  _copy_out(fan, pos, raw, sizeof(raw));
+  memcpy(&header.len, raw, sizeof(header.len));
+  memcpy(&header.time, raw + sizeof(header.len), sizeof(header.time));
+  return header;
+}
+
+// terminates a line whose remainder was overwritten before the client consumed it
+static const uint8_t torn_line_end = '\n';
+
+/**
+ * @brief Move a client that fell behind the oldest retained line up to it
+ */
+static struct logfan_client *_client(struct logfan *fan, int id) {
+  assert(fan && id >= 0 && id < LOGFAN_MAX_CLIENTS && fan->clients[id].active);
+  struct logfan_client *client = &fan->clients[id];
+  if ((int32_t)(client->seq - fan->tail_seq) < 0) {
+    client->skipped += fan->tail_seq - client->seq;
+    client->torn |= client->offset != 0;
+    client->pos = fan->tail;
+    client->seq = fan->tail_seq;
+    client->bytes = fan->tail_bytes;
+    client->offset = 0;
+  }
+  return client;
+}
+
+void logfan_init(struct logfan *fan, void *buffer, size_t size) {
+  assert(fan && buffer);
+  assert(size > LOGFAN_HEADER_SIZE && (size & (size - 1)) == 0 && size <= UINT32_MAX / 2);
+  memset(fan, 0, sizeof(*fan));
+  fan->buffer = buffer;
+  fan->size = (uint32_t)size;
+}
+
+int logfan_attach(struct logfan *fan) {
+  assert(fan);
+  for (int id = 0; id < LOGFAN_MAX_CLIENTS; id++) {
+    struct logfan_client *client = &fan->clients[id];
+    if (!client->active) {
+      client->active = true;
+      client->pos = fan->tail;
+      client->offset = 0;
+      client->seq = fan->tail_seq;
+      client->bytes = fan->tail_bytes;
+      client->skipped = 0;
+      client->torn = false;
+      return id;
+    }
+  }
+  return -1;
+}
+
+void logfan_detach(struct logfan *fan, int id) {
+  assert(fan && id >= 0 && id < LOGFAN_MAX_CLIENTS);
+  fan->clients[id].active = false;
+}
+
+void logfan_append(struct logfan *fan, const char *line, size_t len, uint32_t now) {
+  assert(fan && (line || len == 0));
+  if (len > fan->size - LOGFAN_HEADER_SIZE) {
+    len = fan->size - LOGFAN_HEADER_SIZE;
+  }
+  if (len > LOGFAN_MAX_LINE_LEN) {
+    len = LOGFAN_MAX_LINE_LEN;
+  }
+  const uint32_t total = LOGFAN_HEADER_SIZE + (uint32_t)len;
+  // overwrite the oldest lines; lagging clients catch up lazily
+  while (fan->head - fan->tail + total > fan->size) {
+    struct line_header oldest = _header(fan, fan->tail);
+    fan->tail += LOGFAN_HEADER_SIZE + oldest.len;
+    fan->tail_seq++;
+    fan->tail_bytes += oldest.len;
+  }
+  uint8_t raw[LOGFAN_HEADER_SIZE];
+  const uint16_t length = (uint16_t)len;
+  memcpy(raw, &length, sizeof(length));
+  memcpy(raw + sizeof(length), &now, sizeof(now));
+  _copy_in(fan, fan->head, raw, sizeof(raw));
+  _copy_in(fan, fan->head + LOGFAN_HEADER_SIZE, line, len);
+  fan->head += total;
+  fan->head_seq++;
+  fan->head_bytes += (uint32_t)len;
+}
+
+size_t logfan_pending(struct logfan *fan, int id) {
+  struct logfan_client *client = _client(fan, id);
+  return fan->head_bytes - client->bytes + client->torn;
+}
+
+uint32_t logfan_age(struct logfan *fan, int id, uint32_t now) {
+  struct logfan_client *client = _client(fan, id);
+  if (client->pos == fan->head) {
+    return 0;
+  }
+  return now - _header(fan, client->pos).time;
+}
+
+size_t logfan_peek(struct logfan *fan, int id, void *data, size_t size) {
+  struct logfan_client *client = _client(fan, id);
+  uint8_t *out = data;
+  size_t copied = 0;
+  uint32_t pos = client->pos;
+  uint32_t offset = client->offset;
+  if (client->torn && size > 0) {
+    out[copied++] = torn_line_end;
+  }
+  while (pos != fan->head && copied < size) {
+    struct line_header header = _header(fan, pos);
+    size_t avail = header.len - offset;
+    if (copied + avail > size) {
+      if (copied != 0) {
+        break;
+      }
+      avail = size - copied;
+    }
+    _copy_out(fan, pos + LOGFAN_HEADER_SIZE + offset, out + copied, avail);
+    copied += avail;
+    pos += LOGFAN_HEADER_SIZE + header.len;
+    offset = 0;
+  }
+  return copied;
+}
+
+void logfan_advance(struct logfan *fan, int id, size_t len) {
+  struct logfan_client *client = _client(fan, id);
+  assert(len <= (size_t)(fan->head_bytes - client->bytes + client->torn));
+  if (client->torn && len > 0) {
+    client->torn = false;
+    len--;
+  }
+  client->bytes += (uint32_t)len;
+  while (len > 0) {
+    struct line_header header = _header(fan, client->pos);
+    size_t remaining = header.len - client->offset;
+    if (len < remaining) {
+      client->offset += (uint32_t)len;
+      return;
+    }
+    len -= remaining;
+    client->pos += LOGFAN_HEADER_SIZE + header.len;
+    client->seq++;
+    client->offset = 0;
+  }
+  // skip empty lines so the cursor never rests on one
+  while (client->pos != fan->head && _header(fan, client->pos).len == 0) {
+    client->pos += LOGFAN_HEADER_SIZE;
+    client->seq++;
+  }
+}
+
+uint32_t logfan_skipped(struct logfan *fan, int id) {
+  struct logfan_client *client = _client(fan, id);
+  uint32_t skipped = client->skipped;
+  client->skipped = 0;
+  return skipped;
+}
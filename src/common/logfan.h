@@ -0,0 +1,137 @@
+/**
+ * @file logfan.h
+ * @brief Shared ring of formatted log lines with per-client read cursors
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __LOGFAN_H__
+#define __LOGFAN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOGFAN_MAX_CLIENTS 4
+
+/**
+ * @brief Client read cursor. Positions and sequence numbers are free running.
+ */
+struct logfan_client {
+  bool active;
+  uint32_t pos;     // ring position of the next line
+  uint32_t offset;  // bytes of the next line already consumed
+  uint32_t seq;     // sequence number of the next line
+  uint32_t bytes;   // line bytes consumed
+  uint32_t skipped; // lines overwritten before the client read them
+  bool torn;        // a partially consumed line was overwritten and still needs terminating
+};
+
+/**
+ * @brief Line ring. Only accessed from the logger task so no synchronization is needed.
+ */
+struct logfan {
+  uint8_t *buffer;  // line storage
+  uint32_t size;    // storage size in bytes (power of two)
+  uint32_t head;    // next line position
+  uint32_t tail;    // oldest retained line position
+  uint32_t head_seq;
+  uint32_t tail_seq;
+  uint32_t head_bytes; // line bytes appended
+  uint32_t tail_bytes; // line bytes overwritten
+  struct logfan_client clients[LOGFAN_MAX_CLIENTS];
+};
+
+/**
+ * @brief Initialize an empty ring without clients
+ *
+ * @param[out] fan ring
+ * @param[in] buffer line storage
+ * @param[in] size storage size in bytes (power of two)
+ */
+void logfan_init(struct logfan *fan, void *buffer, size_t size);
+
+/**
+ * @brief Attach a client. New clients start at the oldest retained line so they receive the
+ * recent history.
+ *
+ * @param[in] fan ring
+ * @return client id or -1 if all client slots are in use
+ */
+int logfan_attach(struct logfan *fan);
+
+/**
+ * @brief Detach a client and free its slot
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ */
+void logfan_detach(struct logfan *fan, int id);
+
+/**
+ * @brief Append a line, overwriting the oldest lines if needed. Clients never hold back the
+ * writer: a client whose unread lines are overwritten skips ahead and counts the lost lines. A
+ * client that was part way through a line is sent a newline before the next line so the torn
+ * line does not run into it. Lines longer than the ring are truncated.
+ *
+ * @param[in] fan ring
+ * @param[in] line line data
+ * @param[in] len line length (bytes)
+ * @param[in] now current time (ms)
+ */
+void logfan_append(struct logfan *fan, const char *line, size_t len, uint32_t now);
+
+/**
+ * @brief Number of line bytes the client has not consumed
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ * @return pending bytes
+ */
+size_t logfan_pending(struct logfan *fan, int id);
+
+/**
+ * @brief Age of the oldest line the client has not consumed
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ * @param[in] now current time (ms)
+ * @return age (ms) or 0 if nothing is pending
+ */
+uint32_t logfan_age(struct logfan *fan, int id, uint32_t now);
+
+/**
+ * @brief Copy pending line bytes for the client without consuming them. Only whole lines are
+ * copied, apart from the remainder of a partially consumed line or a single line larger than the
+ * destination, so a client that always consumes everything it peeks gets line aligned chunks.
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ * @param[out] data destination
+ * @param[in] size destination size (bytes)
+ * @return copied bytes
+ */
+size_t logfan_peek(struct logfan *fan, int id, void *data, size_t size);
+
+/**
+ * @brief Consume line bytes after they were sent
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ * @param[in] len bytes to consume (at most the pending bytes)
+ */
+void logfan_advance(struct logfan *fan, int id, size_t len);
+
+/**
+ * @brief Get and clear the number of lines the client skipped because it fell behind
+ *
+ * @param[in] fan ring
+ * @param[in] id client id
+ * @return skipped lines
+ */
+uint32_t logfan_skipped(struct logfan *fan, int id);
+
+#endif // __LOGFAN_H__
@@ -0,0 +1,127 @@
+/**
+ * @file logfmt.c
+ * @brief Deferred log argument capture and formatting
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "logfmt.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOGFMT_MAX_SPEC_LEN 16
+
+struct output {
+  char *buffer;
+  size_t size;
+  size_t len;
+};
+
+static void _putc(struct output *out, char c) {
+  if (out->len + 1 < out->size) {
+    out->buffer[out->len++] = c;
+  }
+}
+
+/**
+ * @brief Append a single conversion formatted by snprintf
+ */
+static void _convert(struct output *out, const char *spec, char conversion, logfmt_arg_t arg) {
+  if (out->len + 1 >= out->size) {
+    return;
+  }
+  char *dest = out->buffer + out->len;
+  size_t avail = out->size - out->len;
+  int written;
+  switch (conversion) {
+    case 'd':
+    case 'i':
+      written = snprintf(dest, avail, spec, (long)(intptr_t)arg);
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      written = snprintf(dest, avail, spec, (unsigned long)arg);
+      break;
+    case 'c':
+      written = snprintf(dest, avail, spec, (int)arg);
+      break;
+    case 's':
+      written = snprintf(dest, avail, spec, arg ? (const char *)arg : "(null)");
+      break;
+    case 'p':
+      written = snprintf(dest, avail, spec, (void *)arg);
+      break;
+    default: {
+      // floating point: argument holds float bits
+      union {
+        uint32_t u32;
+        float f32;
+      } bits = {.u32 = (uint32_t)arg};
+      written = snprintf(dest, avail, spec, (double)bits.f32);
+      break;
+    }
+  }
+  if (written > 0) {
+    out->len += (size_t)written < avail ? (size_t)written : avail - 1;
+  }
+}
+
+size_t logfmt_format(char *buffer, size_t size, const char *fmt, const logfmt_arg_t *args, uint8_t nargs) {
+  struct output out = {.buffer = buffer, .size = size, .len = 0};
+  uint8_t next = 0;
+  if (size == 0) {
+    return 0;
+  }
+  while (*fmt) {
+    if (*fmt != '%') {
+      _putc(&out, *fmt++);
+      continue;
+    }
+    const char *start = fmt++;
+    if (*fmt == '%') {
+      _putc(&out, *fmt++);
+      continue;
+    }
+    // rebuild the conversion without length modifiers: %[flags][width][.precision]
+    char spec[LOGFMT_MAX_SPEC_LEN];
+    size_t spec_len = 0;
+    bool overflow = false;
+    spec[spec_len++] = '%';
+    while (*fmt && (strchr("-+ #0", *fmt) || (*fmt >= '0' && *fmt <= '9') || *fmt == '.')) {
+      if (spec_len < LOGFMT_MAX_SPEC_LEN - 3) {
+        spec[spec_len++] = *fmt;
+      } else {
+        overflow = true;
+      }
+      fmt++;
+    }
+    while (*fmt && strchr("hljztL", *fmt)) {
+      fmt++;
+    }
+    char conversion = *fmt;
+    if (conversion == '\0' || !strchr("diuoxXcspfFeEgGaA", conversion) || overflow || next >= nargs) {
+      // emit unsupported or unmatched conversions verbatim
+      const char *end = conversion ? fmt + 1 : fmt;
+      while (start < end) {
+        _putc(&out, *start++);
+      }
+      fmt = end;
+      continue;
+    }
+    fmt++;
+    if (strchr("diuoxX", conversion)) {
+      spec[spec_len++] = 'l';
+    }
+    spec[spec_len++] = conversion;
+    spec[spec_len] = '\0';
+    _convert(&out, spec, conversion, args[next++]);
+  }
+  out.buffer[out.len] = '\0';
+  return out.len;
+}
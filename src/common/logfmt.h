@@ -0,0 +1,96 @@
+/**
+ * @file logfmt.h
+ * @brief Deferred log argument capture and formatting
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __LOGFMT_H__
+#define __LOGFMT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LOGFMT_MAX_ARGS 8
+
+/**
+ * @brief Raw log argument word. Integers and pointers are stored as is (truncated to the word
+ * size), floating point arguments as the bits of a float.
+ */
+typedef uintptr_t logfmt_arg_t;
+
+static inline logfmt_arg_t logfmt_arg_int(long long value) {
+  return (logfmt_arg_t)value;
+}
+
+static inline logfmt_arg_t logfmt_arg_ptr(const void *value) {
+  return (logfmt_arg_t)value;
+}
+
+static inline logfmt_arg_t logfmt_arg_float(double value) {
+  union {
+    float f32;
+    uint32_t u32;
+  } bits;
+  bits.f32 = (float)value;
+  return bits.u32;
+}
+
+/**
+ * @brief Capture a printf argument as a raw argument word
+ */
+#define LOGFMT_ARG(x)              \
+  _Generic((x),                    \
+      float: logfmt_arg_float,     \
+      double: logfmt_arg_float,    \
+      char *: logfmt_arg_ptr,      \
+      const char *: logfmt_arg_ptr, \
+      void *: logfmt_arg_ptr,      \
+      const void *: logfmt_arg_ptr, \
+      default: logfmt_arg_int)(x)
+
+// clang-format off
+#define __LOGFMT_NARGS(...) __LOGFMT_NARGS_N(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __LOGFMT_NARGS_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, N, ...) N
+#define __LOGFMT_CAT(a, b) __LOGFMT_CAT_(a, b)
+#define __LOGFMT_CAT_(a, b) a##b
+#define __LOGFMT_MAP_1(a) LOGFMT_ARG(a)
+#define __LOGFMT_MAP_2(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_1(__VA_ARGS__)
+#define __LOGFMT_MAP_3(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_2(__VA_ARGS__)
+#define __LOGFMT_MAP_4(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_3(__VA_ARGS__)
+#define __LOGFMT_MAP_5(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_4(__VA_ARGS__)
+#define __LOGFMT_MAP_6(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_5(__VA_ARGS__)
+#define __LOGFMT_MAP_7(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_6(__VA_ARGS__)
+#define __LOGFMT_MAP_8(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_7(__VA_ARGS__)
+#define __LOGFMT_MAP_9(a, ...) LOGFMT_ARG(a), __LOGFMT_MAP_8(__VA_ARGS__)
+// clang-format on
+
+/**
+ * @brief Number of arguments in a list terminated by a trailing "" (the terminator is not counted)
+ */
+#define LOGFMT_NARGS(...) (__LOGFMT_NARGS(__VA_ARGS__) - 1)
+
+/**
+ * @brief Expand a list of printf arguments terminated by a trailing "" to an initializer of
+ * argument words. The terminator is captured as well so the list is never empty.
+ */
+#define LOGFMT_ARGS(...) __LOGFMT_CAT(__LOGFMT_MAP_, __LOGFMT_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+/**
+ * @brief Format a printf style format string against captured argument words. Length modifiers
+ * are ignored since every argument is a word; `%s` arguments must point to static strings as they
+ * are dereferenced after the call site returns.
+ *
+ * @param[out] buffer output buffer (always null terminated)
+ * @param[in] size output buffer size
+ * @param[in] fmt format string
+ * @param[in] args argument words
+ * @param[in] nargs number of argument words
+ * @return number of characters written (excluding the null terminator)
+ */
+size_t logfmt_format(char *buffer, size_t size, const char *fmt, const logfmt_arg_t *args, uint8_t nargs);
+
+#endif // __LOGFMT_H__
@@ -8,33 +8,94 @@
  *
  */
 
+#define LOG_MODULE LOGGER_MODULE_LOGGER
+
 #include "common.h"
 #include "uassert.h"
 #include "logger.h"
+#include "logfan.h"
+#include "timebase.h"
 #include "lwip/inet.h"
+#include "lwip/opt.h"
 #include "lwip/sockets.h"
+#include <stm32h7xx_hal.h>
 
-#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <string.h>
 
-#define MAX_LOG_HEADER_LEN 21
+#define MAX_LOG_HEADER_LEN 25
 #define MAX_LOG_OUT_LEN 270
-#define MAX_LOG_MESSAGE_LEN (MAX_LOG_OUT_LEN - MAX_LOG_HEADER_LEN)
-#define MAX_LOG_BUFFER_SIZE 3
-#define LOG_HEADER_FMT "[ %9ld %5s ]\t"
+#define MAX_LOG_RING_SIZE 2048
+#define MAX_LOG_ISR_RING_SIZE 256
+#define LOG_ISR_CONTEXTS (1u << __NVIC_PRIO_BITS)
+#define MAX_LOG_FAN_SIZE 8192
+#define LOG_POLL_PERIOD_MS 10
+#define LOG_FLUSH_LATENCY_MS 20
+#define LOG_DRAIN_BATCH 32
+#define LOG_HEADER_FMT "[ %6lu.%06lu %5s ]\t"
+#define LOG_DROP_FMT "logger dropped %u critical, %u error, %u warning, %u info, %u trace records\n"
+#define LOG_SKIP_FMT "log client %d fell behind and skipped %u lines\n"
 
 
 /**
- * @brief Log message struct.
+ * @brief Deferred log record. Only the format string pointer and the used argument words are
+ * written to the log ring; formatting happens in the logger task. The timestamp (timebase ticks)
+ * must stay the first member: the logger task merges the task and ISR rings by it.
  *
  */
-struct log_msg {
-  uint32_t epoch;
-  enum logger_level level;
-  char message[MAX_LOG_MESSAGE_LEN];
+struct log_record {
+  uint64_t timestamp;
+  const char *fmt;
+  uint8_t level;
+  uint8_t nargs;
+  logfmt_arg_t args[LOGFMT_MAX_ARGS];
 };
 
-static struct logger_context ctx = {0};
+// records logged before the logger task starts are buffered until a client connects
+static uint8_t log_ring_buffer[MAX_LOG_RING_SIZE] __attribute__((aligned(4)));
+static struct logger_context ctx = {.ring = LOGRING_STATIC_INIT(log_ring_buffer)};
+// one single producer ring per NVIC priority level: interrupts at the same priority never
+// preempt each other so ISR logging needs no compare and swap
+static uint8_t log_isr_buffers[LOG_ISR_CONTEXTS][MAX_LOG_ISR_RING_SIZE] __attribute__((aligned(4)));
+#define LOG_ISR_RING(n) LOGRING_STATIC_INIT(log_isr_buffers[n])
+_Static_assert(LOG_ISR_CONTEXTS == 16, "expected one ISR log ring initializer per priority level");
+// the listener, every client, a full accept backlog and the UDP stream each hold a socket
+_Static_assert(MEMP_NUM_NETCONN >= 2 * LOGFAN_MAX_CLIENTS + 2, "lwIP netconn pool too small for the log server");
+_Static_assert(MEMP_NUM_TCP_PCB >= 2 * LOGFAN_MAX_CLIENTS, "lwIP TCP pcb pool too small for the log clients");
+static struct logring log_isr_rings[LOG_ISR_CONTEXTS] = {
+  LOG_ISR_RING(0),  LOG_ISR_RING(1),  LOG_ISR_RING(2),  LOG_ISR_RING(3),
+  LOG_ISR_RING(4),  LOG_ISR_RING(5),  LOG_ISR_RING(6),  LOG_ISR_RING(7),
+  LOG_ISR_RING(8),  LOG_ISR_RING(9),  LOG_ISR_RING(10), LOG_ISR_RING(11),
+  LOG_ISR_RING(12), LOG_ISR_RING(13), LOG_ISR_RING(14), LOG_ISR_RING(15),
+};
+/**
+ * @brief Log subscriber: a TCP connection or the UDP destination
+ *
+ */
+struct log_client {
+  int fd;                  // -1 when the slot is free
+  bool datagram;           // send with sendto to dest
+  struct sockaddr_in dest; // datagram destination (unicast or multicast group)
+};
+
+// formatted lines shared by all clients, each reading with its own cursor
+static uint8_t log_fan_buffer[MAX_LOG_FAN_SIZE];
+static struct logfan log_fan;
+static struct log_client log_clients[LOGFAN_MAX_CLIENTS];
+// one TCP segment or datagram worth of lines
+static char log_send_buffer[TCP_MSS];
+// levels are read before the logger starts so every module is initialised statically
+uint8_t logger_levels[LOGGER_MODULE_COUNT] = {
+  [LOGGER_MODULE_SYSTEM] = LOGGER_DEFAULT_LEVEL,
+  [LOGGER_MODULE_HSM] = LOGGER_DEFAULT_LEVEL,
+  [LOGGER_MODULE_LOGGER] = LOGGER_DEFAULT_LEVEL,
+  [LOGGER_MODULE_ETHERNET] = LOGGER_DEFAULT_LEVEL,
+  [LOGGER_MODULE_DRIVERS] = LOGGER_DEFAULT_LEVEL,
+};
+_Static_assert(LOGGER_MODULE_COUNT == 5, "initialise the level of every logger module");
+// records dropped on a full ring per level, reported in-band once the ring drains
+static atomic_uint_fast32_t log_drops[LOGGER_DISABLE];
 
 /**
  * @brief Get logger level string from enum
@@ -58,17 +119,122 @@ static const char *_get_level_str(const enum logger_level level) {
 }
 
 /**
- * @brief Construct log string message from log struct. This method builds the log header and
- * combines the formatted log message with the header.
+ * @brief Construct log string message from a log record and append it to the line ring shared by
+ * all clients. This method builds the log header and formats the deferred log message after the
+ * header.
+ *
+ * @param[in] log log record
+ */
+static void append_log(const struct log_record *log) {
+  char buffer[MAX_LOG_OUT_LEN];
+  const uint64_t us = timebase_to_us(log->timestamp);
+  int offset = snprintf(buffer, MAX_LOG_HEADER_LEN, LOG_HEADER_FMT, (unsigned long)(us / 1000000u), (unsigned long)(us % 1000000u), _get_level_str((enum logger_level)log->level));
+  offset = min(offset, MAX_LOG_HEADER_LEN - 1);
+  size_t len = (size_t)offset + logfmt_format(&buffer[offset], sizeof(buffer) - (size_t)offset, log->fmt, log->args, log->nargs);
+  logfan_append(&log_fan, buffer, len, HAL_GetTick());
+}
+
+/**
+ * @brief Append a record reporting the records dropped since the last report, if any
  *
- * @param[in] client_fd client socket descriptor
- * @param[in] log log entry
  */
-static int write_log(const int client_sd, const struct log_msg *log) {
-  char buffer[MAX_LOG_OUT_LEN] = {0};
-  int offset = snprintf(buffer, MAX_LOG_HEADER_LEN, LOG_HEADER_FMT, (long)log->epoch, _get_level_str(log->level));
-  memcpy(&buffer[offset], log->message, min(strlen(log->message), (size_t)(MAX_LOG_MESSAGE_LEN - offset - 1)));
-  return write(client_sd, buffer, strlen(buffer));
+static void append_drops(void) {
+  struct log_record log = {.timestamp = timebase_now(), .fmt = LOG_DROP_FMT, .level = LOGGER_WARNING, .nargs = 5};
+  uint32_t dropped = 0;
+  for (int level = LOGGER_TRACE; level < LOGGER_DISABLE; level++) {
+    uint32_t count = (uint32_t)atomic_exchange_explicit(&log_drops[level], 0, memory_order_relaxed);
+    // report in descending severity order to match the format
+    log.args[LOGGER_CRITICAL - level] = count;
+    dropped += count;
+  }
+  if (dropped != 0) {
+    append_log(&log);
+  }
+}
+
+/**
+ * @brief Attach a client socket to the line ring
+ *
+ * @param[in] fd client socket descriptor
+ * @param[in] dest datagram destination or NULL for a TCP client
+ * @return client id or -1 if all client slots are in use
+ */
+static int open_client(const int fd, const struct sockaddr_in *dest) {
+  int id = logfan_attach(&log_fan);
+  if (id < 0) {
+    return -1;
+  }
+  // a slow client must never block the logger task
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  log_clients[id].fd = fd;
+  log_clients[id].datagram = dest != NULL;
+  if (dest != NULL) {
+    log_clients[id].dest = *dest;
+  }
+  return id;
+}
+
+/**
+ * @brief Close a client socket and free its slot
+ *
+ * @param[in] id client id
+ */
+static void close_client(const int id) {
+  close(log_clients[id].fd);
+  log_clients[id].fd = -1;
+  logfan_detach(&log_fan, id);
+}
+
+/**
+ * @brief Accept pending TCP connections on the (non blocking) listening socket
+ *
+ * @param[in] sock listening socket descriptor
+ */
+static void accept_clients(const int sock) {
+  int client_fd;
+  while ((client_fd = accept(sock, NULL, NULL)) >= 0) {
+    if (open_client(client_fd, NULL) < 0) {
+      close(client_fd);
+    }
+  }
+}
+
+/**
+ * @brief Send the client's pending lines in segment sized chunks. A partial chunk is only sent
+ * once its oldest line reaches the flush latency bound.
+ *
+ * @param[in] id client id
+ * @return time until the client needs servicing again (ms)
+ */
+static uint32_t service_client(const int id) {
+  struct log_client *client = &log_clients[id];
+  while (1) {
+    size_t pending = logfan_pending(&log_fan, id);
+    uint32_t age = logfan_age(&log_fan, id, HAL_GetTick());
+    if (pending == 0) {
+      return LOG_POLL_PERIOD_MS;
+    }
+    if (pending < sizeof(log_send_buffer) && age < LOG_FLUSH_LATENCY_MS) {
+      return LOG_FLUSH_LATENCY_MS - age;
+    }
+    size_t len = logfan_peek(&log_fan, id, log_send_buffer, sizeof(log_send_buffer));
+    int sent;
+    if (client->datagram) {
+      sent = sendto(client->fd, log_send_buffer, len, MSG_DONTWAIT, (struct sockaddr *)&client->dest, sizeof(client->dest));
+    } else {
+      sent = send(client->fd, log_send_buffer, len, MSG_DONTWAIT);
+    }
+    if (sent < 0) {
+      if (client->datagram) {
+        // connectionless: drop the datagram rather than stall, retry with the next one later
+        logfan_advance(&log_fan, id, len);
+      } else if (errno != EWOULDBLOCK && errno != EAGAIN) {
+        close_client(id);
+      }
+      return LOG_POLL_PERIOD_MS;
+    }
+    logfan_advance(&log_fan, id, (size_t)sent);
+  }
 }
 
 /**
@@ -77,10 +243,14 @@ static int write_log(const int client_sd, const struct log_msg *log) {
  * @param[in] argument task argument (unused)
  */
 static void log_server_task(void* __attribute__((unused)) argument) {
-  int sock, size, client_fd;
-  struct sockaddr_in address, remotehost;
+  int sock;
+  struct sockaddr_in address;
   uassert(ctx.init != NULL);
   logger_set_level(ctx.init->log_level);
+  logfan_init(&log_fan, log_fan_buffer, sizeof(log_fan_buffer));
+  for (int id = 0; id < LOGFAN_MAX_CLIENTS; id++) {
+    log_clients[id].fd = -1;
+  }
   if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
     goto error;
   }
@@ -90,22 +260,53 @@ static void log_server_task(void* __attribute__((unused)) argument) {
   if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
     goto error;
   }
-  listen(sock, 5);
+  listen(sock, LOGFAN_MAX_CLIENTS);
+  // connections are polled alongside the log rings
+  fcntl(sock, F_SETFL, O_NONBLOCK);
+  if (ctx.init->udp_port != 0) {
+    struct sockaddr_in dest = {
+      .sin_family = AF_INET,
+      .sin_port = htons(ctx.init->udp_port),
+      .sin_addr.s_addr = htonl(ctx.init->udp_addr),
+    };
+    int udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_fd < 0) {
+      goto error;
+    }
+    open_client(udp_fd, &dest);
+  }
+  // task ring first so it wins timestamp ties
+  struct logring *streams[1 + LOG_ISR_CONTEXTS] = {&ctx.ring};
+  for (size_t i = 0; i < LOG_ISR_CONTEXTS; i++) {
+    streams[1 + i] = &log_isr_rings[i];
+  }
   while (1) {
-    client_fd = accept(sock, (struct sockaddr *)&remotehost, (socklen_t *)&size);
-    if (client_fd < 0) {
-      taskYIELD();
-      continue;
+    accept_clients(sock);
+    // format each record once for all clients; bounded so clients are serviced during floods
+    struct log_record log;
+    int drained = 0;
+    while (drained < LOG_DRAIN_BATCH && logring_read_merged(streams, 1 + LOG_ISR_CONTEXTS, &log, sizeof(log)) != 0) {
+      append_log(&log);
+      drained++;
     }
-    while (1) {
-      struct log_msg log = {0};
-      if (xQueueReceive(ctx.log_queue, &log, portMAX_DELAY) == pdPASS) {
-        if (write_log(client_fd, &log) <= 0) {
-          close(client_fd);
-          break;
+    // report drops now that there is space again
+    append_drops();
+    uint32_t timeout = drained == LOG_DRAIN_BATCH ? 0 : LOG_POLL_PERIOD_MS;
+    for (int id = 0; id < LOGFAN_MAX_CLIENTS; id++) {
+      if (log_clients[id].fd < 0) {
+        continue;
+      }
+      uint32_t deadline = service_client(id);
+      timeout = min(timeout, deadline);
+      if (log_clients[id].fd >= 0) {
+        uint32_t skipped = logfan_skipped(&log_fan, id);
+        if (skipped != 0) {
+          warning(LOG_SKIP_FMT, id, skipped);
         }
-      };
+      }
     }
+    // ISR producers and new connections never notify, they are picked up by the poll period
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout));
   }
 error:
   critical("Socket init failed with %i", errno);
@@ -113,12 +314,15 @@ error:
 }
 
 /**
- * @brief Set the program log level.
+ * @brief Set the program log level. Applies to every module.
  *
  * @param[in] level target logging level
  */
 void logger_set_level(const enum logger_level level) {
   ctx.log_level = level;
+  for (int module = 0; module < LOGGER_MODULE_COUNT; module++) {
+    logger_set_module_level((enum logger_module)module, level);
+  }
 }
 
 /**
@@ -131,25 +335,72 @@ enum logger_level logger_get_level(void) {
 }
 
 /**
- * @brief Write logging message to buffer.
+ * @brief Set the log level of a single module.
+ *
+ * @param[in] module log module
+ * @param[in] level target logging level
+ */
+void logger_set_module_level(const enum logger_module module, const enum logger_level level) {
+  uassert(module < LOGGER_MODULE_COUNT);
+  __atomic_store_n(&logger_levels[module], (uint8_t)level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the log level of a single module.
  *
- * @param[in] level log level enum
- * @param[in] fmt log string formatter
- * @param[in] ... variable arguments for string formatter
+ * @param[in] module log module
+ * @return enum Level
  */
-void logger_out(const enum logger_level level, const char *fmt, ...) {
-  va_list args;
-  struct log_msg log = {0};
-  if (logger_get_level() > level) {
+enum logger_level logger_get_module_level(const enum logger_module module) {
+  uassert(module < LOGGER_MODULE_COUNT);
+  return (enum logger_level)__atomic_load_n(&logger_levels[module], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the ISR log ring of the active exception
+ *
+ * @param[in] ipsr active exception number
+ * @return ring or NULL if the exception may not log
+ */
+static struct logring *_isr_ring(const uint32_t ipsr) {
+  // NMI and HardFault have fixed priorities above every configurable one and may preempt any ISR
+  if (ipsr < 4) {
+    return NULL;
+  }
+  return &log_isr_rings[NVIC_GetPriority((IRQn_Type)((int32_t)ipsr - 16)) & (LOG_ISR_CONTEXTS - 1)];
+}
+
+void logger_write(const enum logger_level level, const char *fmt, const logfmt_arg_t *args, const uint8_t nargs) {
+  // pick the ring before taking the timestamp: NMI and HardFault may not read the timebase
+  const uint32_t ipsr = __get_IPSR();
+  struct logring *isr_ring = NULL;
+  if (ipsr != 0) {
+    isr_ring = _isr_ring(ipsr);
+    if (isr_ring == NULL) {
+      atomic_fetch_add_explicit(&log_drops[level], 1, memory_order_relaxed);
+      return;
+    }
+  }
+  struct log_record log = {
+    .timestamp = timebase_now(),
+    .fmt = fmt,
+    .level = (uint8_t)level,
+    .nargs = nargs > LOGFMT_MAX_ARGS ? LOGFMT_MAX_ARGS : nargs,
+  };
+  memcpy(log.args, args, log.nargs * sizeof(logfmt_arg_t));
+  const size_t len = offsetof(struct log_record, args) + log.nargs * sizeof(logfmt_arg_t);
+  if (isr_ring != NULL) {
+    // interrupt context: wait-free and no kernel calls, so any priority may log
+    if (logring_write_single(isr_ring, &log, len) == LOGRING_FULL) {
+      atomic_fetch_add_explicit(&log_drops[level], 1, memory_order_relaxed);
+    }
     return;
   }
-  log.epoch = xTaskGetTickCount();
-  log.level = level;
-  va_start(args, fmt);
-  vsnprintf(log.message, MAX_LOG_MESSAGE_LEN - 1, fmt, args);
-  va_end(args);
-  if (ctx.log_queue != NULL) {
-    xQueueSend(ctx.log_queue, &log, 0);
+  logring_status_t status = logring_write(&ctx.ring, &log, len);
+  if (status == LOGRING_FULL) {
+    atomic_fetch_add_explicit(&log_drops[level], 1, memory_order_relaxed);
+  } else if (status == LOGRING_WAKE && ctx.task_handle != NULL) {
+    xTaskNotifyGive(ctx.task_handle);
   }
 }
 
@@ -160,9 +411,7 @@ void logger_start(const struct system_task_context *task_ctx) {
 
   // populate context
   ctx.init = task_ctx->init_ctx;
-  ctx.log_queue = xQueueCreate(MAX_LOG_BUFFER_SIZE, sizeof(struct log_msg));
-  uassert(ctx.log_queue != NULL);
-  
+
   // start logger task
   BaseType_t ret = xTaskCreate(log_server_task, task_ctx->name, task_ctx->stack_size, NULL, task_ctx->priority, &ctx.task_handle);
   uassert(ret == pdPASS);
@@ -11,13 +11,18 @@
 #ifndef __LOGGER_H__
 #define __LOGGER_H__
 
+#include "logfmt.h"
+#include "logring.h"
 #include "system.h"
 #include <FreeRTOS.h>
 #include <queue.h>
 #include <task.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #define LOGGER_DEFAULT_PORT 3000
+#define LOGGER_DEFAULT_UDP_ADDR 0xEF000001 // 239.0.0.1 multicast group
+#define LOGGER_DEFAULT_UDP_PORT 3001
 #define LOGGER_DEFAULT_LEVEL (enum logger_level)1
 
 enum logger_level {
@@ -29,46 +34,136 @@ enum logger_level {
   LOGGER_DISABLE
 };
 
+/**
+ * @brief Compile time floor: log calls below this level compile to nothing, so neither their
+ * format strings nor their argument evaluation end up in the image. Numeric (enum logger_level
+ * value) so the build can set it, e.g. -DLOGGER_COMPILE_LEVEL=1 strips trace calls.
+ */
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL 0
+#endif
+
+/**
+ * @brief Log modules with independent runtime levels. A source file selects its module by
+ * defining LOG_MODULE before including this header.
+ */
+enum logger_module {
+  LOGGER_MODULE_SYSTEM,
+  LOGGER_MODULE_HSM,
+  LOGGER_MODULE_LOGGER,
+  LOGGER_MODULE_ETHERNET,
+  LOGGER_MODULE_DRIVERS,
+  LOGGER_MODULE_COUNT
+};
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOGGER_MODULE_SYSTEM
+#endif
+
 struct logger_init_context {
   const enum logger_level log_level;
-  const uint16_t port;
+  const uint16_t port;      // TCP server port
+  const uint32_t udp_addr;  // UDP destination address (unicast or multicast group, host order)
+  const uint16_t udp_port;  // UDP destination port (0 disables UDP streaming)
 };
 
 struct logger_context {
   const struct logger_init_context *init;
   enum logger_level log_level;
   TaskHandle_t task_handle;
-  QueueHandle_t log_queue;
+  struct logring ring;
 };
 
+// runtime level per module (enum logger_level values); use logger_set_module_level to change
+extern uint8_t logger_levels[LOGGER_MODULE_COUNT];
+
 enum logger_level logger_get_level(void);
 void logger_set_level(const enum logger_level level);
-void logger_out(const enum logger_level level, const char *fmt, ...);
+enum logger_level logger_get_module_level(const enum logger_module module);
+void logger_set_module_level(const enum logger_module module, const enum logger_level level);
 void logger_start(const struct system_task_context *task_ctx);
 
+/**
+ * @brief Check a module's runtime level. Inlined into the level macros so a filtered call costs a
+ * load and a compare and never evaluates its arguments.
+ *
+ * @param[in] module log module
+ * @param[in] level log level
+ * @return true if records at this level are logged for the module
+ */
+static inline bool logger_enabled(const enum logger_module module, const enum logger_level level) {
+  return (uint8_t)level >= __atomic_load_n(&logger_levels[module], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Enqueue a deferred log record. The format string and raw argument words are copied into
+ * the log queue and formatted by the logger task, so the caller never runs printf. Levels are not
+ * checked here: prefer the level macros which filter by module level and capture the arguments.
+ *
+ * @param[in] level log level
+ * @param[in] fmt format string (must outlive the record, i.e. a string literal)
+ * @param[in] args argument words
+ * @param[in] nargs number of argument words (at most LOGFMT_MAX_ARGS)
+ */
+void logger_write(const enum logger_level level, const char *fmt, const logfmt_arg_t *args, const uint8_t nargs);
+
+// the trailing "" appended by the level macros keeps the argument list non-empty
+#define __LOGGER_WRITE(level, fmt, ...)                                       \
+  do {                                                                        \
+    if (logger_enabled(LOG_MODULE, level)) {                                  \
+      const logfmt_arg_t __log_args[] = {LOGFMT_ARGS(__VA_ARGS__)};           \
+      logger_write(level, fmt, __log_args, (uint8_t)LOGFMT_NARGS(__VA_ARGS__)); \
+    }                                                                         \
+  } while (0)
+
+// calls below the compile time floor
+#define __LOGGER_STRIP() \
+  do {                   \
+  } while (0)
+
 #ifndef critical
+#if LOGGER_COMPILE_LEVEL <= 4
 #define critical(...) __CRITICAL(__VA_ARGS__, "")
-#define __CRITICAL(fmt, ...) logger_out(LOGGER_CRITICAL, fmt, __VA_ARGS__)
+#define __CRITICAL(fmt, ...) __LOGGER_WRITE(LOGGER_CRITICAL, fmt, __VA_ARGS__)
+#else
+#define critical(...) __LOGGER_STRIP()
+#endif
 #endif
 
 #ifndef error
+#if LOGGER_COMPILE_LEVEL <= 3
 #define error(...) __ERROR(__VA_ARGS__, "")
-#define __ERROR(fmt, ...) logger_out(LOGGER_ERROR, fmt, __VA_ARGS__)
+#define __ERROR(fmt, ...) __LOGGER_WRITE(LOGGER_ERROR, fmt, __VA_ARGS__)
+#else
+#define error(...) __LOGGER_STRIP()
+#endif
 #endif
 
 #ifndef warning
+#if LOGGER_COMPILE_LEVEL <= 2
 #define warning(...) __WARNING(__VA_ARGS__, "")
-#define __WARNING(fmt, ...) logger_out(LOGGER_WARNING, fmt, __VA_ARGS__)
+#define __WARNING(fmt, ...) __LOGGER_WRITE(LOGGER_WARNING, fmt, __VA_ARGS__)
+#else
+#define warning(...) __LOGGER_STRIP()
+#endif
 #endif
 
 #ifndef info
+#if LOGGER_COMPILE_LEVEL <= 1
 #define info(...) __INFO(__VA_ARGS__, "")
-#define __INFO(fmt, ...) logger_out(LOGGER_INFO, fmt, __VA_ARGS__)
+#define __INFO(fmt, ...) __LOGGER_WRITE(LOGGER_INFO, fmt, __VA_ARGS__)
+#else
+#define info(...) __LOGGER_STRIP()
+#endif
 #endif
 
 #ifndef trace
+#if LOGGER_COMPILE_LEVEL <= 0
 #define trace(...) __TRACE(__VA_ARGS__, "")
-#define __TRACE(fmt, ...) logger_out(LOGGER_TRACE, fmt, __VA_ARGS__)
+#define __TRACE(fmt, ...) __LOGGER_WRITE(LOGGER_TRACE, fmt, __VA_ARGS__)
+#else
+#define trace(...) __LOGGER_STRIP()
+#endif
 #endif
 
 #endif // __LOGGER_H__
@@ -0,0 +1,180 @@
+/**
+ * @file logring.c
+ * @brief Lock-free multi-producer single-consumer ring of variable length records
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "logring.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Each record is a two word header followed by the payload, padded to a 4 byte boundary:
+ *
+ *  - commit word: `position + 1` once the record is complete
+ *  - length word: payload length
+ *
+ * Producers reserve space by advancing `head` with a compare and swap, copy the length and
+ * payload (wrapping around the end of the buffer if needed) and then publish the commit word with
+ * release semantics. The consumer only reads a record once its commit word matches its position,
+ * and zeroes the record before releasing the space so stale bytes from a previous lap can never
+ * look committed. A producer preempted between reservation and commit holds back the consumer
+ * (but not other producers) until it completes.
+ *
+ * A ring with a single producer can skip the compare and swap (`logring_write_single`), which
+ * makes the write wait-free: a bounded number of steps regardless of other contexts.
+ */
+
+#define LOGRING_HEADER_SIZE (2 * sizeof(uint32_t))
+#define LOGRING_ALIGN(x) (((x) + 3u) & ~3u)
+
+static inline uint32_t *_word(const struct logring *ring, uint32_t pos) {
+  return (uint32_t *)(ring->buffer + (pos & (ring->size - 1)));
+}
+
+static void _copy_in(struct logring *ring, uint32_t pos, const void *data, size_t len) {
+  uint32_t offset = pos & (ring->size - 1);
+  size_t first = ring->size - offset < len ? ring->size - offset : len;
+  memcpy(ring->buffer + offset, data, first);
+  memcpy(ring->buffer, (const uint8_t *)data + first, len - first);
+}
+
+static void _copy_out(const struct logring *ring, uint32_t pos, void *data, size_t len) {
+  uint32_t offset = pos & (ring->size - 1);
+  size_t first = ring->size - offset < len ? ring->size - offset : len;
+  memcpy(data, ring->buffer + offset, first);
+  memcpy((uint8_t *)data + first, ring->buffer, len - first);
+}
+
+static void _zero(struct logring *ring, uint32_t pos, size_t len) {
+  uint32_t offset = pos & (ring->size - 1);
+  size_t first = ring->size - offset < len ? ring->size - offset : len;
+  memset(ring->buffer + offset, 0, first);
+  memset(ring->buffer, 0, len - first);
+}
+
+void logring_init(struct logring *ring, void *buffer, size_t size) {
+  assert(ring && buffer);
+  assert(size >= LOGRING_HEADER_SIZE && (size & (size - 1)) == 0 && size <= UINT32_MAX / 2);
+  assert(((uintptr_t)buffer & 3u) == 0);
+  memset(buffer, 0, size);
+  ring->buffer = buffer;
+  ring->size = (uint32_t)size;
+  __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&ring->tail, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copy the length and payload of a reserved record and publish its commit word
+ */
+static void _commit(struct logring *ring, uint32_t head, const void *data, size_t len) {
+  const uint32_t length = (uint32_t)len;
+  _copy_in(ring, head + sizeof(uint32_t), &length, sizeof(length));
+  _copy_in(ring, head + LOGRING_HEADER_SIZE, data, len);
+  __atomic_store_n(_word(ring, head), head + 1, __ATOMIC_RELEASE);
+}
+
+static inline bool _fits(const struct logring *ring, size_t len) {
+  return len <= LOGRING_MAX_RECORD_LEN && LOGRING_ALIGN(LOGRING_HEADER_SIZE + len) <= ring->size;
+}
+
+logring_status_t logring_write(struct logring *ring, const void *data, size_t len) {
+  assert(ring);
+  if (!_fits(ring, len)) {
+    return LOGRING_SIZE_ERR;
+  }
+  const uint32_t total = LOGRING_ALIGN(LOGRING_HEADER_SIZE + (uint32_t)len);
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  uint32_t tail;
+  do {
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail + total > ring->size) {
+      return LOGRING_FULL;
+    }
+  } while (!__atomic_compare_exchange_n(&ring->head, &head, head + total, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  _commit(ring, head, data, len);
+  return head == tail ? LOGRING_WAKE : LOGRING_OK;
+}
+
+logring_status_t logring_write_single(struct logring *ring, const void *data, size_t len) {
+  assert(ring);
+  if (!_fits(ring, len)) {
+    return LOGRING_SIZE_ERR;
+  }
+  const uint32_t total = LOGRING_ALIGN(LOGRING_HEADER_SIZE + (uint32_t)len);
+  const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  if (head - tail + total > ring->size) {
+    return LOGRING_FULL;
+  }
+  __atomic_store_n(&ring->head, head + total, __ATOMIC_RELAXED);
+  _commit(ring, head, data, len);
+  return head == tail ? LOGRING_WAKE : LOGRING_OK;
+}
+
+/**
+ * @brief Copy out the record at the tail if it is committed
+ *
+ * @return true if a committed record was copied (`length` is its full length)
+ */
+static bool _tail_record(const struct logring *ring, void *data, size_t size, uint32_t *length) {
+  const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  if (ring->size == 0 || __atomic_load_n(_word(ring, tail), __ATOMIC_ACQUIRE) != tail + 1) {
+    return false;
+  }
+  _copy_out(ring, tail + sizeof(uint32_t), length, sizeof(*length));
+  _copy_out(ring, tail + LOGRING_HEADER_SIZE, data, *length < size ? *length : size);
+  return true;
+}
+
+size_t logring_peek(const struct logring *ring, void *data, size_t size) {
+  assert(ring && data);
+  uint32_t length;
+  return _tail_record(ring, data, size, &length) ? length : 0;
+}
+
+size_t logring_read(struct logring *ring, void *data, size_t size) {
+  assert(ring && data);
+  uint32_t length;
+  if (!_tail_record(ring, data, size, &length)) {
+    return 0;
+  }
+  const uint32_t tail = ring->tail;
+  const uint32_t total = LOGRING_ALIGN(LOGRING_HEADER_SIZE + length);
+  _zero(ring, tail, total);
+  __atomic_store_n(&ring->tail, tail + total, __ATOMIC_RELEASE);
+  return length;
+}
+
+size_t logring_read_merged(struct logring *const *rings, size_t count, void *data, size_t size) {
+  assert(rings);
+  struct logring *oldest = NULL;
+  uint64_t oldest_timestamp = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t timestamp;
+    uint32_t length;
+    if (!_tail_record(rings[i], &timestamp, sizeof(timestamp), &length)) {
+      continue;
+    }
+    if (length < sizeof(timestamp)) {
+      // no timestamp to order by: hand it out immediately
+      return logring_read(rings[i], data, size);
+    }
+    // ties go to the earlier ring
+    if (oldest == NULL || timestamp < oldest_timestamp) {
+      oldest = rings[i];
+      oldest_timestamp = timestamp;
+    }
+  }
+  return oldest ? logring_read(oldest, data, size) : 0;
+}
+
+size_t logring_used(const struct logring *ring) {
+  assert(ring);
+  return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file logring.h
+ * @brief Lock-free multi-producer single-consumer ring of variable length records
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __LOGRING_H__
+#define __LOGRING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int logring_status_t;
+
+#define LOGRING_OK (logring_status_t)0
+#define LOGRING_WAKE (logring_status_t)1 // written to an empty ring: the consumer may be idle
+#define LOGRING_FULL (logring_status_t)2
+#define LOGRING_SIZE_ERR (logring_status_t)3
+
+#define LOGRING_MAX_RECORD_LEN 0xFFFF
+
+/**
+ * @brief Ring state. `head` and `tail` are free running byte positions accessed with atomic
+ * builtins so the struct can be shared with C++ test code.
+ */
+struct logring {
+  uint8_t *buffer; // record storage (4 byte aligned)
+  uint32_t size;   // storage size in bytes (power of two)
+  uint32_t head;   // next reservation position (producers)
+  uint32_t tail;   // next record position (consumer)
+};
+
+/**
+ * @brief Static initializer for a ring over a power of two sized array
+ */
+#define LOGRING_STATIC_INIT(_buffer) {.buffer = (_buffer), .size = sizeof(_buffer), .head = 0, .tail = 0}
+
+/**
+ * @brief Initialize a ring
+ *
+ * @param[out] ring ring
+ * @param[in] buffer record storage (4 byte aligned, zero initialized by this call)
+ * @param[in] size storage size in bytes (power of two)
+ */
+void logring_init(struct logring *ring, void *buffer, size_t size);
+
+/**
+ * @brief Copy a record into the ring. Safe to call concurrently from any number of producers
+ * including interrupts; never blocks and never takes a lock. A record is dropped if it does not
+ * fit in the free space.
+ *
+ * @param[in] ring ring
+ * @param[in] data record data
+ * @param[in] len record length (bytes)
+ * @return LOGRING_OK, LOGRING_WAKE if the ring was empty, LOGRING_FULL if the record was dropped
+ */
+logring_status_t logring_write(struct logring *ring, const void *data, size_t len);
+
+/**
+ * @brief Copy a record into a ring that has exactly one producer context, e.g. the interrupts
+ * of a single NVIC priority level which never preempt each other. Wait-free: the reservation is
+ * a plain store rather than a compare and swap loop.
+ *
+ * @param[in] ring ring
+ * @param[in] data record data
+ * @param[in] len record length (bytes)
+ * @return LOGRING_OK, LOGRING_WAKE if the ring was empty, LOGRING_FULL if the record was dropped
+ */
+logring_status_t logring_write_single(struct logring *ring, const void *data, size_t len);
+
+/**
+ * @brief Copy the oldest committed record without consuming it (single consumer)
+ *
+ * @param[in] ring ring
+ * @param[out] data record destination (truncated to size)
+ * @param[in] size destination size (bytes)
+ * @return record length or 0 if no committed record is available
+ */
+size_t logring_peek(const struct logring *ring, void *data, size_t size);
+
+/**
+ * @brief Copy the oldest committed record out of the ring (single consumer). Records longer than
+ * the destination are truncated.
+ *
+ * @param[in] ring ring
+ * @param[out] data record destination
+ * @param[in] size destination size (bytes)
+ * @return record length or 0 if no committed record is available
+ */
+size_t logring_read(struct logring *ring, void *data, size_t size);
+
+/**
+ * @brief Read the committed record with the oldest timestamp across several rings (single
+ * consumer). Every record must start with a monotonic `uint64_t` timestamp; ties are resolved in
+ * ring order. Records still being written by a preempted producer are not waited for.
+ *
+ * @param[in] rings rings to merge
+ * @param[in] count number of rings
+ * @param[out] data record destination
+ * @param[in] size destination size (bytes)
+ * @return record length or 0 if no ring has a committed record
+ */
+size_t logring_read_merged(struct logring *const *rings, size_t count, void *data, size_t size);
+
+/**
+ * @brief Number of bytes currently reserved by producers and not yet consumed
+ *
+ * @param[in] ring ring
+ * @return used bytes
+ */
+size_t logring_used(const struct logring *ring);
+
+#endif // __LOGRING_H__
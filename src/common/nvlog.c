@@ -0,0 +1,294 @@
+/**
+ * @file nvlog.c
+ * @brief Log-structured non-volatile key/value store
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "nvlog.h"
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @brief The log region is a ring of sectors. A chain of sectors starting at a snapshot sector
+ * holds the live log; every other sector is free. Each sector begins with a header record:
+ *
+ *  - snapshot:     NVLOG_KEY_SNAPSHOT, followed by the value of every live key and a commit record
+ *  - continuation: NVLOG_KEY_CONTINUE with the sequence number of the snapshot it extends
+ *
+ * Records are appended in order and a sector is only reused once it leaves the chain. Sectors are
+ * allocated round robin and erased on allocation which spreads erase cycles evenly across the
+ * region. When every sector but the spare is in the chain the log is compacted by writing a new
+ * snapshot into the spare; the old chain is released only once the snapshot commit record is
+ * programmed so a power loss at any point leaves either the old or the new chain intact.
+ *
+ * Every record carries its sector sequence number and a CRC so torn writes and stale contents of
+ * an interrupted erase are rejected on replay.
+ */
+
+#define NVLOG_KEY_SNAPSHOT 0xFFF0
+#define NVLOG_KEY_CONTINUE 0xFFF1
+#define NVLOG_KEY_COMMIT 0xFFF2
+#define NVLOG_SLOT_MAX 32
+
+struct record {
+  uint16_t key;
+  uint16_t reserved;
+  uint32_t value;
+  uint32_t seq;
+  uint32_t crc;
+};
+
+_Static_assert(sizeof(struct record) == 16, "nvlog record must be packed to 16 bytes");
+_Static_assert(sizeof(struct record) <= NVLOG_SLOT_MAX, "nvlog record exceeds slot size");
+
+enum slot_state { SLOT_ERASED, SLOT_VALID, SLOT_INVALID };
+
+static uint32_t _crc32(const void *data, size_t len) {
+  static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                     0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                     0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  const uint8_t *bytes = data;
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc = table[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static inline size_t _sector_addr(const struct nvlog *log, size_t sector) {
+  return sector * log->flash->sector_size;
+}
+
+static inline size_t _next_sector(const struct nvlog *log, size_t sector) {
+  return (sector + 1) % log->flash->num_sectors;
+}
+
+static enum slot_state _read_slot(const struct nvlog *log, size_t addr, struct record *record) {
+  if (log->flash->read(log->flash->ctx, addr, record, sizeof(*record)) != NVLOG_OK) {
+    return SLOT_INVALID;
+  }
+  const uint8_t *bytes = (const uint8_t *)record;
+  size_t erased = 0;
+  while (erased < sizeof(*record) && bytes[erased] == 0xFF) {
+    erased++;
+  }
+  if (erased == sizeof(*record)) {
+    return SLOT_ERASED;
+  }
+  if (record->crc != _crc32(record, offsetof(struct record, crc))) {
+    return SLOT_INVALID;
+  }
+  return SLOT_VALID;
+}
+
+static nvlog_status_t _write_slot(struct nvlog *log, uint16_t key, uint32_t value) {
+  uint8_t slot[NVLOG_SLOT_MAX];
+  struct record record = {.key = key, .reserved = 0xFFFF, .value = value, .seq = log->sector_seq};
+  record.crc = _crc32(&record, offsetof(struct record, crc));
+  memset(slot, 0xFF, log->slot_size);
+  memcpy(slot, &record, sizeof(record));
+  size_t addr = log->write_addr;
+  log->write_addr += log->slot_size;
+  if (log->flash->program(log->flash->ctx, addr, slot, log->slot_size) != NVLOG_OK) {
+    return NVLOG_FLASH_ERR;
+  }
+  return NVLOG_OK;
+}
+
+static inline bool _sector_full(const struct nvlog *log) {
+  return log->write_addr + log->slot_size > _sector_addr(log, log->active) + log->flash->sector_size;
+}
+
+/**
+ * @brief Erase a sector and write its header record making it the active sector
+ */
+static nvlog_status_t _open_sector(struct nvlog *log, size_t sector, uint16_t key, uint32_t value) {
+  if (log->flash->erase(log->flash->ctx, sector) != NVLOG_OK) {
+    return NVLOG_FLASH_ERR;
+  }
+  log->active = sector;
+  log->sector_seq = ++log->max_seq;
+  log->write_addr = _sector_addr(log, sector);
+  return _write_slot(log, key, value);
+}
+
+/**
+ * @brief Write a snapshot of every live key into the spare sector and commit it as the new base
+ */
+static nvlog_status_t _compact(struct nvlog *log) {
+  nvlog_status_t status = _open_sector(log, _next_sector(log, log->active), NVLOG_KEY_SNAPSHOT, 0);
+  if (status != NVLOG_OK) {
+    return status;
+  }
+  log->compacting = true;
+  status = log->snapshot(log, log->arg);
+  log->compacting = false;
+  if (status != NVLOG_OK) {
+    return status;
+  }
+  if (_sector_full(log)) {
+    return NVLOG_FULL_ERR;
+  }
+  status = _write_slot(log, NVLOG_KEY_COMMIT, 0);
+  if (status != NVLOG_OK) {
+    return status;
+  }
+  log->base = log->active;
+  log->base_seq = log->sector_seq;
+  log->chain = 1;
+  log->compactions++;
+  return NVLOG_OK;
+}
+
+/**
+ * @brief Move to the next sector once the active sector is full, compacting if the chain is at
+ * its limit
+ */
+static nvlog_status_t _advance(struct nvlog *log) {
+  if (log->chain >= log->flash->num_sectors - 1) {
+    nvlog_status_t status = _compact(log);
+    if (status != NVLOG_OK || !_sector_full(log)) {
+      return status;
+    }
+    // the snapshot filled its sector
+    if (log->chain >= log->flash->num_sectors - 1) {
+      return NVLOG_FULL_ERR;
+    }
+  }
+  log->chain++;
+  return _open_sector(log, _next_sector(log, log->active), NVLOG_KEY_CONTINUE, log->base_seq);
+}
+
+/**
+ * @brief Find the first free slot in the active sector
+ */
+static void _seek(struct nvlog *log) {
+  struct record record;
+  size_t end = _sector_addr(log, log->active) + log->flash->sector_size;
+  size_t addr = _sector_addr(log, log->active);
+  while (addr + log->slot_size <= end && _read_slot(log, addr, &record) != SLOT_ERASED) {
+    addr += log->slot_size;
+  }
+  log->write_addr = addr;
+}
+
+/**
+ * @brief Replay the records of a chain sector
+ *
+ * @return true if a commit record was found
+ */
+static bool _replay_sector(const struct nvlog *log, size_t sector, uint32_t seq, nvlog_replay_t replay, void *arg) {
+  struct record record;
+  bool committed = false;
+  size_t end = _sector_addr(log, sector) + log->flash->sector_size;
+  // skip the header
+  for (size_t addr = _sector_addr(log, sector) + log->slot_size; addr + log->slot_size <= end; addr += log->slot_size) {
+    enum slot_state state = _read_slot(log, addr, &record);
+    if (state == SLOT_ERASED) {
+      break;
+    }
+    if (state != SLOT_VALID || record.seq != seq) {
+      continue;
+    }
+    if (record.key == NVLOG_KEY_COMMIT) {
+      committed = true;
+    } else if (record.key < NVLOG_KEY_RESERVED && replay) {
+      replay(record.key, record.value, arg);
+    }
+  }
+  return committed;
+}
+
+static nvlog_status_t _format(struct nvlog *log) {
+  nvlog_status_t status = _open_sector(log, 0, NVLOG_KEY_SNAPSHOT, 0);
+  if (status != NVLOG_OK) {
+    return status;
+  }
+  status = _write_slot(log, NVLOG_KEY_COMMIT, 0);
+  if (status != NVLOG_OK) {
+    return status;
+  }
+  log->base = log->active;
+  log->base_seq = log->sector_seq;
+  log->chain = 1;
+  return NVLOG_OK;
+}
+
+nvlog_status_t nvlog_mount(struct nvlog *log, const struct nvlog_flash *flash, nvlog_replay_t replay, nvlog_snapshot_t snapshot, void *arg) {
+  assert(log && flash && snapshot);
+  if (flash->num_sectors < 2 || flash->program_size == 0 || flash->program_size > NVLOG_SLOT_MAX) {
+    return NVLOG_CONFIG_ERR;
+  }
+  memset(log, 0, sizeof(*log));
+  log->flash = flash;
+  log->snapshot = snapshot;
+  log->arg = arg;
+  log->slot_size = (sizeof(struct record) + flash->program_size - 1) / flash->program_size * flash->program_size;
+  if (flash->sector_size < 2 * log->slot_size) {
+    return NVLOG_CONFIG_ERR;
+  }
+  // find the newest committed snapshot; only candidates newer than the current best are scanned
+  struct record header;
+  bool found = false;
+  for (size_t sector = 0; sector < flash->num_sectors; sector++) {
+    if (_read_slot(log, _sector_addr(log, sector), &header) != SLOT_VALID) {
+      continue;
+    }
+    if (header.seq > log->max_seq) {
+      log->max_seq = header.seq;
+    }
+    if (header.key != NVLOG_KEY_SNAPSHOT || (found && header.seq <= log->base_seq)) {
+      continue;
+    }
+    if (_replay_sector(log, sector, header.seq, NULL, NULL)) {
+      found = true;
+      log->base = sector;
+      log->base_seq = header.seq;
+    }
+  }
+  if (!found) {
+    return _format(log);
+  }
+  // replay the chain: continuation sectors follow the base in allocation order
+  _replay_sector(log, log->base, log->base_seq, replay, arg);
+  log->active = log->base;
+  log->sector_seq = log->base_seq;
+  log->chain = 1;
+  size_t sector = _next_sector(log, log->base);
+  while (log->chain < flash->num_sectors - 1) {
+    if (_read_slot(log, _sector_addr(log, sector), &header) != SLOT_VALID || header.key != NVLOG_KEY_CONTINUE ||
+        header.value != log->base_seq || header.seq != log->sector_seq + 1) {
+      break;
+    }
+    _replay_sector(log, sector, header.seq, replay, arg);
+    log->active = sector;
+    log->sector_seq = header.seq;
+    log->chain++;
+    sector = _next_sector(log, sector);
+  }
+  _seek(log);
+  return NVLOG_OK;
+}
+
+nvlog_status_t nvlog_append(struct nvlog *log, uint16_t key, uint32_t value) {
+  assert(log && log->flash);
+  if (key >= NVLOG_KEY_RESERVED) {
+    return NVLOG_KEY_ERR;
+  }
+  if (_sector_full(log)) {
+    // the snapshot must fit in a single sector
+    if (log->compacting) {
+      return NVLOG_FULL_ERR;
+    }
+    nvlog_status_t status = _advance(log);
+    if (status != NVLOG_OK) {
+      return status;
+    }
+  }
+  return _write_slot(log, key, value);
+}
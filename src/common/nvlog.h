@@ -0,0 +1,101 @@
+/**
+ * @file nvlog.h
+ * @brief Log-structured non-volatile key/value store
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __NVLOG_H__
+#define __NVLOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int nvlog_status_t;
+
+#define NVLOG_OK (nvlog_status_t)0
+#define NVLOG_FLASH_ERR (nvlog_status_t)1
+#define NVLOG_FULL_ERR (nvlog_status_t)2
+#define NVLOG_KEY_ERR (nvlog_status_t)3
+#define NVLOG_CONFIG_ERR (nvlog_status_t)4
+
+/**
+ * @brief Keys at or above this value are reserved for log metadata
+ */
+#define NVLOG_KEY_RESERVED 0xFF00
+
+/**
+ * @brief Flash backend. Addresses are relative to the start of the log region which spans
+ * `num_sectors` sectors of `sector_size` bytes. Programmed bytes must be erased (0xFF) and can
+ * only be programmed once per erase.
+ */
+struct nvlog_flash {
+  void *ctx;           // backend context
+  size_t sector_size;  // erase unit (bytes)
+  size_t num_sectors;  // number of sectors in the log region (>= 2)
+  size_t program_size; // minimum program unit (bytes)
+  nvlog_status_t (*read)(void *ctx, size_t addr, void *data, size_t len);
+  nvlog_status_t (*program)(void *ctx, size_t addr, const void *data, size_t len);
+  nvlog_status_t (*erase)(void *ctx, size_t sector);
+};
+
+struct nvlog;
+
+/**
+ * @brief Replay callback invoked for every valid record, oldest first, while mounting
+ */
+typedef void (*nvlog_replay_t)(uint16_t key, uint32_t value, void *arg);
+
+/**
+ * @brief Snapshot callback invoked during compaction. Must `nvlog_append` the current value of
+ * every live key.
+ */
+typedef nvlog_status_t (*nvlog_snapshot_t)(struct nvlog *log, void *arg);
+
+struct nvlog {
+  const struct nvlog_flash *flash;
+  nvlog_snapshot_t snapshot;
+  void *arg;
+  size_t slot_size;     // record slot size (multiple of program size)
+  size_t base;          // sector holding the last committed snapshot
+  size_t active;        // sector records are appended to
+  size_t chain;         // number of sectors from base to active
+  size_t write_addr;    // next free slot
+  uint32_t base_seq;    // sequence number of the base sector
+  uint32_t sector_seq;  // sequence number of the active sector
+  uint32_t max_seq;     // largest sector sequence number seen
+  bool compacting;      // compaction in progress
+  uint32_t compactions; // number of compactions since mount
+};
+
+/**
+ * @brief Mount the log: find the newest committed snapshot and replay it along with every
+ * record appended after it. Torn records are skipped. An unformatted region is formatted to an
+ * empty log.
+ *
+ * @param[out] log log context
+ * @param[in] flash flash backend
+ * @param[in] replay record replay callback (optional)
+ * @param[in] snapshot compaction snapshot callback
+ * @param[in] arg callback argument
+ * @return status code
+ */
+nvlog_status_t nvlog_mount(struct nvlog *log, const struct nvlog_flash *flash, nvlog_replay_t replay, nvlog_snapshot_t snapshot, void *arg);
+
+/**
+ * @brief Append a record. Opens the next sector when the active sector is full and compacts the
+ * log into the spare sector when every other sector is in use. On error the log must be
+ * remounted.
+ *
+ * @param[in] log log context
+ * @param[in] key record key (< NVLOG_KEY_RESERVED)
+ * @param[in] value record value
+ * @return status code
+ */
+nvlog_status_t nvlog_append(struct nvlog *log, uint16_t key, uint32_t value);
+
+#endif // __NVLOG_H__
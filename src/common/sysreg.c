@@ -14,153 +14,77 @@
 #include <math.h>
 #include <assert.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 
 /**
- * @brief System register data type support
+ * @brief Register storage is a sequence latch: two copies of the register map guarded by a
+ * sequence counter. Readers use copy `sequence & 1` and retry if the sequence moved underneath
+ * them, while the writer always updates the copy readers are not using. A reader that preempts
+ * the writer therefore never spins waiting for it to finish.
+ *
+ * @note register writes must come from a single writer (or be serialized by the caller)
  */
-typedef union {
-  uint8_t u8;
-  uint16_t u16;
-  uint32_t u32;
-  float f32;
-} value_t;
-
-typedef enum {
-  DTYPE_U8,
-  DTYPE_U16,
-  DTYPE_U32,
-  DTYPE_F32,
-} dtype_t;
-
-static sysreg_t registers = {0};
+static sysreg_t registers[2] = {0};
+static atomic_uint_fast32_t sequence = 0;
 
 typedef struct reg_conf_t {
-  const size_t offset; // register offset
-  uint8_t access;      // bitfield
-  const dtype_t dtype; // data type
-  const value_t reset; // value on reset
-  const value_t min;   // minimum value
-  const value_t max;   // maximum value
+  const size_t offset;        // register offset
+  uint8_t access;             // bitfield
+  const sysreg_dtype_t dtype; // data type
+  const sysreg_value_t reset; // value on reset
+  const sysreg_value_t min;   // minimum value
+  const sysreg_value_t max;   // maximum value
 } reg_conf_t;
 
+/**
+ * @brief The register map (`SYSREG_MAP`) is generated from sysreg.json. Each row expands into a
+ * register configuration entry and an offset lookup entry so the two tables cannot drift apart.
+ */
 // clang-format off
-static reg_conf_t register_config[] = {
-  {
-    .offset = SYSREG_GPU8_UL,
-    .dtype = DTYPE_U8,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u8 = 0},
-    .min = {.u8 = 0},
-    .max = {.u8 = 255}
-  },
-  {
-    .offset = SYSREG_GPU8,
-    .dtype = DTYPE_U8,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u8 = 0},
-    .min = {.u8 = 0},
-    .max = {.u8 = 255}
-  },
-  {
-    .offset = SYSREG_GPU16_UL,
-    .dtype = DTYPE_U16,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u16 = 0},
-    .min = {.u16 = 0},
-    .max = {.u16 = 65535}
-  },
-  {
-    .offset = SYSREG_GPU16,
-    .dtype = DTYPE_U16,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u16 = 0},
-    .min = {.u16 = 0},
-    .max = {.u16 = 65535}
-  },
-  {
-    .offset = SYSREG_GPU32_UL,
-    .dtype = DTYPE_U32,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u32 = 0},
-    .min = {.u32 = 0},
-    .max = {.u32 = 4294967295}
-  },
-  {
-    .offset = SYSREG_GPU32,
-    .dtype = DTYPE_U32,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u32 = 0},
-    .min = {.u32 = 0},
-    .max = {.u32 = 4294967295}
-  },
-  {
-    .offset = SYSREG_GPF32_UL,
-    .dtype = DTYPE_F32,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.f32 = 0},
-    .min= {.f32 = -FLT_MAX},
-    .max= {.f32 = FLT_MAX}
-  },
-  {
-    .offset = SYSREG_GPF32,
-    .dtype = DTYPE_F32,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.f32 = 0},
-    .min= {.f32 = -FLT_MAX},
-    .max= {.f32 = FLT_MAX}
-  },
-  {
-    .offset = SYSREG_HW_VERSION,
-    .dtype = DTYPE_U32,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R,
-    .reset = {.u32 = SYSREG_HW_VERSION_RESET},
-    .min = {.u32 = 0},
-    .max = {.u32 = 4294967295}
-  },
-  {
-    .offset = SYSREG_FW_VERSION,
-    .dtype = DTYPE_U32,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R,
-    .reset = {.u32 = SYSREG_FW_VERSION_RESET},
-    .min= {.u32 = 0},
-    .max= {.u32 = 4294967295}
-  },
-  {
-    .offset = SYSREG_UUID,
-    .dtype = DTYPE_U32,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R,
-    .reset = {.u32 = SYSREG_UUID_RESET},
-    .min = {.u32 = 0},
-    .max = {.u32 = 4294967295}
-  },
-  {
-    .offset = SYSREG_SYS_STAT,
-    .dtype = DTYPE_U8,
-    .access = SYSREG_ACCESS_L | SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u8 = SYSREG_SYS_STAT_RESET},
-    .min = {.u8 = 0},
-    .max = {.u8 = 255}
-  },
-  {
-    .offset = SYSREG_STB,
-    .dtype = DTYPE_U8,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.u8 = SYSREG_STB_RESET},
-    .min = {.u8 = 0},
-    .max = {.u8 = 255}
-  },
-  {
-    .offset = SYSREG_SETPOINT,
-    .dtype = DTYPE_F32,
-    .access = SYSREG_ACCESS_R | SYSREG_ACCESS_W,
-    .reset = {.f32 = 0.0f},
-    .min = {.f32 = -FLT_MAX},
-    .max = {.f32 = FLT_MAX}
-  },
-};
+#define REG_ID(name, member, dtype, field, access, reset, min, max) REG_ID_##name,
+#define REG_CONFIG(name, member, dtype_, field, access_, reset_, min_, max_) \
+  [REG_ID_##name] = { .offset = SYSREG_##name, .dtype = dtype_, .access = access_, .reset = {.field = reset_}, .min = {.field = min_}, .max = {.field = max_} },
+#define REG_INDEX(name, member, dtype, field, access, reset, min, max) [SYSREG_##name] = REG_ID_##name + 1,
+#define REG_CHECK(name, member, dtype, field, access, reset, min, max) \
+  _Static_assert(SYSREG_##name == offsetof(sysreg_t, member), "SYSREG_" #name " does not match sysreg_t." #member); \
+  _Static_assert(sizeof(((sysreg_t *)0)->member) == sizeof(((sysreg_value_t *)0)->field), "SYSREG_" #name " dtype does not match sysreg_t." #member);
+#define REG_RESET_CHECK(name, reset, min, max) \
+  _Static_assert((long long)(reset) >= (long long)(min) && (long long)(reset) <= (long long)(max), "SYSREG_" #name " reset out of range");
 // clang-format on
 
-#define SYSREG_NUM_REGISTERS sizeof(register_config) / sizeof(reg_conf_t)
+enum reg_id {
+  SYSREG_MAP(REG_ID)
+  REG_ID_COUNT
+};
+
+SYSREG_MAP(REG_CHECK)
+SYSREG_RESET_CHECKS(REG_RESET_CHECK)
+_Static_assert(REG_ID_COUNT == SYSREG_COUNT, "every SYSREG_* offset requires an entry in SYSREG_MAP");
+_Static_assert(REG_ID_COUNT < UINT16_MAX, "register index table overflow");
+
+static reg_conf_t register_config[REG_ID_COUNT] = {SYSREG_MAP(REG_CONFIG)};
+
+/**
+ * @brief Dense offset to register configuration lookup. Entries hold the register id + 1 so
+ * that unmapped offsets (padding and multi-byte register interiors) resolve to 0.
+ */
+static const uint16_t register_index[sizeof(sysreg_t)] = {SYSREG_MAP(REG_INDEX)};
+
+#define SYSREG_NUM_REGISTERS REG_ID_COUNT
+#define REG_MASK_WORDS ((REG_ID_COUNT + 31) / 32)
+
+/**
+ * @brief Change subscriber. Interest and dirty bits are indexed by register id.
+ */
+struct subscriber {
+  sysreg_notify_t notify; // NULL if slot is free
+  void *arg;
+  uint32_t interest[REG_MASK_WORDS];
+  atomic_uint_fast32_t dirty[REG_MASK_WORDS];
+};
+
+static struct subscriber subscribers[SYSREG_MAX_SUBSCRIBERS] = {0};
 
 /**
  * @brief Get register configuration
@@ -177,7 +101,7 @@ static reg_conf_t *_get_reg_config(const size_t offset);
  * @param[in] dtype data type of request
  * @return status code
  */
-static sysreg_status_t _sanitize_write(const reg_conf_t *config, const dtype_t dtype);
+static sysreg_status_t _sanitize_write(const reg_conf_t *config, const sysreg_dtype_t dtype);
 
 /**
  * @brief Sanitize register read at offset is permitted by type and access checks
@@ -186,18 +110,87 @@ static sysreg_status_t _sanitize_write(const reg_conf_t *config, const dtype_t d
  * @param[in] dtype data type of request
  * @return status code
  */
-static sysreg_status_t _sanitize_read(const reg_conf_t *config, const dtype_t dtype);
+static sysreg_status_t _sanitize_read(const reg_conf_t *config, const sysreg_dtype_t dtype);
+
+/**
+ * @brief Get register size in bytes by data type
+ *
+ * @param[in] dtype register data type
+ * @return size in bytes
+ */
+static size_t _dtype_size(const sysreg_dtype_t dtype);
+
+/**
+ * @brief Saturate value to register min and max range
+ *
+ * @param[in] config sysreg configuration
+ * @param[in] value input value
+ * @return saturated value
+ */
+static sysreg_value_t _saturate(const reg_conf_t *config, sysreg_value_t value);
+
+/**
+ * @brief Begin a register write. Redirects readers to the standby copy.
+ *
+ * @return writable register map
+ */
+static uint8_t *_write_begin(void);
+
+/**
+ * @brief End a register write. Redirects readers to the updated copy and synchronizes the
+ * modified range into the standby copy.
+ *
+ * @param[in] offset start of modified range
+ * @param[in] size size of modified range in bytes
+ */
+static void _write_end(const size_t offset, const size_t size);
+
+/**
+ * @brief Tear-free read of a register map range
+ *
+ * @param[in] offset start of range
+ * @param[out] data output buffer
+ * @param[in] size size of range in bytes
+ */
+static void _read(const size_t offset, void *data, const size_t size);
+
+/**
+ * @brief Store a saturated value into the writable register map and record whether it changed
+ *
+ * @param[in] reg writable register map from `_write_begin`
+ * @param[in] config sysreg configuration
+ * @param[in] value saturated value
+ * @param[in,out] changed register id bitmask of changed registers
+ */
+static void _store(uint8_t *reg, const reg_conf_t *config, const sysreg_value_t *value, uint32_t *changed);
+
+/**
+ * @brief Set subscriber dirty bits and notify subscribers of changed registers
+ *
+ * @param[in] changed register id bitmask of changed registers
+ */
+static void _publish(const uint32_t *changed);
+
+/**
+ * @brief Write a saturated value to a single register and notify subscribers on change
+ *
+ * @param[in] config sysreg configuration
+ * @param[in] value saturated value
+ */
+static void _write(const reg_conf_t *config, const sysreg_value_t value);
 
 static reg_conf_t *_get_reg_config(const size_t offset) {
-  for (size_t i = 0; i < SYSREG_NUM_REGISTERS; i++) {
-    if (offset == register_config[i].offset) {
-      return &register_config[i];
-    }
+  if (offset >= sizeof(sysreg_t)) {
+    return NULL;
+  }
+  const uint16_t index = register_index[offset];
+  if (index == 0) {
+    return NULL;
   }
-  return NULL;
+  return &register_config[index - 1];
 }
 
-static sysreg_status_t _sanitize_write(const reg_conf_t *config, const dtype_t dtype) {
+static sysreg_status_t _sanitize_write(const reg_conf_t *config, const sysreg_dtype_t dtype) {
   if (!(config->access & SYSREG_ACCESS_W)) {
     return SYSREG_ACCESS_ERR;
   }
@@ -207,7 +200,7 @@ static sysreg_status_t _sanitize_write(const reg_conf_t *config, const dtype_t d
   return SYSREG_OK;
 }
 
-static sysreg_status_t _sanitize_read(const reg_conf_t *config, const dtype_t dtype) {
+static sysreg_status_t _sanitize_read(const reg_conf_t *config, const sysreg_dtype_t dtype) {
   if (!(config->access & SYSREG_ACCESS_R)) {
     return SYSREG_ACCESS_ERR;
   }
@@ -217,64 +210,128 @@ static sysreg_status_t _sanitize_read(const reg_conf_t *config, const dtype_t dt
   return SYSREG_OK;
 }
 
-sysreg_status_t sysreg_init(void) {
-  for (size_t i = 0; i < SYSREG_NUM_REGISTERS; i++) {
-    reg_conf_t config = register_config[i];
-    switch (config.dtype) {
-      case DTYPE_U8:
-        assert(config.reset.u8 >= config.min.u8);
-        assert(config.reset.u8 <= config.max.u8);
-        break;
-      case DTYPE_U16:
-        assert(config.reset.u16 >= config.min.u16);
-        assert(config.reset.u16 <= config.max.u16);
-        break;
-      case DTYPE_U32:
-        assert(config.reset.u32 >= config.min.u32);
-        assert(config.reset.u32 <= config.max.u32);
-        break;
-      case DTYPE_F32:
-        assert(config.reset.f32 >= config.min.f32);
-        assert(config.reset.f32 <= config.max.f32);
-        break;
-      default:
-        // CS TODO: log warning - no assertions for missing type
-        break;
+static size_t _dtype_size(const sysreg_dtype_t dtype) {
+  switch (dtype) {
+    case SYSREG_DTYPE_U8:
+      return sizeof(uint8_t);
+    case SYSREG_DTYPE_U16:
+      return sizeof(uint16_t);
+    case SYSREG_DTYPE_U32:
+      return sizeof(uint32_t);
+    case SYSREG_DTYPE_F32:
+      return sizeof(float);
+    default:
+      return 0;
+  }
+}
+
+static sysreg_value_t _saturate(const reg_conf_t *config, sysreg_value_t value) {
+  switch (config->dtype) {
+    case SYSREG_DTYPE_U8:
+      if (value.u8 < config->min.u8) {
+        value.u8 = config->min.u8;
+      } else if (value.u8 > config->max.u8) {
+        value.u8 = config->max.u8;
+      }
+      break;
+    case SYSREG_DTYPE_U16:
+      if (value.u16 < config->min.u16) {
+        value.u16 = config->min.u16;
+      } else if (value.u16 > config->max.u16) {
+        value.u16 = config->max.u16;
+      }
+      break;
+    case SYSREG_DTYPE_U32:
+      if (value.u32 < config->min.u32) {
+        value.u32 = config->min.u32;
+      } else if (value.u32 > config->max.u32) {
+        value.u32 = config->max.u32;
+      }
+      break;
+    case SYSREG_DTYPE_F32:
+      value.f32 = fminf(value.f32, config->max.f32);
+      value.f32 = fmaxf(value.f32, config->min.f32);
+      break;
+    default:
+      break;
+  }
+  return value;
+}
+
+static uint8_t *_write_begin(void) {
+  uint_fast32_t seq = atomic_load_explicit(&sequence, memory_order_relaxed);
+  // an odd sequence means another writer was preempted mid write
+  assert((seq & 1) == 0);
+  atomic_store_explicit(&sequence, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  return (uint8_t *)&registers[0];
+}
+
+static void _write_end(const size_t offset, const size_t size) {
+  uint_fast32_t seq = atomic_load_explicit(&sequence, memory_order_relaxed);
+  atomic_store_explicit(&sequence, seq + 1, memory_order_release);
+  atomic_thread_fence(memory_order_release);
+  memcpy((uint8_t *)&registers[1] + offset, (uint8_t *)&registers[0] + offset, size);
+}
+
+static void _read(const size_t offset, void *data, const size_t size) {
+  uint_fast32_t seq;
+  do {
+    seq = atomic_load_explicit(&sequence, memory_order_acquire);
+    memcpy(data, (uint8_t *)&registers[seq & 1] + offset, size);
+    atomic_thread_fence(memory_order_acquire);
+  } while (seq != atomic_load_explicit(&sequence, memory_order_relaxed));
+}
+
+static void _store(uint8_t *reg, const reg_conf_t *config, const sysreg_value_t *value, uint32_t *changed) {
+  const size_t size = _dtype_size(config->dtype);
+  if (memcmp(reg + config->offset, value, size) != 0) {
+    const size_t id = (size_t)(config - register_config);
+    memcpy(reg + config->offset, value, size);
+    changed[id / 32] |= (uint32_t)1 << (id % 32);
+  }
+}
+
+static void _publish(const uint32_t *changed) {
+  for (size_t i = 0; i < SYSREG_MAX_SUBSCRIBERS; i++) {
+    struct subscriber *sub = &subscribers[i];
+    bool notify = false;
+    if (sub->notify == NULL) {
+      continue;
+    }
+    for (size_t w = 0; w < REG_MASK_WORDS; w++) {
+      const uint32_t bits = changed[w] & sub->interest[w];
+      if (bits != 0) {
+        atomic_fetch_or_explicit(&sub->dirty[w], bits, memory_order_release);
+        notify = true;
+      }
+    }
+    if (notify) {
+      sub->notify(sub->arg);
     }
   }
+}
+
+static void _write(const reg_conf_t *config, const sysreg_value_t value) {
+  uint32_t changed[REG_MASK_WORDS] = {0};
+  _store(_write_begin(), config, &value, changed);
+  _write_end(config->offset, _dtype_size(config->dtype));
+  _publish(changed);
+}
+
+sysreg_status_t sysreg_init(void) {
   sysreg_reset();
   return SYSREG_OK;
 }
 
 sysreg_status_t sysreg_reset(void) {
+  uint32_t changed[REG_MASK_WORDS] = {0};
+  uint8_t *reg = _write_begin();
   for (size_t i = 0; i < SYSREG_NUM_REGISTERS; i++) {
-    size_t size = 0;
-    const void *value = NULL;
-    reg_conf_t config = register_config[i];
-    switch (config.dtype) {
-      case DTYPE_U8:
-        value = &config.reset.u8;
-        size = sizeof(uint8_t);
-        break;
-      case DTYPE_U16:
-        value = &config.reset.u16;
-        size = sizeof(uint16_t);
-        break;
-      case DTYPE_U32:
-        value = &config.reset.u32;
-        size = sizeof(uint32_t);
-        break;
-      case DTYPE_F32:
-        value = &config.reset.f32;
-        size = sizeof(float_t);
-        break;
-      default:
-        break;
-    }
-    if (size > 0) {
-      memcpy((uint8_t *)&registers + config.offset, value, size);
-    }
+    _store(reg, &register_config[i], &register_config[i].reset, changed);
   }
+  _write_end(0, sizeof(sysreg_t));
+  _publish(changed);
   return SYSREG_OK;
 }
 
@@ -301,11 +358,11 @@ sysreg_status_t sysreg_get_u8(size_t offset, uint8_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_read(config, DTYPE_U8);
+  status = _sanitize_read(config, SYSREG_DTYPE_U8);
   if (status != SYSREG_OK) {
     return status;
   }
-  memcpy(data, (uint8_t *)&registers + offset, sizeof(uint8_t));
+  _read(offset, data, sizeof(uint8_t));
   return SYSREG_OK;
 }
 
@@ -315,17 +372,13 @@ sysreg_status_t sysreg_set_u8(size_t offset, const uint8_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_write(config, DTYPE_U8);
+  status = _sanitize_write(config, SYSREG_DTYPE_U8);
   if (status != SYSREG_OK) {
     return status;
   }
-  uint8_t value = *data;
-  if (value < config->min.u8) {
-    value = config->min.u8;
-  } else if (value > config->max.u8) {
-    value = config->max.u8;
-  }
-  memcpy((uint8_t *)&registers + offset, &value, sizeof(uint8_t));
+  sysreg_value_t value = {.u8 = *data};
+  value = _saturate(config, value);
+  _write(config, value);
   return SYSREG_OK;
 }
 
@@ -335,11 +388,11 @@ sysreg_status_t sysreg_get_u16(size_t offset, uint16_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_read(config, DTYPE_U16);
+  status = _sanitize_read(config, SYSREG_DTYPE_U16);
   if (status != SYSREG_OK) {
     return status;
   }
-  memcpy(data, (uint8_t *)&registers + offset, sizeof(uint16_t));
+  _read(offset, data, sizeof(uint16_t));
   return SYSREG_OK;
 }
 
@@ -349,17 +402,13 @@ sysreg_status_t sysreg_set_u16(size_t offset, const uint16_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_write(config, DTYPE_U16);
+  status = _sanitize_write(config, SYSREG_DTYPE_U16);
   if (status != SYSREG_OK) {
     return status;
   }
-  uint16_t value = *data;
-  if (value < config->min.u16) {
-    value = config->min.u16;
-  } else if (value > config->max.u16) {
-    value = config->max.u16;
-  }
-  memcpy((uint8_t *)&registers + offset, &value, sizeof(uint16_t));
+  sysreg_value_t value = {.u16 = *data};
+  value = _saturate(config, value);
+  _write(config, value);
   return SYSREG_OK;
 }
 
@@ -369,11 +418,11 @@ sysreg_status_t sysreg_get_u32(size_t offset, uint32_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_read(config, DTYPE_U32);
+  status = _sanitize_read(config, SYSREG_DTYPE_U32);
   if (status != SYSREG_OK) {
     return status;
   }
-  memcpy(data, (uint8_t *)&registers + offset, sizeof(uint32_t));
+  _read(offset, data, sizeof(uint32_t));
   return SYSREG_OK;
 }
 
@@ -383,17 +432,13 @@ sysreg_status_t sysreg_set_u32(size_t offset, const uint32_t *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_write(config, DTYPE_U32);
+  status = _sanitize_write(config, SYSREG_DTYPE_U32);
   if (status != SYSREG_OK) {
     return status;
   }
-  uint32_t value = *data;
-  if (value < config->min.u32) {
-    value = config->min.u32;
-  } else if (value > config->max.u32) {
-    value = config->max.u32;
-  }
-  memcpy((uint8_t *)&registers + offset, &value, sizeof(uint32_t));
+  sysreg_value_t value = {.u32 = *data};
+  value = _saturate(config, value);
+  _write(config, value);
   return SYSREG_OK;
 }
 
@@ -403,11 +448,11 @@ sysreg_status_t sysreg_get_f32(size_t offset, float *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_read(config, DTYPE_F32);
+  status = _sanitize_read(config, SYSREG_DTYPE_F32);
   if (status != SYSREG_OK) {
     return status;
   }
-  memcpy(data, (uint8_t *)&registers + offset, sizeof(float));
+  _read(offset, data, sizeof(float));
   return SYSREG_OK;
 }
 
@@ -417,13 +462,145 @@ sysreg_status_t sysreg_set_f32(size_t offset, const float *data) {
   if (config == NULL) {
     return SYSREG_NOT_FOUND_ERR;
   }
-  status = _sanitize_write(config, DTYPE_F32);
+  status = _sanitize_write(config, SYSREG_DTYPE_F32);
   if (status != SYSREG_OK) {
     return status;
   }
-  float value = *data;
-  value = fminf(value, config->max.f32);
-  value = fmaxf(value, config->min.f32);
-  memcpy((uint8_t *)&registers + offset, &value, sizeof(float));
+  sysreg_value_t value = {.f32 = *data};
+  value = _saturate(config, value);
+  _write(config, value);
+  return SYSREG_OK;
+}
+
+sysreg_status_t sysreg_transact(sysreg_op_t *ops, size_t num_ops) {
+  sysreg_status_t status = SYSREG_OK;
+  bool has_write = false;
+  if (ops == NULL) {
+    return SYSREG_MEMORY_ERR;
+  }
+  // validate the whole batch before touching any register
+  for (size_t i = 0; i < num_ops; i++) {
+    sysreg_op_t *op = &ops[i];
+    const reg_conf_t *config = _get_reg_config(op->offset);
+    if (config == NULL) {
+      op->status = SYSREG_NOT_FOUND_ERR;
+    } else if (op->op == SYSREG_OP_READ) {
+      op->status = _sanitize_read(config, op->dtype);
+    } else if (op->op == SYSREG_OP_WRITE) {
+      op->status = _sanitize_write(config, op->dtype);
+      has_write = true;
+    } else {
+      op->status = SYSREG_OP_ERR;
+    }
+    if (op->status != SYSREG_OK && status == SYSREG_OK) {
+      status = op->status;
+    }
+  }
+  if (status != SYSREG_OK) {
+    for (size_t i = 0; i < num_ops; i++) {
+      if (ops[i].status == SYSREG_OK) {
+        ops[i].status = SYSREG_ABORT_ERR;
+      }
+    }
+    return status;
+  }
+  if (!has_write) {
+    // read only batches are a consistent view of the register map
+    uint_fast32_t seq;
+    do {
+      seq = atomic_load_explicit(&sequence, memory_order_acquire);
+      for (size_t i = 0; i < num_ops; i++) {
+        memcpy(&ops[i].value, (uint8_t *)&registers[seq & 1] + ops[i].offset, _dtype_size(ops[i].dtype));
+      }
+      atomic_thread_fence(memory_order_acquire);
+    } while (seq != atomic_load_explicit(&sequence, memory_order_relaxed));
+    return SYSREG_OK;
+  }
+  // apply in order so reads observe earlier writes in the same batch
+  uint32_t changed[REG_MASK_WORDS] = {0};
+  size_t lo = sizeof(sysreg_t);
+  size_t hi = 0;
+  uint8_t *reg = _write_begin();
+  for (size_t i = 0; i < num_ops; i++) {
+    sysreg_op_t *op = &ops[i];
+    const reg_conf_t *config = _get_reg_config(op->offset);
+    size_t size = _dtype_size(op->dtype);
+    if (op->op == SYSREG_OP_WRITE) {
+      sysreg_value_t value = _saturate(config, op->value);
+      _store(reg, config, &value, changed);
+      lo = op->offset < lo ? op->offset : lo;
+      hi = op->offset + size > hi ? op->offset + size : hi;
+    } else {
+      memcpy(&op->value, reg + op->offset, size);
+    }
+  }
+  _write_end(lo, hi - lo);
+  _publish(changed);
+  return SYSREG_OK;
+}
+
+sysreg_status_t sysreg_snapshot(sysreg_t *out) {
+  if (out == NULL) {
+    return SYSREG_MEMORY_ERR;
+  }
+  _read(0, out, sizeof(sysreg_t));
+  return SYSREG_OK;
+}
+
+sysreg_status_t sysreg_subscribe(const size_t *offsets, const size_t num_offsets, sysreg_notify_t notify, void *arg, uint8_t *id) {
+  struct subscriber *sub = NULL;
+  uint32_t interest[REG_MASK_WORDS] = {0};
+  if (offsets == NULL || notify == NULL || id == NULL) {
+    return SYSREG_MEMORY_ERR;
+  }
+  for (size_t i = 0; i < num_offsets; i++) {
+    const reg_conf_t *config = _get_reg_config(offsets[i]);
+    if (config == NULL) {
+      return SYSREG_NOT_FOUND_ERR;
+    }
+    const size_t reg_id = (size_t)(config - register_config);
+    interest[reg_id / 32] |= (uint32_t)1 << (reg_id % 32);
+  }
+  for (uint8_t i = 0; i < SYSREG_MAX_SUBSCRIBERS; i++) {
+    if (subscribers[i].notify == NULL) {
+      sub = &subscribers[i];
+      *id = i;
+      break;
+    }
+  }
+  if (sub == NULL) {
+    return SYSREG_MEMORY_ERR;
+  }
+  for (size_t w = 0; w < REG_MASK_WORDS; w++) {
+    sub->interest[w] = interest[w];
+    atomic_store_explicit(&sub->dirty[w], 0, memory_order_relaxed);
+  }
+  sub->arg = arg;
+  sub->notify = notify;
+  return SYSREG_OK;
+}
+
+sysreg_status_t sysreg_unsubscribe(const uint8_t id) {
+  if (id >= SYSREG_MAX_SUBSCRIBERS || subscribers[id].notify == NULL) {
+    return SYSREG_NOT_FOUND_ERR;
+  }
+  subscribers[id].notify = NULL;
+  subscribers[id].arg = NULL;
+  memset(subscribers[id].interest, 0, sizeof(subscribers[id].interest));
+  return SYSREG_OK;
+}
+
+sysreg_status_t sysreg_test_and_clear_dirty(const uint8_t id, const size_t offset, bool *dirty) {
+  if (dirty == NULL) {
+    return SYSREG_MEMORY_ERR;
+  }
+  const reg_conf_t *config = _get_reg_config(offset);
+  if (id >= SYSREG_MAX_SUBSCRIBERS || subscribers[id].notify == NULL || config == NULL) {
+    return SYSREG_NOT_FOUND_ERR;
+  }
+  const size_t reg_id = (size_t)(config - register_config);
+  const uint32_t bit = (uint32_t)1 << (reg_id % 32);
+  const uint32_t prev = atomic_fetch_and_explicit(&subscribers[id].dirty[reg_id / 32], ~bit, memory_order_acquire);
+  *dirty = (prev & bit) != 0;
   return SYSREG_OK;
 }
@@ -14,6 +14,7 @@
 
 #include <stdint.h> // IWYU pragma: export
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef int sysreg_status_t;
 
@@ -24,6 +25,7 @@ typedef int sysreg_status_t;
 #define SYSREG_MEMORY_ERR (sysreg_status_t)4
 #define SYSREG_ACCESS_ERR (sysreg_status_t)5
 #define SYSREG_RANGE_ERR (sysreg_status_t)6
+#define SYSREG_ABORT_ERR (sysreg_status_t)7 // operation valid but transaction aborted
 
 /**
  * @brief Semantic Versioning encoding 4 bytes
@@ -53,53 +55,56 @@ typedef int sysreg_status_t;
 // one or more errors exist in error FIFO queue
 #define SYSREG_STB_ERR_QUEUE (1 << 2)
 
-typedef struct sysreg_t {
-  uint8_t gpu8;      // general purpose u8 register
-  uint8_t gpu8_ul;   // general purpose u8 register (unlocked)
-  uint16_t gpu16;    // general purpose u16 register
-  uint16_t gpu16_ul; // general purpose u16 register (unlocked)
-  uint32_t gpu32;    // general purpose u32 register
-  uint32_t gpu32_ul; // general purpose u32 register (unlocked)
-  float gpf32;       // general purpose f32 register
-  float gpf32_ul;    // general purpose f32 register (unlocked)
-  uint32_t uuid;
-  uint8_t sys_stat;
-  uint8_t stb; // status byte register (IEEE 488.2)
-  uint32_t hw_version;
-  uint32_t fw_version;
-  float setpoint;
-} sysreg_t;
+/**
+ * @brief System register data type support
+ */
+typedef union {
+  uint8_t u8;
+  uint16_t u16;
+  uint32_t u32;
+  float f32;
+} sysreg_value_t;
+
+typedef enum {
+  SYSREG_DTYPE_U8,
+  SYSREG_DTYPE_U16,
+  SYSREG_DTYPE_U32,
+  SYSREG_DTYPE_F32,
+} sysreg_dtype_t;
 
 /**
- * @brief System register access offsets
+ * @brief Transaction operation types
  */
-#define SYSREG_GPU8 offsetof(sysreg_t, gpu8)
-#define SYSREG_GPU8_UL offsetof(sysreg_t, gpu8_ul)
-#define SYSREG_GPU16 offsetof(sysreg_t, gpu16)
-#define SYSREG_GPU16_UL offsetof(sysreg_t, gpu16_ul)
-#define SYSREG_GPU32 offsetof(sysreg_t, gpu32)
-#define SYSREG_GPU32_UL offsetof(sysreg_t, gpu32_ul)
-#define SYSREG_GPF32 offsetof(sysreg_t, gpf32)
-#define SYSREG_GPF32_UL offsetof(sysreg_t, gpf32_ul)
-#define SYSREG_UUID offsetof(sysreg_t, uuid)
-#define SYSREG_SYS_STAT offsetof(sysreg_t, sys_stat)
-#define SYSREG_STB offsetof(sysreg_t, stb)
-#define SYSREG_HW_VERSION offsetof(sysreg_t, hw_version)
-#define SYSREG_FW_VERSION offsetof(sysreg_t, fw_version)
-#define SYSREG_SETPOINT offsetof(sysreg_t, setpoint)
+#define SYSREG_OP_READ (uint8_t)0
+#define SYSREG_OP_WRITE (uint8_t)1
 
 /**
- * @brief System register reset
+ * @brief Single register operation within a `sysreg_transact` batch
  */
-#define SYSREG_UUID_RESET (uint32_t)0xDECAFBAD
-#define SYSREG_STB_RESET (uint8_t)0x0
-#define SYSREG_SYS_STAT_RESET (uint8_t)0x0
-#define SYSREG_HW_VERSION_RESET (uint32_t)0x10000 // v0.1.0
-#define SYSREG_FW_VERSION_RESET (uint32_t)0x10000 // v0.1.0
+typedef struct sysreg_op_t {
+  size_t offset;          // register offset
+  uint8_t op;             // SYSREG_OP_READ or SYSREG_OP_WRITE
+  sysreg_dtype_t dtype;   // data type of request
+  sysreg_value_t value;   // write input or read output
+  sysreg_status_t status; // per operation status
+} sysreg_op_t;
 
 /**
- * @brief Sanitize register reset values are in min/max and set registers to default.
- * Registers without a default are set to 0 by zero initialization
+ * @brief Maximum number of concurrent change subscribers
+ */
+#define SYSREG_MAX_SUBSCRIBERS 4
+
+/**
+ * @brief Change notification callback. Invoked from the writer context after a subscribed
+ * register changes value, typically binds to a task notification.
+ */
+typedef void (*sysreg_notify_t)(void *arg);
+
+#include "sysreg_map.h" // generated from sysreg.json
+
+/**
+ * @brief Set registers to their default reset values. Reset values are range checked at build
+ * time by the register map generator.
  *
  * @return status code
  */
@@ -115,4 +120,59 @@ sysreg_status_t sysreg_set_u32(size_t offset, const uint32_t *data);
 sysreg_status_t sysreg_get_f32(size_t offset, float *data);
 sysreg_status_t sysreg_set_f32(size_t offset, const float *data);
 
+/**
+ * @brief Apply a batch of register reads and writes as a single all-or-nothing transaction.
+ * Every operation is validated first; if any operation fails validation no operation is applied,
+ * failing operations report their error and valid operations report `SYSREG_ABORT_ERR`.
+ * Otherwise operations are applied in order (writes are saturated to min/max) and each reports
+ * `SYSREG_OK`.
+ *
+ * @param[in,out] ops register operations
+ * @param[in] num_ops number of operations
+ * @return SYSREG_OK if the batch was applied, otherwise the first failing operation status
+ */
+sysreg_status_t sysreg_transact(sysreg_op_t *ops, size_t num_ops);
+
+/**
+ * @brief Copy a consistent snapshot of the full register map. Never blocks on a concurrent
+ * writer and never observes a partially applied write or transaction.
+ *
+ * @param[out] out register map snapshot
+ * @return status code
+ */
+sysreg_status_t sysreg_snapshot(sysreg_t *out);
+
+/**
+ * @brief Subscribe to value changes on a set of registers. `notify` is called after a write,
+ * reset or transaction changes the value of any subscribed register (after saturation). Writes
+ * that leave the value unchanged do not notify.
+ *
+ * @note subscribe during initialization, before concurrent writers are started
+ * @param[in] offsets register offsets
+ * @param[in] num_offsets number of register offsets
+ * @param[in] notify change notification callback
+ * @param[in] arg callback argument
+ * @param[out] id subscriber id
+ * @return status code (SYSREG_MEMORY_ERR if the subscriber table is full)
+ */
+sysreg_status_t sysreg_subscribe(const size_t *offsets, const size_t num_offsets, sysreg_notify_t notify, void *arg, uint8_t *id);
+
+/**
+ * @brief Release a subscriber slot
+ *
+ * @param[in] id subscriber id
+ * @return status code
+ */
+sysreg_status_t sysreg_unsubscribe(const uint8_t id);
+
+/**
+ * @brief Test and clear the dirty bit of a subscribed register
+ *
+ * @param[in] id subscriber id
+ * @param[in] offset register offset
+ * @param[out] dirty true if the register changed since the last call
+ * @return status code
+ */
+sysreg_status_t sysreg_test_and_clear_dirty(const uint8_t id, const size_t offset, bool *dirty);
+
 #endif // __SYSREG_H__
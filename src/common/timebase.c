@@ -0,0 +1,70 @@
+/**
+ * @file timebase.c
+ * @brief Monotonic 64 bit high resolution timebase
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "timebase.h"
+
+#ifdef UNITTEST
+
+#include <time.h>
+
+#define TIMEBASE_HOST_HZ 1000000000u
+
+static uint64_t origin;
+
+static uint64_t _monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * TIMEBASE_HOST_HZ + (uint64_t)ts.tv_nsec;
+}
+
+void timebase_init(void) {
+  origin = _monotonic_ns();
+}
+
+uint64_t timebase_now(void) {
+  return _monotonic_ns() - origin;
+}
+
+uint32_t timebase_frequency(void) {
+  return TIMEBASE_HOST_HZ;
+}
+
+#else
+
+#include <stm32h7xx.h>
+
+#define DWT_LAR_UNLOCK 0xC5ACCE55u
+
+static struct timebase_extension extension;
+
+void timebase_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  // the M7 DWT is locked after reset
+  DWT->LAR = DWT_LAR_UNLOCK;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint64_t timebase_now(void) {
+  // CYCCNT wraps every 2^32 cycles (~7.8 s at 550 MHz). The extension is updated with interrupts
+  // masked for a handful of cycles so samples from tasks and nested interrupts never race, and the
+  // tick hook samples every millisecond so no wrap is missed.
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  const uint64_t now = timebase_extend(&extension, DWT->CYCCNT);
+  __set_PRIMASK(primask);
+  return now;
+}
+
+uint32_t timebase_frequency(void) {
+  return SystemCoreClock;
+}
+
+#endif // UNITTEST
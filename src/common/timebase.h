@@ -0,0 +1,72 @@
+/**
+ * @file timebase.h
+ * @brief Monotonic 64 bit high resolution timebase
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Extension state of a free running 32 bit counter
+ */
+struct timebase_extension {
+  uint32_t high; // number of counter wraps
+  uint32_t last; // previous counter sample
+};
+
+/**
+ * @brief Extend a 32 bit counter sample to 64 bits. The counter must be sampled at least once per
+ * wrap period and samples must not race each other.
+ *
+ * @param[in] ext extension state
+ * @param[in] low counter sample
+ * @return 64 bit count
+ */
+static inline uint64_t timebase_extend(struct timebase_extension *ext, const uint32_t low) {
+  if (low < ext->last) {
+    ext->high++;
+  }
+  ext->last = low;
+  return ((uint64_t)ext->high << 32) | low;
+}
+
+/**
+ * @brief Start the timebase. On target this enables the DWT cycle counter; call once after the
+ * system clock is configured.
+ */
+void timebase_init(void);
+
+/**
+ * @brief Current time in timebase ticks (CPU cycles on target, nanoseconds on host). Callable from
+ * any task or interrupt except NMI and HardFault.
+ *
+ * @return ticks since timebase_init
+ */
+uint64_t timebase_now(void);
+
+/**
+ * @brief Timebase tick rate
+ *
+ * @return ticks per second
+ */
+uint32_t timebase_frequency(void);
+
+/**
+ * @brief Convert timebase ticks to microseconds
+ *
+ * @param[in] ticks timebase ticks
+ * @return microseconds
+ */
+static inline uint64_t timebase_to_us(const uint64_t ticks) {
+  const uint32_t frequency = timebase_frequency();
+  return (ticks / frequency) * 1000000u + (ticks % frequency) * 1000000u / frequency;
+}
+
+#endif // __TIMEBASE_H__
@@ -0,0 +1,173 @@
+/**
+ * @file twheel.c
+ * @brief Hierarchical timer wheel
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "twheel.h"
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @brief A timer `delta` ticks away sits in the lowest level whose span covers the delta, in the
+ * slot indexed by its expiry at that level's resolution. Level `n` slot `i` is reached when the
+ * low `n * TWHEEL_SLOT_BITS` bits of the tick wrap to zero with index `i` above them; its timers
+ * are then re-placed (cascaded) with their remaining delta, which lands them at least one level
+ * lower. Level 0 slots expire as the tick reaches them.
+ *
+ * Slots are singly linked lists with back pointers to the previous link, so a timer unlinks in
+ * O(1) without a list head sentinel per slot.
+ */
+
+#define TWHEEL_SLOT_MASK (TWHEEL_SLOTS - 1)
+
+static inline uint32_t _slot(uint32_t tick, uint8_t level) {
+  return (tick >> (TWHEEL_SLOT_BITS * level)) & TWHEEL_SLOT_MASK;
+}
+
+static void _link(struct twheel_timer **head, struct twheel_timer *timer) {
+  timer->next = *head;
+  if (timer->next != NULL) {
+    timer->next->pprev = &timer->next;
+  }
+  *head = timer;
+  timer->pprev = head;
+}
+
+static void _unlink(struct twheel *wheel, struct twheel_timer *timer) {
+  *timer->pprev = timer->next;
+  if (timer->next != NULL) {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+  wheel->count[timer->level]--;
+}
+
+/**
+ * @brief Link a timer due at or after `wheel->now` into its level and slot
+ */
+static void _place(struct twheel *wheel, struct twheel_timer *timer) {
+  const uint32_t delta = timer->expires - wheel->now;
+  uint8_t level = 0;
+  while (level < TWHEEL_LEVELS - 1 && delta >= (1u << (TWHEEL_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  timer->level = level;
+  wheel->count[level]++;
+  _link(&wheel->slots[level][_slot(timer->expires, level)], timer);
+}
+
+static void _cascade(struct twheel *wheel, uint8_t level) {
+  struct twheel_timer **head = &wheel->slots[level][_slot(wheel->now, level)];
+  struct twheel_timer *list = *head;
+  *head = NULL;
+  while (list != NULL) {
+    struct twheel_timer *timer = list;
+    list = timer->next;
+    wheel->count[level]--;
+    _place(wheel, timer);
+  }
+}
+
+void twheel_init(struct twheel *wheel, const uint32_t now) {
+  assert(wheel);
+  memset(wheel, 0, sizeof(*wheel));
+  wheel->now = now;
+}
+
+void twheel_timer_init(struct twheel_timer *timer) {
+  assert(timer);
+  memset(timer, 0, sizeof(*timer));
+}
+
+void twheel_add(struct twheel *wheel, struct twheel_timer *timer, const uint32_t expires) {
+  assert(wheel && timer);
+  if (twheel_timer_pending(timer)) {
+    _unlink(wheel, timer);
+  }
+  const int32_t delta = (int32_t)(expires - wheel->now);
+  if (delta <= 0) {
+    // the current tick has already been processed
+    timer->expires = wheel->now + 1;
+  } else if ((uint32_t)delta > TWHEEL_MAX_DELAY) {
+    timer->expires = wheel->now + TWHEEL_MAX_DELAY;
+  } else {
+    timer->expires = expires;
+  }
+  _place(wheel, timer);
+}
+
+void twheel_cancel(struct twheel *wheel, struct twheel_timer *timer) {
+  assert(wheel && timer);
+  if (twheel_timer_pending(timer)) {
+    _unlink(wheel, timer);
+  }
+}
+
+bool twheel_next_expiry(const struct twheel *wheel, uint32_t *expires) {
+  assert(wheel && expires);
+  bool found = false;
+  uint32_t nearest = 0;
+  for (uint8_t level = 0; level < TWHEEL_LEVELS; level++) {
+    if (wheel->count[level] == 0) {
+      continue;
+    }
+    // slots of a level hold consecutive spans starting after the current one, so the first
+    // occupied slot holds the level's earliest timers
+    const uint32_t current = _slot(wheel->now, level);
+    for (uint32_t i = 1; i <= TWHEEL_SLOTS; i++) {
+      const struct twheel_timer *timer = wheel->slots[level][(current + i) & TWHEEL_SLOT_MASK];
+      if (timer == NULL) {
+        continue;
+      }
+      for (; timer != NULL; timer = timer->next) {
+        if (!found || (int32_t)(timer->expires - nearest) < 0) {
+          nearest = timer->expires;
+          found = true;
+        }
+      }
+      break;
+    }
+  }
+  *expires = nearest;
+  return found;
+}
+
+void twheel_advance(struct twheel *wheel, const uint32_t now, twheel_expire_fn expire, void *arg) {
+  assert(wheel && expire);
+  while ((int32_t)(now - wheel->now) > 0) {
+    if (wheel->count[0] == 0) {
+      // nothing can expire before the next cascade: skip to it
+      const uint32_t lap = (wheel->now | TWHEEL_SLOT_MASK) + 1;
+      if ((int32_t)(now - lap) < 0) {
+        wheel->now = now;
+        break;
+      }
+      wheel->now = lap;
+    } else {
+      wheel->now++;
+    }
+    for (uint8_t level = TWHEEL_LEVELS - 1; level > 0; level--) {
+      if ((wheel->now & ((1u << (TWHEEL_SLOT_BITS * level)) - 1)) == 0) {
+        _cascade(wheel, level);
+      }
+    }
+    // detach the due slot so callbacks re-arming into it are not expired twice this tick
+    struct twheel_timer **head = &wheel->slots[0][_slot(wheel->now, 0)];
+    struct twheel_timer *due = *head;
+    *head = NULL;
+    if (due != NULL) {
+      due->pprev = &due;
+    }
+    while (due != NULL) {
+      struct twheel_timer *timer = due;
+      _unlink(wheel, timer);
+      expire(timer, arg);
+    }
+  }
+}
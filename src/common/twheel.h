@@ -0,0 +1,111 @@
+/**
+ * @file twheel.h
+ * @brief Hierarchical timer wheel
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __TWHEEL_H__
+#define __TWHEEL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TWHEEL_SLOT_BITS 6
+#define TWHEEL_SLOTS (1u << TWHEEL_SLOT_BITS)
+#define TWHEEL_LEVELS 3
+// longest delay the wheel can hold (ticks); longer timers are clamped
+#define TWHEEL_MAX_DELAY ((1u << (TWHEEL_SLOT_BITS * TWHEEL_LEVELS)) - 1)
+
+/**
+ * @brief Intrusive timer node. Embed in the owner's struct and recover the owner in the expiry
+ * callback. Not shared between wheels.
+ */
+struct twheel_timer {
+  struct twheel_timer *next;
+  struct twheel_timer **pprev; // NULL while not pending
+  uint32_t expires;            // absolute expiry tick
+  uint8_t level;
+};
+
+/**
+ * @brief Wheel state. Level 0 holds timers due within TWHEEL_SLOTS ticks at tick resolution; each
+ * higher level covers TWHEEL_SLOTS times the span of the one below at coarser resolution and is
+ * cascaded down as time reaches it, so adding, cancelling and expiring a timer are O(1).
+ */
+struct twheel {
+  uint32_t now;                     // last processed tick
+  uint16_t count[TWHEEL_LEVELS];    // pending timers per level
+  struct twheel_timer *slots[TWHEEL_LEVELS][TWHEEL_SLOTS];
+};
+
+typedef void (*twheel_expire_fn)(struct twheel_timer *timer, void *arg);
+
+/**
+ * @brief Initialize an empty wheel
+ *
+ * @param[out] wheel wheel
+ * @param[in] now current tick
+ */
+void twheel_init(struct twheel *wheel, const uint32_t now);
+
+/**
+ * @brief Initialize a timer as not pending
+ *
+ * @param[out] timer timer
+ */
+void twheel_timer_init(struct twheel_timer *timer);
+
+/**
+ * @brief Check whether a timer is armed
+ *
+ * @param[in] timer timer
+ * @return true if the timer is in a wheel
+ */
+static inline bool twheel_timer_pending(const struct twheel_timer *timer) {
+  return timer->pprev != NULL;
+}
+
+/**
+ * @brief Arm a timer, rescheduling it if it is already pending. A timer whose expiry has already
+ * passed fires on the next tick; one further out than TWHEEL_MAX_DELAY is clamped.
+ *
+ * @param[in] wheel wheel
+ * @param[in] timer timer
+ * @param[in] expires absolute expiry tick
+ */
+void twheel_add(struct twheel *wheel, struct twheel_timer *timer, const uint32_t expires);
+
+/**
+ * @brief Disarm a timer. No effect on a timer that is not pending.
+ *
+ * @param[in] wheel wheel
+ * @param[in] timer timer
+ */
+void twheel_cancel(struct twheel *wheel, struct twheel_timer *timer);
+
+/**
+ * @brief Earliest expiry of any pending timer
+ *
+ * @param[in] wheel wheel
+ * @param[out] expires absolute expiry tick
+ * @return false if no timer is pending
+ */
+bool twheel_next_expiry(const struct twheel *wheel, uint32_t *expires);
+
+/**
+ * @brief Process every tick up to `now`, calling `expire` for each timer that falls due. Timers
+ * are disarmed before their callback, which may re-arm or cancel any timer of the wheel.
+ *
+ * @param[in] wheel wheel
+ * @param[in] now current tick
+ * @param[in] expire expiry callback
+ * @param[in] arg callback argument
+ */
+void twheel_advance(struct twheel *wheel, const uint32_t now, twheel_expire_fn expire, void *arg);
+
+#endif // __TWHEEL_H__
@@ -8,8 +8,11 @@
  *
  */
 
+#define LOG_MODULE LOGGER_MODULE_ETHERNET
+
 #include "app_ethernet.h"
 #include "ethernetif.h"
+#include "logger.h"
 #if LWIP_DHCP
 #include <lwip/dhcp.h>
 #endif
@@ -80,6 +83,9 @@ static void dhcp_task(void *argument) {
       case DHCP_WAIT_ADDRESS: {
         if (dhcp_supplied_address(netif)) {
           DHCP_state = DHCP_ADDRESS_ASSIGNED;
+          const ip4_addr_t *addr = netif_ip4_addr(netif);
+          // log arguments are formatted later so pass the octets rather than an ip4addr_ntoa string
+          info("DHCP assigned address %u.%u.%u.%u\n", ip4_addr1(addr), ip4_addr2(addr), ip4_addr3(addr), ip4_addr4(addr));
 
         } else {
           dhcp = (struct dhcp *)netif_get_client_data(netif, LWIP_NETIF_CLIENT_DATA_INDEX_DHCP);
@@ -91,6 +97,7 @@ static void dhcp_task(void *argument) {
             IP_ADDR4(&netmask, NETMASK_ADDR0, NETMASK_ADDR1, NETMASK_ADDR2, NETMASK_ADDR3);
             IP_ADDR4(&gw, GW_ADDR0, GW_ADDR1, GW_ADDR2, GW_ADDR3);
             netif_set_addr(netif, ip_2_ip4(&ipaddr), ip_2_ip4(&netmask), ip_2_ip4(&gw));
+            warning("DHCP timed out, using static address %u.%u.%u.%u\n", IP_ADDR0, IP_ADDR1, IP_ADDR2, IP_ADDR3);
           }
         }
       } break;
@@ -116,12 +123,14 @@ static void dhcp_task(void *argument) {
  */
 static void ethernet_link_status_updated(struct netif *netif) {
   if (netif_is_link_up(netif)) {
+    info("ethernet link up\n");
 #if LWIP_DHCP
     /* Update DHCP state machine */
     DHCP_state = DHCP_START;
 #else
 #endif /* LWIP_DHCP */
   } else {
+    warning("ethernet link down\n");
 #if LWIP_DHCP
     /* Update DHCP state machine */
     DHCP_state = DHCP_LINK_DOWN;
@@ -0,0 +1,67 @@
+/**
+ * @file flash.c
+ * @brief Internal flash backend for the non-volatile log
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include "flash.h"
+#include "stm32h7xx_hal.h"
+
+#include <string.h>
+
+#define FLASH_WORD_SIZE (FLASH_NB_32BITWORD_IN_FLASHWORD * sizeof(uint32_t))
+
+static nvlog_status_t _read(void __attribute__((unused)) * ctx, size_t addr, void *data, size_t len) {
+  // the flash is memory mapped
+  memcpy(data, (const void *)(FLASH_NVLOG_BASE + addr), len);
+  return NVLOG_OK;
+}
+
+static nvlog_status_t _program(void __attribute__((unused)) * ctx, size_t addr, const void *data, size_t len) {
+  // HAL_FLASH_Program reads the source as 32 bit words
+  uint32_t word[FLASH_NB_32BITWORD_IN_FLASHWORD];
+  nvlog_status_t status = NVLOG_OK;
+  HAL_FLASH_Unlock();
+  for (size_t offset = 0; offset < len; offset += FLASH_WORD_SIZE) {
+    memcpy(word, (const uint8_t *)data + offset, FLASH_WORD_SIZE);
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD, FLASH_NVLOG_BASE + addr + offset, (uint32_t)word) != HAL_OK) {
+      status = NVLOG_FLASH_ERR;
+      break;
+    }
+  }
+  HAL_FLASH_Lock();
+  return status;
+}
+
+static nvlog_status_t _erase(void __attribute__((unused)) * ctx, size_t sector) {
+  FLASH_EraseInitTypeDef erase = {
+    .TypeErase = FLASH_TYPEERASE_SECTORS,
+    .Banks = FLASH_BANK_1,
+    .Sector = FLASH_NVLOG_FIRST_SECTOR + sector,
+    .NbSectors = 1,
+    .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+  };
+  uint32_t sector_error = 0;
+  HAL_FLASH_Unlock();
+  HAL_StatusTypeDef ret = HAL_FLASHEx_Erase(&erase, &sector_error);
+  HAL_FLASH_Lock();
+  return ret == HAL_OK ? NVLOG_OK : NVLOG_FLASH_ERR;
+}
+
+static const struct nvlog_flash nvlog_flash = {
+  .ctx = NULL,
+  .sector_size = FLASH_SECTOR_SIZE,
+  .num_sectors = FLASH_NVLOG_NUM_SECTORS,
+  .program_size = FLASH_WORD_SIZE,
+  .read = _read,
+  .program = _program,
+  .erase = _erase,
+};
+
+const struct nvlog_flash *flash_nvlog(void) {
+  return &nvlog_flash;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file flash.h
+ * @brief Internal flash backend for the non-volatile log
+ * @version 0.1
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#ifndef __FLASH_H__
+#define __FLASH_H__
+
+#include "nvlog.h"
+
+/**
+ * @brief Non-volatile log region: the last two 128KB sectors of bank 1. Must match the NVSTORE
+ * region of the linker script.
+ */
+#define FLASH_NVLOG_BASE 0x080C0000UL
+#define FLASH_NVLOG_FIRST_SECTOR 6
+#define FLASH_NVLOG_NUM_SECTORS 2
+
+/**
+ * @brief Get the nvlog backend for the internal flash log region
+ *
+ * @return flash backend
+ */
+const struct nvlog_flash *flash_nvlog(void);
+
+#endif // __FLASH_H__
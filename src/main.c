@@ -14,6 +14,7 @@
 #include "stm32h723xx.h"
 #include "stm32h7xx_hal.h"
 #include "system.h"
+#include "timebase.h"
 
 /**
  * @brief Port of `MPU_Config` autogenerated by CubeMX
@@ -79,6 +80,7 @@ int main(void) {
   SCB_EnableDCache();
   HAL_Init();
   SystemClock_Config();
+  timebase_init();
   PeriphCommonClock_Config();
   MX_GPIO_Init();
   MX_DMA_Init();
@@ -1,6 +1,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "uassert.h"
+#include "timebase.h"
 
 #include <stdint.h> // IWYU pragma: export
 
@@ -38,6 +39,8 @@ void vApplicationStackOverflowHook(__attribute__((unused)) xTaskHandle xTask, __
 }
 
 void vApplicationTickHook(void) {
+  // sample the cycle counter well within its wrap period to keep the 64 bit extension current
+  timebase_now();
 }
 
 void vApplicationMallocFailedHook(void) {
@@ -6,11 +6,15 @@
  * @copyright Copyright © 2025 dronectl
  */
 
+#define LOG_MODULE LOGGER_MODULE_HSM
+
 #include "hsm.h"
 #include "logger.h"
 #include "esc_engine.h"
 #include "uassert.h"
+#include "timebase.h"
 #include "power_manager.h"
+#include "cbuffer.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -18,6 +22,8 @@
 
 #define IDLE_LED_TOGGLE_RATE_MS 1000
 #define RUN_LED_TOGGLE_RATE_MS 500
+#define RESET_LAMP_TEST_MS 500
+#define CONTROL_TICK_PERIOD_MS 10
 
 enum event_handle_result {
   EVENT_UNHANDLED = 0,
@@ -26,91 +32,207 @@ enum event_handle_result {
 
 struct state_table_entry {
   enum hsm_state parent;
+  uint32_t tick_period_ms; // 0: never ticked
+  uint32_t defer_mask;     // bit per enum hsm_event held back until the state exits
+  enum hsm_state initial;  // substate entered when the state is the target, ROOT for a leaf
+  bool history;            // enter the last active substate instead of the initial one
   void (*enter)(void);
   void (*tick)(void);
   void (*exit)(void);
-  enum event_handle_result (*handle_event)(const enum hsm_event event);
+  enum event_handle_result (*handle_event)(const struct hsm_event_msg *msg);
 };
 
 /* raptor state handlers */
-static enum event_handle_result handle_event_root(const enum hsm_event event);
+static enum event_handle_result handle_event_root(const struct hsm_event_msg *msg);
 
 // reset state callbacks
 static void enter_reset(void);
-static void tick_reset(void);
 static void exit_reset(void);
+static enum event_handle_result handle_event_reset(const struct hsm_event_msg *msg);
 
 // init state callbacks
 static void tick_init(void);
 
 // idle state callbacks
 static void enter_idle(void);
-static void tick_idle(void);
 static void exit_idle(void);
-static enum event_handle_result handle_event_idle(const enum hsm_event event);
+static enum event_handle_result handle_event_idle(const struct hsm_event_msg *msg);
 
 // error state callbacks
 static void enter_error(void);
 static void tick_error(void);
 static void exit_error(void);
-static enum event_handle_result handle_event_error(const enum hsm_event event);
+static enum event_handle_result handle_event_error(const struct hsm_event_msg *msg);
 
 // run state callbacks
 static void enter_run(void);
-static void tick_run(void);
 static void exit_run(void);
-static enum event_handle_result handle_event_run(const enum hsm_event event);
+static enum event_handle_result handle_event_run(const struct hsm_event_msg *msg);
 
 // run startup state callbacks
 static void enter_run_startup(void);
 static void tick_run_startup(void);
 static void exit_run_startup(void);
-static enum event_handle_result handle_event_run_startup(const enum hsm_event event);
+static enum event_handle_result handle_event_run_startup(const struct hsm_event_msg *msg);
 
 // run startup state callbacks
 static void enter_run_profile(void);
 static void tick_run_profile(void);
 static void exit_run_profile(void);
-static enum event_handle_result handle_event_run_profile(const enum hsm_event event);
+static enum event_handle_result handle_event_run_profile(const struct hsm_event_msg *msg);
 
 // stop state callbacks
 static void enter_stop(void);
 static void tick_stop(void);
 static void exit_stop(void);
-static enum event_handle_result handle_event_stop(const enum hsm_event event);
+static enum event_handle_result handle_event_stop(const struct hsm_event_msg *msg);
 
 // calibration state callbacks
 static void enter_calibration(void);
 static void tick_calibration(void);
 static void exit_calibration(void);
-static enum event_handle_result handle_event_calibration(const enum hsm_event event);
+static enum event_handle_result handle_event_calibration(const struct hsm_event_msg *msg);
+
+// pause state callbacks
+static void enter_pause(void);
+static enum event_handle_result handle_event_pause(const struct hsm_event_msg *msg);
 
 // static hsm context
+// requests that start an activity: deferred until the HSM is ready for them and cancelled by an
+// abort posted after them
+#define REQUEST_EVENTS ((1u << HSM_EVENT_RUN) | (1u << HSM_EVENT_CALIBRATION))
+_Static_assert((REQUEST_EVENTS & (1u << HSM_EVENT_TIMEOUT)) == 0, "timeouts are not pooled and cannot be deferred");
+// events that discard every deferred request
+#define FLUSH_DEFERRED_EVENTS ((1u << HSM_EVENT_STOP) | (1u << HSM_EVENT_ABORT) | (1u << HSM_EVENT_HARD_RESET))
+
 static struct hsm_context ctx = {0};
 
+// static event pool: bit i of the free mask is set while event_pool[i] is free
+static struct hsm_event_msg event_pool[HSM_EVENT_POOL_SIZE];
+static uint32_t event_pool_free = (1u << HSM_EVENT_POOL_SIZE) - 1;
+_Static_assert(HSM_EVENT_POOL_SIZE <= 32, "event pool free mask is 32 bits");
+
+// newest event of each queue, packed as ticket (16 bits) | posts in flight (8 bits) | event (8 bits).
+// The event is HSM_EVENT_NONE while a post is in flight or once the newest event has been taken
+// off the queue, so an event is only ever merged into the newest one and commands keep their order.
+enum queue_lane {
+  QUEUE_LANE_EVENT,
+  QUEUE_LANE_PRIORITY,
+  QUEUE_LANE_COUNT,
+};
+static uint32_t queue_tail[QUEUE_LANE_COUNT];
+#define TAIL_PACK(ticket, inflight, event) (((uint32_t)(ticket) << 16) | (((uint32_t)(inflight) & 0xFFu) << 8) | ((uint32_t)(event) & 0xFFu))
+#define TAIL_TICKET(tail) ((uint16_t)((tail) >> 16))
+#define TAIL_INFLIGHT(tail) (((tail) >> 8) & 0xFFu)
+#define TAIL_EVENT(tail) ((tail) & 0xFFu)
+_Static_assert(HSM_EVENT_COUNT <= 32, "event masks are 32 bits");
+// bumped by every ABORT and HARD_RESET post; every event is stamped with it when posted
+static uint32_t abort_epoch = 0;
+// written by posters from any context, so counters are updated atomically
+static struct hsm_queue_stats queue_stats;
+// queued to the front of the event queue to wake the task for the priority queue
+static struct hsm_event_msg *const priority_wakeup = NULL;
+
+// always on trace: overwrite mode ring written by the HSM task only and read by snapshot
+static struct hsm_trace_record trace_buffer[HSM_TRACE_LEN];
+static struct cbuffer_spsc trace_ring;
+// latency histograms: written by the HSM task only, read counter by counter
+static struct hsm_latency_stats latency;
+_Static_assert(sizeof(struct hsm_latency_stats) % sizeof(uint32_t) == 0, "latency stats are copied as words");
+
+// least common ancestor of every pair of states, built from the state table by hsm_start
+static uint8_t lca_table[HSM_STATE_COUNT][HSM_STATE_COUNT];
+_Static_assert(HSM_STATE_COUNT <= UINT8_MAX, "lca table entries are 8 bits");
+
 static const struct state_table_entry state_table[HSM_STATE_COUNT] = {
-    [HSM_STATE_ROOT] = { .parent = HSM_STATE_ROOT, .enter = NULL, .tick = NULL, .exit = NULL, .handle_event = handle_event_root },
-    [HSM_STATE_RESET] = { .parent = HSM_STATE_ROOT, .enter = enter_reset, .tick = tick_reset, .exit = exit_reset, .handle_event = NULL },
-    [HSM_STATE_INIT] = { .parent = HSM_STATE_ROOT, .enter = NULL, .tick = tick_init, .exit = NULL, .handle_event = NULL },
-    [HSM_STATE_IDLE] = { .parent = HSM_STATE_ROOT, .enter = enter_idle, .tick = tick_idle, .exit = exit_idle, .handle_event = handle_event_idle },
+    [HSM_STATE_ROOT] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .enter = NULL, .tick = NULL, .exit = NULL, .handle_event = handle_event_root },
+    [HSM_STATE_RESET] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .defer_mask = REQUEST_EVENTS, .enter = enter_reset, .tick = NULL, .exit = exit_reset, .handle_event = handle_event_reset },
+    [HSM_STATE_INIT] = { .parent = HSM_STATE_ROOT, .tick_period_ms = CONTROL_TICK_PERIOD_MS, .defer_mask = REQUEST_EVENTS, .enter = NULL, .tick = tick_init, .exit = NULL, .handle_event = NULL },
+    [HSM_STATE_IDLE] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .enter = enter_idle, .tick = NULL, .exit = exit_idle, .handle_event = handle_event_idle },
 
-    [HSM_STATE_RUN] = { .parent = HSM_STATE_ROOT, .enter = enter_run, .tick = tick_run, .exit = exit_run, .handle_event = handle_event_run },
-    [HSM_STATE_RUN_STARTUP] = { .parent = HSM_STATE_RUN, .enter = enter_run_startup, .tick = tick_run_startup, .exit = exit_run_startup, .handle_event = handle_event_run_startup },
-    [HSM_STATE_RUN_PROFILE] = { .parent = HSM_STATE_RUN, .enter = enter_run_profile, .tick = tick_run_profile, .exit = exit_run_profile, .handle_event = handle_event_run_profile },
+    [HSM_STATE_RUN] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .initial = HSM_STATE_RUN_STARTUP, .history = true, .enter = enter_run, .tick = NULL, .exit = exit_run, .handle_event = handle_event_run },
+    [HSM_STATE_RUN_STARTUP] = { .parent = HSM_STATE_RUN, .tick_period_ms = CONTROL_TICK_PERIOD_MS, .enter = enter_run_startup, .tick = tick_run_startup, .exit = exit_run_startup, .handle_event = handle_event_run_startup },
+    [HSM_STATE_RUN_PROFILE] = { .parent = HSM_STATE_RUN, .tick_period_ms = 0, .enter = enter_run_profile, .tick = tick_run_profile, .exit = exit_run_profile, .handle_event = handle_event_run_profile },
+    [HSM_STATE_PAUSE] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .enter = enter_pause, .tick = NULL, .exit = NULL, .handle_event = handle_event_pause },
 
-    [HSM_STATE_STOP] = { .parent = HSM_STATE_ROOT, .enter = enter_stop, .tick = tick_stop, .exit = exit_stop, .handle_event = handle_event_stop },
-    [HSM_STATE_ERROR] = { .parent = HSM_STATE_ROOT, .enter = enter_error, .tick = tick_error, .exit = exit_error, .handle_event = handle_event_error },
+    [HSM_STATE_STOP] = { .parent = HSM_STATE_ROOT, .tick_period_ms = CONTROL_TICK_PERIOD_MS, .defer_mask = REQUEST_EVENTS, .enter = enter_stop, .tick = tick_stop, .exit = exit_stop, .handle_event = handle_event_stop },
+    [HSM_STATE_ERROR] = { .parent = HSM_STATE_ROOT, .tick_period_ms = CONTROL_TICK_PERIOD_MS, .enter = enter_error, .tick = tick_error, .exit = exit_error, .handle_event = handle_event_error },
 
-    [HSM_STATE_CALIBRATION] = { .parent = HSM_STATE_ROOT, .enter = enter_calibration, .tick = tick_calibration, .exit = exit_calibration, .handle_event = handle_event_calibration },
+    [HSM_STATE_CALIBRATION] = { .parent = HSM_STATE_ROOT, .tick_period_ms = 0, .enter = enter_calibration, .tick = tick_calibration, .exit = exit_calibration, .handle_event = handle_event_calibration },
 };
 
+// tracing
+
+static void record_latency(struct hsm_latency_hist *hist, const uint64_t ticks) {
+  const uint64_t us = timebase_to_us(ticks);
+  uint8_t bucket = us == 0 ? 0 : (uint8_t)(64 - __builtin_clzll(us));
+  if (bucket >= HSM_LATENCY_BUCKETS) {
+    bucket = HSM_LATENCY_BUCKETS - 1;
+  }
+  // single writer: plain increments published with atomic stores for concurrent readers
+  __atomic_store_n(&hist->buckets[bucket], hist->buckets[bucket] + 1, __ATOMIC_RELAXED);
+  const uint32_t clamped = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+  if (clamped > hist->max_us) {
+    __atomic_store_n(&hist->max_us, clamped, __ATOMIC_RELAXED);
+  }
+}
+
+static void record_trace(const enum hsm_trace_kind kind, const enum hsm_event event, const enum hsm_state from, const enum hsm_state to, const uint64_t start, const uint64_t end) {
+  const uint64_t duration = end - start;
+  const struct hsm_trace_record record = {
+    .timestamp = start,
+    .duration = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration,
+    .kind = (uint8_t)kind,
+    .event = (uint8_t)event,
+    .from = (uint8_t)from,
+    .to = (uint8_t)to,
+  };
+  cbuffer_spsc_push(&trace_ring, &record);
+}
+
+static void init_trace(void) {
+  cbuffer_spsc_init(&trace_ring, trace_buffer, sizeof(trace_buffer[0]), HSM_TRACE_LEN);
+  cbuffer_spsc_set_overwrite(&trace_ring);
+  memset(&latency, 0, sizeof(latency));
+}
+
+// state timers
+
+/**
+ * @brief Arm the timer of a state, replacing any pending expiry
+ *
+ * @param[in] state owning state
+ * @param[in] delay_ms delay until the first expiry (ms)
+ * @param[in] periodic re-arm every `delay_ms` until the state exits
+ */
+static void state_timer_start(const enum hsm_state state, const uint32_t delay_ms, const bool periodic) {
+  struct hsm_timer *timer = &ctx.timers[state];
+  timer->period = periodic ? pdMS_TO_TICKS(delay_ms) : 0;
+  twheel_add(&ctx.timer_wheel, &timer->node, xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms));
+}
+
+static bool is_state_timeout(const struct hsm_event_msg *msg, const enum hsm_state state) {
+  return msg->event == HSM_EVENT_TIMEOUT && msg->payload.timeout.state == state;
+}
+
 // root state handlers
 
-static enum event_handle_result handle_event_root(const enum hsm_event event) {
+static enum event_handle_result handle_event_root(const struct hsm_event_msg *msg) {
   enum event_handle_result result = EVENT_UNHANDLED;
-  switch (event) {
+  switch (msg->event) {
+    case HSM_EVENT_STOP:
+    case HSM_EVENT_ABORT:
+    case HSM_EVENT_CLEAR_ERROR:
+      // nothing to stop or clear in the current state
+      result = EVENT_HANDLED;
+      break;
+    case HSM_EVENT_HARD_RESET:
+      // restart from the lamp test from any state
+      ctx.next_state = HSM_STATE_RESET;
+      result = EVENT_HANDLED;
+      break;
     default:
-      warning("Unhandled event %d in state %d", event, ctx.current_state);
+      warning("Unhandled event %d in state %d", msg->event, ctx.current_state);
       dtc_post_event(DTCID_HSM_UNHANDLED_EVENT);
       result = EVENT_HANDLED;
       break;
@@ -130,23 +252,24 @@ static void tick_init(void) {
 
 static void enter_reset(void) {
   info("HSM Reset\n");
+  // a reset forgets where run was interrupted; history is recorded as the old states exit
+  memset(ctx.history, 0, sizeof(ctx.history));
+  // lamp test: every LED on until the reset timer expires
   struct led_context *led_ctx = &ctx.led_ctx[0];
   for (; led_ctx < &ctx.led_ctx[0] + HSM_LED_ID_COUNT; led_ctx++) {
-    led_disable(led_ctx);
+    led_enable(led_ctx);
   }
+  state_timer_start(HSM_STATE_RESET, RESET_LAMP_TEST_MS, false);
 }
 
-static void tick_reset(void) {
-  struct led_context *led_ctx = &ctx.led_ctx[0];
-  for (; led_ctx < &ctx.led_ctx[0] + HSM_LED_ID_COUNT; led_ctx++) {
-    led_toggle(led_ctx);
-  }
-  vTaskDelay(500);
-  for (; led_ctx < &ctx.led_ctx[0] + HSM_LED_ID_COUNT; led_ctx++) {
-    led_toggle(led_ctx);
+static enum event_handle_result handle_event_reset(const struct hsm_event_msg *msg) {
+  enum event_handle_result result = EVENT_UNHANDLED;
+  if (is_state_timeout(msg, HSM_STATE_RESET)) {
+    // todo: perform calibration
+    ctx.next_state = HSM_STATE_INIT;
+    result = EVENT_HANDLED;
   }
-  // todo: perform calibration
-  ctx.next_state = HSM_STATE_INIT;
+  return result;
 }
 
 static void exit_reset(void) {
@@ -161,27 +284,32 @@ static void exit_reset(void) {
 static void enter_idle(void) {
   info("HSM entering idle\n");
   led_enable(&ctx.led_ctx[HSM_LED_ID_IDLE]);
-}
-
-static void tick_idle(void) {
-  led_periodic_toggle(&ctx.led_ctx[HSM_LED_ID_IDLE], IDLE_LED_TOGGLE_RATE_MS);
+  state_timer_start(HSM_STATE_IDLE, IDLE_LED_TOGGLE_RATE_MS, true);
 }
 
 static void exit_idle(void) {
   led_disable(&ctx.led_ctx[HSM_LED_ID_IDLE]);
 }
 
-static enum event_handle_result handle_event_idle(const enum hsm_event event) {
+static enum event_handle_result handle_event_idle(const struct hsm_event_msg *msg) {
   enum event_handle_result result = EVENT_UNHANDLED;
-  switch (event) {
+  switch (msg->event) {
     case HSM_EVENT_RUN:
-      ctx.next_state = HSM_STATE_START;
+      ctx.run_params = msg->payload.run;
+      ctx.next_state = HSM_STATE_RUN_STARTUP;
       result = EVENT_HANDLED;
       break;
     case HSM_EVENT_CALIBRATION:
+      ctx.calibration_params = msg->payload.calibration;
       ctx.next_state = HSM_STATE_CALIBRATION;
       result = EVENT_HANDLED;
       break;
+    case HSM_EVENT_TIMEOUT:
+      if (is_state_timeout(msg, HSM_STATE_IDLE)) {
+        led_toggle(&ctx.led_ctx[HSM_LED_ID_IDLE]);
+        result = EVENT_HANDLED;
+      }
+      break;
     default:
       break;
   }
@@ -193,24 +321,31 @@ static enum event_handle_result handle_event_idle(const enum hsm_event event) {
 static void enter_run(void) {
   info("HSM entering run\n");
   led_enable(&ctx.led_ctx[HSM_LED_ID_RUN]);
-}
-
-static void tick_run(void) {
-  led_toggle(&ctx.led_ctx[HSM_LED_ID_RUN]);
+  state_timer_start(HSM_STATE_RUN, RUN_LED_TOGGLE_RATE_MS, true);
 }
 
 static void exit_run(void) {
   led_disable(&ctx.led_ctx[HSM_LED_ID_RUN]);
 }
 
-static enum event_handle_result handle_event_run(const enum hsm_event event) {
+static enum event_handle_result handle_event_run(const struct hsm_event_msg *msg) {
   enum event_handle_result result = EVENT_UNHANDLED;
-  switch (event) {
+  switch (msg->event) {
     case HSM_EVENT_ABORT:
     case HSM_EVENT_STOP:
       ctx.next_state = HSM_STATE_STOP;
       result = EVENT_HANDLED;
       break;
+    case HSM_EVENT_PAUSE:
+      ctx.next_state = HSM_STATE_PAUSE;
+      result = EVENT_HANDLED;
+      break;
+    case HSM_EVENT_TIMEOUT:
+      if (is_state_timeout(msg, HSM_STATE_RUN)) {
+        led_toggle(&ctx.led_ctx[HSM_LED_ID_RUN]);
+        result = EVENT_HANDLED;
+      }
+      break;
     default:
       break;
   }
@@ -227,7 +362,7 @@ static void tick_run_startup(void) {
 
 static void exit_run_startup(void) {}
 
-static enum event_handle_result handle_event_run_startup(const enum hsm_event event) {
+static enum event_handle_result handle_event_run_startup(const struct hsm_event_msg *msg) {
   return EVENT_UNHANDLED;
 }
 
@@ -239,7 +374,7 @@ static void tick_run_profile(void) {}
 
 static void exit_run_profile(void) {}
 
-static enum event_handle_result handle_event_run_profile(const enum hsm_event event) {
+static enum event_handle_result handle_event_run_profile(const struct hsm_event_msg *msg) {
   return EVENT_UNHANDLED;
 }
 
@@ -257,7 +392,7 @@ static void tick_stop(void) {
 
 static void exit_stop(void) {}
 
-static enum event_handle_result handle_event_stop(const enum hsm_event event) {
+static enum event_handle_result handle_event_stop(const struct hsm_event_msg *msg) {
   return EVENT_UNHANDLED;
 }
 
@@ -279,9 +414,9 @@ static void exit_error(void) {
   led_disable(&ctx.led_ctx[HSM_LED_ID_ERROR]);
 }
 
-static enum event_handle_result handle_event_error(const enum hsm_event event) {
+static enum event_handle_result handle_event_error(const struct hsm_event_msg *msg) {
   enum event_handle_result result = EVENT_UNHANDLED;
-  switch (event) {
+  switch (msg->event) {
     case HSM_EVENT_CLEAR_ERROR:
       ctx.next_state = HSM_STATE_IDLE;
       result = EVENT_HANDLED;
@@ -300,9 +435,9 @@ static void tick_calibration(void) {}
 
 static void exit_calibration(void) {}
 
-static enum event_handle_result handle_event_calibration(const enum hsm_event event) {
+static enum event_handle_result handle_event_calibration(const struct hsm_event_msg *msg) {
   enum event_handle_result result = EVENT_UNHANDLED;
-  switch (event) {
+  switch (msg->event) {
     case HSM_EVENT_ABORT:
     case HSM_EVENT_STOP:
       ctx.next_state = HSM_STATE_IDLE;
@@ -314,105 +449,586 @@ static enum event_handle_result handle_event_calibration(const enum hsm_event ev
   return result;
 }
 
+// pause state handlers
+
+static void enter_pause(void) {
+  info("HSM paused\n");
+}
+
+static enum event_handle_result handle_event_pause(const struct hsm_event_msg *msg) {
+  enum event_handle_result result = EVENT_UNHANDLED;
+  switch (msg->event) {
+    case HSM_EVENT_RESUME:
+      // run resumes in the substate it was paused in
+      ctx.next_state = HSM_STATE_RUN;
+      result = EVENT_HANDLED;
+      break;
+    case HSM_EVENT_ABORT:
+    case HSM_EVENT_STOP:
+      ctx.next_state = HSM_STATE_STOP;
+      result = EVENT_HANDLED;
+      break;
+    default:
+      break;
+  }
+  return result;
+}
+
 // static functions
 
-static void service_event_queue(void) {
-  enum hsm_state current_state = ctx.current_state;
-  enum hsm_event event = HSM_EVENT_NONE;
-  BaseType_t status = xQueueReceive(ctx.event_queue, &event, 0);
-  if (status == pdFALSE) {
+/**
+ * @brief Hold an event back until `state` exits
+ */
+static void defer_event(const enum hsm_state state, struct hsm_event_msg *msg) {
+  if (ctx.deferred_count == HSM_DEFERRED_LEN) {
+    warning("HSM deferred events full, dropping <%i>\n", msg->event);
+    __atomic_fetch_add(&queue_stats.dropped[msg->event], 1, __ATOMIC_RELAXED);
     return;
   }
-  while (current_state != HSM_STATE_ROOT) {
+  hsm_event_ref(msg);
+  ctx.deferred[ctx.deferred_count].msg = msg;
+  ctx.deferred[ctx.deferred_count].state = state;
+  ctx.deferred_count++;
+  __atomic_fetch_add(&queue_stats.deferred[msg->event], 1, __ATOMIC_RELAXED);
+  trace("deferred <%i> in state %d\n", msg->event, state);
+}
+
+/**
+ * @brief Requeue the events deferred by an exiting state ahead of everything posted since. They
+ * are sent to the front newest first so they keep their order.
+ */
+static void recall_deferred(const enum hsm_state state) {
+  for (uint8_t i = ctx.deferred_count; i-- > 0;) {
+    if (ctx.deferred[i].state != state) {
+      continue;
+    }
+    struct hsm_event_msg *msg = ctx.deferred[i].msg;
+    memmove(&ctx.deferred[i], &ctx.deferred[i + 1], (ctx.deferred_count - i - 1) * sizeof(ctx.deferred[0]));
+    ctx.deferred_count--;
+    if (xQueueSendToFront(ctx.event_queue, &msg, 0) != pdTRUE) {
+      warning("HSM event queue full, dropping deferred <%i>\n", msg->event);
+      __atomic_fetch_add(&queue_stats.dropped[msg->event], 1, __ATOMIC_RELAXED);
+      hsm_event_release(msg);
+    }
+  }
+}
+
+/**
+ * @brief Offer an event to the current state and then its ancestors up to the root until one
+ * handles it. An event a state does not handle but lists in its defer mask is deferred by that
+ * state instead of being passed up; the root handles whatever is left.
+ */
+static void dispatch_event(struct hsm_event_msg *msg) {
+  enum hsm_state current_state = ctx.current_state;
+  while (1) {
     const struct state_table_entry *state = &state_table[current_state];
     if (state->handle_event != NULL) {
-      enum event_handle_result result = state->handle_event(event);
+      enum event_handle_result result = state->handle_event(msg);
       if (result == EVENT_HANDLED) {
         break;
       }
     }
+    if (state->defer_mask & (1u << msg->event)) {
+      defer_event(current_state, msg);
+      break;
+    }
+    if (current_state == HSM_STATE_ROOT) {
+      break;
+    }
     current_state = state->parent;
   }
 }
 
-static void exit_state(void) {
-  enum hsm_state state_iterator = ctx.current_state;
-  while (state_iterator != HSM_STATE_ROOT) {
-    const struct state_table_entry *state = &state_table[state_iterator];
+static uint8_t state_depth(enum hsm_state s) {
+  uint8_t depth = 0;
+  for (; s != HSM_STATE_ROOT; s = state_table[s].parent) {
+    depth++;
+  }
+  return depth;
+}
+
+/**
+ * @brief Fill the least common ancestor table from the parent links of the state table. Run once
+ * at start so a transition costs a lookup instead of two walks to the root.
+ */
+static void build_lca_table(void) {
+  for (uint8_t a = 0; a < HSM_STATE_COUNT; a++) {
+    for (uint8_t b = 0; b < HSM_STATE_COUNT; b++) {
+      enum hsm_state x = (enum hsm_state)a;
+      enum hsm_state y = (enum hsm_state)b;
+      uint8_t dx = state_depth(x);
+      uint8_t dy = state_depth(y);
+      for (; dx > dy; dx--) {
+        x = state_table[x].parent;
+      }
+      for (; dy > dx; dy--) {
+        y = state_table[y].parent;
+      }
+      while (x != y) {
+        x = state_table[x].parent;
+        y = state_table[y].parent;
+      }
+      lca_table[a][b] = (uint8_t)x;
+    }
+  }
+}
+
+/**
+ * @brief Exit the current state and its ancestors below `lca`, innermost first
+ */
+static void exit_state(const enum hsm_state lca) {
+  for (enum hsm_state s = ctx.current_state; s != lca; s = state_table[s].parent) {
+    const struct state_table_entry *state = &state_table[s];
     if (state->exit != NULL) {
+      const uint64_t start = timebase_now();
       state->exit();
-      ctx.exit_timestamp = HAL_GetTick();
+      ctx.exit_timestamp = timebase_now();
+      record_latency(&latency.exit[s], ctx.exit_timestamp - start);
+    }
+    twheel_cancel(&ctx.timer_wheel, &ctx.timers[s].node);
+    recall_deferred(s);
+    if (state_table[state->parent].history) {
+      ctx.history[state->parent] = s;
     }
-    state_iterator = state->parent;
   }
 }
 
-static void enter_state(void) {
+/**
+ * @brief Enter the next state and its ancestors below `lca`, outermost first
+ */
+static void enter_state(const enum hsm_state lca) {
+  enum hsm_state path[HSM_STATE_COUNT];
+  uint8_t depth = 0;
+  for (enum hsm_state s = ctx.next_state; s != lca; s = state_table[s].parent) {
+    path[depth++] = s;
+  }
   ctx.current_state = ctx.next_state;
-  enum hsm_state state_iterator = ctx.current_state;
-  while (state_iterator != HSM_STATE_ROOT) {
-    const struct state_table_entry *state = &state_table[state_iterator];
+  const TickType_t now = xTaskGetTickCount();
+  while (depth > 0) {
+    const enum hsm_state s = path[--depth];
+    const struct state_table_entry *state = &state_table[s];
     if (state->enter != NULL) {
-      ctx.enter_timestamp = HAL_GetTick();
+      ctx.enter_timestamp = timebase_now();
       state->enter();
+      record_latency(&latency.enter[s], timebase_now() - ctx.enter_timestamp);
     }
-    state_iterator = state->parent;
+    // entered states tick straight away, states kept across the transition stay on schedule
+    ctx.tick_deadline[s] = now;
   }
 }
 
+/**
+ * @brief Resolve a transition target to the leaf state it enters: a composite target enters its
+ * last active substate if it keeps history and has one, else its initial substate
+ */
+static enum hsm_state resolve_target(enum hsm_state target) {
+  while (state_table[target].initial != HSM_STATE_ROOT) {
+    const enum hsm_state history = ctx.history[target];
+    target = state_table[target].history && history != HSM_STATE_ROOT ? history : state_table[target].initial;
+  }
+  return target;
+}
+
+static void transition(void) {
+  ctx.next_state = resolve_target(ctx.next_state);
+  if (ctx.current_state != ctx.next_state) {
+    const enum hsm_state lca = (enum hsm_state)lca_table[ctx.current_state][ctx.next_state];
+    exit_state(lca);
+    enter_state(lca);
+  }
+}
+
+/**
+ * @brief Release every deferred event, counting it as dropped
+ */
+static void flush_deferred(void) {
+  for (uint8_t i = 0; i < ctx.deferred_count; i++) {
+    struct hsm_event_msg *msg = ctx.deferred[i].msg;
+    trace("discarding deferred <%i>\n", msg->event);
+    __atomic_fetch_add(&queue_stats.dropped[msg->event], 1, __ATOMIC_RELAXED);
+    hsm_event_release(msg);
+  }
+  ctx.deferred_count = 0;
+}
+
+/**
+ * @brief Note an event leaving its queue: if it is the newest event of the queue nothing queued
+ * is left to merge a post into
+ */
+static void consume_tail(const enum queue_lane lane, const struct hsm_event_msg *msg) {
+  uint32_t tail = __atomic_load_n(&queue_tail[lane], __ATOMIC_RELAXED);
+  // moving the ticket on also stops a post still in flight from publishing this event as queued
+  while (TAIL_TICKET(tail) == msg->queue_ticket &&
+         !__atomic_compare_exchange_n(&queue_tail[lane], &tail, TAIL_PACK(TAIL_TICKET(tail) + 1, TAIL_INFLIGHT(tail), HSM_EVENT_NONE), true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+  }
+}
+
+/**
+ * @brief Dispatch an event taken off a queue, run the transition it requested and release it.
+ * ABORT, HARD_RESET and STOP first discard the deferred requests, and a request posted before an
+ * abort that has already been handled is discarded instead of dispatched.
+ */
+static void process_event(const enum queue_lane lane, struct hsm_event_msg *msg) {
+  const enum hsm_event event = msg->event;
+  const enum hsm_state from = ctx.current_state;
+  consume_tail(lane, msg);
+  if ((REQUEST_EVENTS & (1u << event)) && (int32_t)(msg->abort_epoch - ctx.abort_epoch) < 0) {
+    trace("discarding <%i> posted before an abort\n", event);
+    __atomic_fetch_add(&queue_stats.dropped[event], 1, __ATOMIC_RELAXED);
+    hsm_event_release(msg);
+    return;
+  }
+  if (lane == QUEUE_LANE_PRIORITY) {
+    // adopt the global epoch: aborts merged into this one were counted after it was stamped
+    ctx.abort_epoch = __atomic_load_n(&abort_epoch, __ATOMIC_SEQ_CST);
+  }
+  if (FLUSH_DEFERRED_EVENTS & (1u << event)) {
+    flush_deferred();
+  }
+  const uint64_t start = timebase_now();
+  record_latency(&latency.queue_wait[event], start - msg->post_timestamp);
+  dispatch_event(msg);
+  hsm_event_release(msg);
+  transition();
+  const uint64_t end = timebase_now();
+  record_latency(&latency.dispatch[event], end - start);
+  record_trace(HSM_TRACE_EVENT, event, from, ctx.current_state, start, end);
+}
+
+/**
+ * @brief Block for the first event up to `wait` ticks, then drain every event already queued.
+ * Each event is handled in the state left by the one before it. The priority queue is drained
+ * before every event of the event queue, so ABORT and HARD_RESET overtake events queued ahead of
+ * them; posting one also queues a NULL wakeup in case the task is blocked on an empty queue.
+ */
+static void service_event_queue(TickType_t wait) {
+  struct hsm_event_msg *msg = NULL;
+  while (xQueueReceive(ctx.event_queue, &msg, wait) == pdTRUE) {
+    struct hsm_event_msg *urgent = NULL;
+    while (xQueueReceive(ctx.priority_queue, &urgent, 0) == pdTRUE) {
+      process_event(QUEUE_LANE_PRIORITY, urgent);
+    }
+    if (msg != NULL) {
+      process_event(QUEUE_LANE_EVENT, msg);
+    }
+    wait = 0;
+  }
+}
+
+/**
+ * @brief Ticks until the next active state is due for a tick
+ *
+ * @param[in] now current tick count
+ * @return ticks to wait, 0 if a tick is due or portMAX_DELAY if no active state ticks
+ */
+static TickType_t next_tick_wait(const TickType_t now) {
+  TickType_t wait = portMAX_DELAY;
+  for (enum hsm_state s = ctx.current_state; s != HSM_STATE_ROOT; s = state_table[s].parent) {
+    if (state_table[s].tick == NULL || state_table[s].tick_period_ms == 0) {
+      continue;
+    }
+    const int32_t remaining = (int32_t)(ctx.tick_deadline[s] - now);
+    if (remaining <= 0) {
+      return 0;
+    }
+    if ((TickType_t)remaining < wait) {
+      wait = (TickType_t)remaining;
+    }
+  }
+  return wait;
+}
+
+/**
+ * @brief Tick every active state that is due, innermost first
+ *
+ * @param[in] now current tick count
+ */
+static void tick_states(const TickType_t now) {
+  for (enum hsm_state s = ctx.current_state; s != HSM_STATE_ROOT; s = state_table[s].parent) {
+    const struct state_table_entry *state = &state_table[s];
+    if (state->tick == NULL || state->tick_period_ms == 0 || (int32_t)(ctx.tick_deadline[s] - now) > 0) {
+      continue;
+    }
+    ctx.tick_deadline[s] = now + pdMS_TO_TICKS(state->tick_period_ms);
+    const uint64_t start = timebase_now();
+    state->tick();
+    const uint64_t end = timebase_now();
+    record_latency(&latency.tick[s], end - start);
+    record_trace(HSM_TRACE_TICK, HSM_EVENT_NONE, s, ctx.next_state, start, end);
+  }
+}
+
+/**
+ * @brief Ticks until the next state timer expires
+ *
+ * @param[in] now current tick count
+ * @return ticks to wait, 0 if a timer is due or portMAX_DELAY if no timer is armed
+ */
+static TickType_t next_timer_wait(const TickType_t now) {
+  uint32_t expires;
+  if (!twheel_next_expiry(&ctx.timer_wheel, &expires)) {
+    return portMAX_DELAY;
+  }
+  const int32_t remaining = (int32_t)(expires - now);
+  return remaining > 0 ? (TickType_t)remaining : 0;
+}
+
+/**
+ * @brief Dispatch a state timer expiry as HSM_EVENT_TIMEOUT. The event is internal and handled
+ * synchronously, so it is built on the stack instead of taking a pool event; no state defers it.
+ */
+static void on_timer_expired(struct twheel_timer *node, void *__attribute__((unused)) arg) {
+  struct hsm_timer *timer = (struct hsm_timer *)node;
+  if (timer->period != 0) {
+    // re-arm from the previous expiry so periodic timers do not drift
+    twheel_add(&ctx.timer_wheel, node, node->expires + timer->period);
+  }
+  const enum hsm_state from = ctx.current_state;
+  const uint64_t start = timebase_now();
+  struct hsm_event_msg msg = {
+    .event = HSM_EVENT_TIMEOUT,
+    .refcount = 1,
+    .post_timestamp = start,
+    .payload.timeout.state = (enum hsm_state)(timer - ctx.timers),
+  };
+  dispatch_event(&msg);
+  transition();
+  const uint64_t end = timebase_now();
+  record_latency(&latency.dispatch[HSM_EVENT_TIMEOUT], end - start);
+  record_trace(HSM_TRACE_EVENT, HSM_EVENT_TIMEOUT, from, ctx.current_state, start, end);
+}
+
+static void expire_timers(const TickType_t now) {
+  twheel_advance(&ctx.timer_wheel, now, on_timer_expired, NULL);
+}
+
 static void hsm_main(void* __attribute__((unused)) argument) {
   info("Starting HSM\n");
+  // enter the initial state here so its timers start with the task
+  enter_state(HSM_STATE_ROOT);
   while (1) {
-    service_event_queue();
-    if (ctx.current_state != ctx.next_state) {
-      exit_state();
-      enter_state();
+    // sleep until an event arrives, a state timer expires or the next state tick is due
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t tick_wait = next_tick_wait(now);
+    const TickType_t timer_wait = next_timer_wait(now);
+    service_event_queue(tick_wait < timer_wait ? tick_wait : timer_wait);
+    expire_timers(xTaskGetTickCount());
+    tick_states(xTaskGetTickCount());
+    transition();
+  }
+}
+
+struct hsm_event_msg *hsm_event_alloc(const enum hsm_event event) {
+  uint32_t free_mask = __atomic_load_n(&event_pool_free, __ATOMIC_RELAXED);
+  uint32_t slot;
+  do {
+    if (free_mask == 0) {
+      return NULL;
     }
-    enum hsm_state current_state = ctx.current_state;
-    while (current_state != HSM_STATE_ROOT) {
-      const struct state_table_entry *state = &state_table[current_state];
-      if (state->tick != NULL) {
-        state->tick();
+    slot = (uint32_t)__builtin_ctz(free_mask);
+  } while (!__atomic_compare_exchange_n(&event_pool_free, &free_mask, free_mask & ~(1u << slot), true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+  struct hsm_event_msg *msg = &event_pool[slot];
+  memset(msg, 0, sizeof(*msg));
+  msg->event = event;
+  msg->refcount = 1;
+  return msg;
+}
+
+void hsm_event_ref(struct hsm_event_msg *msg) {
+  uassert(msg != NULL);
+  __atomic_fetch_add(&msg->refcount, 1, __ATOMIC_RELAXED);
+}
+
+void hsm_event_release(struct hsm_event_msg *msg) {
+  uassert(msg != NULL);
+  uassert(msg >= &event_pool[0] && msg < &event_pool[HSM_EVENT_POOL_SIZE]);
+  if (__atomic_sub_fetch(&msg->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+    // publish the event's last use before it can be reallocated
+    __atomic_fetch_or(&event_pool_free, 1u << (uint32_t)(msg - event_pool), __ATOMIC_RELEASE);
+  }
+}
+
+uint8_t hsm_event_pool_available(void) {
+  return (uint8_t)__builtin_popcount(__atomic_load_n(&event_pool_free, __ATOMIC_RELAXED));
+}
+
+static bool is_priority_event(const enum hsm_event event) {
+  return event == HSM_EVENT_ABORT || event == HSM_EVENT_HARD_RESET;
+}
+
+/**
+ * @brief Merge an event into the newest event of its queue if that is an identical event still
+ * queued, else reserve the tail of the queue for it and stamp it for cancellation by an abort
+ *
+ * @param[in] lane queue the event is posted to
+ * @param[in] msg pooled event
+ * @return true if the event was merged and the caller's reference released
+ */
+static bool reserve_tail(const enum queue_lane lane, struct hsm_event_msg *msg) {
+  const bool coalesce = (HSM_EVENT_COALESCE_MASK & (1u << msg->event)) != 0;
+  uint32_t tail = __atomic_load_n(&queue_tail[lane], __ATOMIC_RELAXED);
+  uint32_t next;
+  for (;;) {
+    if (coalesce && TAIL_INFLIGHT(tail) == 0 && TAIL_EVENT(tail) == msg->event) {
+      if (lane == QUEUE_LANE_PRIORITY) {
+        // a merged abort must still cancel the requests posted since the queued one: bump the
+        // epoch the queued abort adopts, then check it has not been taken off the queue meanwhile
+        __atomic_add_fetch(&abort_epoch, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_compare_exchange_n(&queue_tail[lane], &tail, tail, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+          continue;
+        }
       }
-      current_state = state->parent;
+      __atomic_fetch_add(&queue_stats.coalesced[msg->event], 1, __ATOMIC_RELAXED);
+      hsm_event_release(msg);
+      return true;
+    }
+    next = TAIL_PACK(TAIL_TICKET(tail) + 1, TAIL_INFLIGHT(tail) + 1, HSM_EVENT_NONE);
+    if (__atomic_compare_exchange_n(&queue_tail[lane], &tail, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      break;
     }
-    vTaskDelay(ctx.hsm_tick_rate_ms);
   }
+  msg->queue_ticket = TAIL_TICKET(next);
+  if (lane == QUEUE_LANE_PRIORITY) {
+    msg->abort_epoch = __atomic_add_fetch(&abort_epoch, 1, __ATOMIC_SEQ_CST);
+  } else {
+    msg->abort_epoch = __atomic_load_n(&abort_epoch, __ATOMIC_RELAXED);
+  }
+  return false;
 }
 
-enum hsm_status hsm_post_event_isr(const enum hsm_event *event, bool* req_ctx_switch) {
+/**
+ * @brief End a post reserved by `reserve_tail`. A queued event becomes the newest event of its
+ * queue only if no other post started since its reservation and it has not been taken off the
+ * queue already; otherwise nothing can be merged until the next post.
+ *
+ * @param[in] lane queue the event was posted to
+ * @param[in] ticket ticket of the reservation
+ * @param[in] event posted event
+ * @param[in] queued the queue accepted the event
+ */
+static void publish_tail(const enum queue_lane lane, const uint16_t ticket, const enum hsm_event event, const bool queued) {
+  uint32_t tail = __atomic_load_n(&queue_tail[lane], __ATOMIC_RELAXED);
+  uint32_t next;
+  do {
+    const uint32_t inflight = TAIL_INFLIGHT(tail) - 1;
+    const bool newest = queued && inflight == 0 && TAIL_TICKET(tail) == ticket;
+    next = TAIL_PACK(TAIL_TICKET(tail), inflight, newest ? event : HSM_EVENT_NONE);
+  } while (!__atomic_compare_exchange_n(&queue_tail[lane], &tail, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void drop_event(struct hsm_event_msg *msg) {
+  __atomic_fetch_add(&queue_stats.dropped[msg->event], 1, __ATOMIC_RELAXED);
+  hsm_event_release(msg);
+}
+
+enum hsm_status hsm_post_event_isr(struct hsm_event_msg *msg, bool* req_ctx_switch) {
   enum hsm_status status = HSM_STATUS_EVE_QUEUE_FULL;
   BaseType_t ctx_switch = pdFALSE;
-  uassert(event != NULL);
+  uassert(msg != NULL);
   uassert(req_ctx_switch != NULL);
   *req_ctx_switch = false;
-  BaseType_t code = xQueueSendFromISR(ctx.event_queue, event, &ctx_switch);
+  const enum hsm_event event = msg->event;
+  const enum queue_lane lane = is_priority_event(event) ? QUEUE_LANE_PRIORITY : QUEUE_LANE_EVENT;
+  if (reserve_tail(lane, msg)) {
+    return HSM_STATUS_OK;
+  }
+  // the HSM may release the event as soon as it is queued
+  const uint16_t ticket = msg->queue_ticket;
+  msg->post_timestamp = timebase_now();
+  BaseType_t code;
+  if (lane == QUEUE_LANE_PRIORITY) {
+    code = xQueueSendFromISR(ctx.priority_queue, &msg, &ctx_switch);
+    if (code == pdTRUE) {
+      // a full event queue already keeps the task awake
+      BaseType_t wakeup_switch = pdFALSE;
+      (void)xQueueSendToFrontFromISR(ctx.event_queue, &priority_wakeup, &wakeup_switch);
+      ctx_switch |= wakeup_switch;
+    }
+  } else {
+    code = xQueueSendFromISR(ctx.event_queue, &msg, &ctx_switch);
+  }
+  publish_tail(lane, ticket, event, code == pdTRUE);
   if (ctx_switch == pdTRUE) {
     *req_ctx_switch = true;
   }
   if (code == pdTRUE) {
     status = HSM_STATUS_OK;
+  } else {
+    drop_event(msg);
   }
   return status;
 }
 
-enum hsm_status hsm_post_event(const enum hsm_event *event, const uint16_t wait_ms) {
+enum hsm_status hsm_post_event(struct hsm_event_msg *msg, const uint16_t wait_ms) {
   enum hsm_status status = HSM_STATUS_EVE_QUEUE_FULL;
-  uassert(event != NULL);
-  BaseType_t resp = xQueueSend(ctx.event_queue, event, pdMS_TO_TICKS(wait_ms));
+  uassert(msg != NULL);
+  const enum hsm_event event = msg->event;
+  const enum queue_lane lane = is_priority_event(event) ? QUEUE_LANE_PRIORITY : QUEUE_LANE_EVENT;
+  if (reserve_tail(lane, msg)) {
+    trace("coalesced <%i> with the queued HSM event\n", event);
+    return HSM_STATUS_OK;
+  }
+  // the HSM may release the event as soon as it is queued
+  const uint16_t ticket = msg->queue_ticket;
+  msg->post_timestamp = timebase_now();
+  BaseType_t resp;
+  if (lane == QUEUE_LANE_PRIORITY) {
+    resp = xQueueSend(ctx.priority_queue, &msg, pdMS_TO_TICKS(wait_ms));
+    if (resp == pdTRUE) {
+      // a full event queue already keeps the task awake
+      (void)xQueueSendToFront(ctx.event_queue, &priority_wakeup, 0);
+    }
+  } else {
+    resp = xQueueSend(ctx.event_queue, &msg, pdMS_TO_TICKS(wait_ms));
+  }
+  publish_tail(lane, ticket, event, resp == pdTRUE);
   if (resp == pdTRUE) {
     info("posted <%i> to HSM event queue\n", event);
     status = HSM_STATUS_OK;
   } else {
     warning("failed to post <%i> to HSM event queue waiting: %u ms\n", event, wait_ms);
+    drop_event(msg);
   }
   return status;
 }
 
+enum hsm_status hsm_post(const enum hsm_event event, const uint16_t wait_ms) {
+  struct hsm_event_msg *msg = hsm_event_alloc(event);
+  if (msg == NULL) {
+    warning("HSM event pool exhausted posting <%i>\n", event);
+    __atomic_fetch_add(&queue_stats.dropped[event], 1, __ATOMIC_RELAXED);
+    return HSM_STATUS_EVE_POOL_EMPTY;
+  }
+  return hsm_post_event(msg, wait_ms);
+}
+
 enum hsm_state hsm_get_current_state(void) {
   return ctx.current_state;
 }
 
+size_t hsm_trace_snapshot(struct hsm_trace_record *records, const size_t n) {
+  uassert(records != NULL);
+  return cbuffer_spsc_snapshot(&trace_ring, records, n);
+}
+
+void hsm_latency_snapshot(struct hsm_latency_stats *stats) {
+  uassert(stats != NULL);
+  const uint32_t *src = (const uint32_t *)&latency;
+  uint32_t *dst = (uint32_t *)stats;
+  for (size_t i = 0; i < sizeof(latency) / sizeof(uint32_t); i++) {
+    dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+  }
+}
+
+void hsm_queue_stats_snapshot(struct hsm_queue_stats *stats) {
+  uassert(stats != NULL);
+  for (uint8_t i = 0; i < HSM_EVENT_COUNT; i++) {
+    stats->coalesced[i] = __atomic_load_n(&queue_stats.coalesced[i], __ATOMIC_RELAXED);
+    stats->dropped[i] = __atomic_load_n(&queue_stats.dropped[i], __ATOMIC_RELAXED);
+    stats->deferred[i] = __atomic_load_n(&queue_stats.deferred[i], __ATOMIC_RELAXED);
+  }
+}
+
 void hsm_start(const struct system_task_context *task_ctx) {
   // header guards
   uassert(task_ctx != NULL);
@@ -425,11 +1041,21 @@ void hsm_start(const struct system_task_context *task_ctx) {
     led_init(&ctx.led_ctx[i], &init->led_init_ctx[i]);
   }
   ctx.current_state = HSM_STATE_RESET;
-  ctx.hsm_tick_rate_ms = HSM_DEFAULT_TICK_RATE_MS;
   ctx.next_state = HSM_STATE_RESET;
+  memset(ctx.tick_deadline, 0, sizeof(ctx.tick_deadline));
+  memset(ctx.history, 0, sizeof(ctx.history));
+  ctx.deferred_count = 0;
+  build_lca_table();
+  init_trace();
+  twheel_init(&ctx.timer_wheel, xTaskGetTickCount());
+  for (uint8_t i = 0; i < HSM_STATE_COUNT; i++) {
+    twheel_timer_init(&ctx.timers[i].node);
+  }
   ctx.enter_timestamp = 0;
-  ctx.event_queue = xQueueCreateStatic(sizeof(ctx.event_queue_buffer), sizeof(enum hsm_event), ctx.event_queue_buffer, &ctx.event_queue_ctrl);
+  ctx.event_queue = xQueueCreateStatic(HSM_EVENT_QUEUE_LEN, sizeof(struct hsm_event_msg *), ctx.event_queue_buffer, &ctx.event_queue_ctrl);
   uassert(ctx.event_queue != NULL);
+  ctx.priority_queue = xQueueCreateStatic(HSM_PRIORITY_QUEUE_LEN, sizeof(struct hsm_event_msg *), ctx.priority_queue_buffer, &ctx.priority_queue_ctrl);
+  uassert(ctx.priority_queue != NULL);
 
   // start task
   BaseType_t ret = xTaskCreate(hsm_main, task_ctx->name, task_ctx->stack_size, NULL, task_ctx->priority, &ctx.task_handle);
@@ -447,15 +1073,63 @@ TaskFunction_t test_hsm_get_main(void) {
 }
 
 void test_hsm_service_event_queue(void) {
-  service_event_queue();
+  service_event_queue(0);
+}
+
+TickType_t test_hsm_next_tick_wait(const TickType_t now) {
+  return next_tick_wait(now);
+}
+
+void test_hsm_tick_states(const TickType_t now) {
+  tick_states(now);
 }
 
 void test_hsm_enter_state(void) {
-  enter_state();
+  enter_state((enum hsm_state)lca_table[ctx.current_state][ctx.next_state]);
 }
 
 void test_hsm_exit_state(void) {
-  exit_state();
+  exit_state((enum hsm_state)lca_table[ctx.current_state][ctx.next_state]);
+}
+
+void test_hsm_transition(void) {
+  transition();
+}
+
+TickType_t test_hsm_next_timer_wait(const TickType_t now) {
+  return next_timer_wait(now);
+}
+
+void test_hsm_expire_timers(const TickType_t now) {
+  expire_timers(now);
+}
+
+void test_hsm_reset_timers(void) {
+  twheel_init(&ctx.timer_wheel, 0);
+  for (uint8_t i = 0; i < HSM_STATE_COUNT; i++) {
+    twheel_timer_init(&ctx.timers[i].node);
+  }
+}
+
+void test_hsm_reset_trace(void) {
+  init_trace();
+}
+
+void test_hsm_build_lca_table(void) {
+  build_lca_table();
+}
+
+enum hsm_state test_hsm_lca(const enum hsm_state a, const enum hsm_state b) {
+  return (enum hsm_state)lca_table[a][b];
+}
+
+void test_hsm_reset_event_pool(void) {
+  memset(event_pool, 0, sizeof(event_pool));
+  event_pool_free = (1u << HSM_EVENT_POOL_SIZE) - 1;
+  memset(queue_tail, 0, sizeof(queue_tail));
+  abort_epoch = 0;
+  ctx.abort_epoch = 0;
+  memset(&queue_stats, 0, sizeof(queue_stats));
 }
 
 #endif // UNITTEST
@@ -12,13 +12,19 @@
 #include "dtc.h"
 #include "led.h"
 #include "system.h"
+#include "twheel.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <FreeRTOS.h>
 #include <queue.h>
 
-#define HSM_DEFAULT_TICK_RATE_MS 10
-#define HSM_EVENT_QUEUE_SIZE 5 * sizeof(enum hsm_event)
+#define HSM_EVENT_QUEUE_LEN 5
+#define HSM_PRIORITY_QUEUE_LEN 2
+#define HSM_DEFERRED_LEN 4
+#define HSM_EVENT_POOL_SIZE 8
+#define HSM_TRACE_LEN 64
+#define HSM_LATENCY_BUCKETS 16
 
 enum hsm_led_id {
   HSM_LED_ID_ERROR,
@@ -35,6 +41,7 @@ enum hsm_led_id {
 enum hsm_status {
   HSM_STATUS_OK,
   HSM_STATUS_EVE_QUEUE_FULL,
+  HSM_STATUS_EVE_POOL_EMPTY,
   HSM_STATUS_COUNT,
 };
 
@@ -50,9 +57,20 @@ enum hsm_event {
   HSM_EVENT_ABORT,
   HSM_EVENT_CLEAR_ERROR,
   HSM_EVENT_CALIBRATION,
+  HSM_EVENT_PAUSE,
+  HSM_EVENT_RESUME,
+  HSM_EVENT_TIMEOUT, // state timer expiry (internal)
   HSM_EVENT_COUNT
 };
 
+// events posted while an identical one is still queued are merged into it: one bit per enum
+// hsm_event, 0 disables coalescing. Events carrying a payload are left out by default.
+#ifndef HSM_EVENT_COALESCE_MASK
+#define HSM_EVENT_COALESCE_MASK                                                                                   \
+  ((1u << HSM_EVENT_SOFT_RESET) | (1u << HSM_EVENT_HARD_RESET) | (1u << HSM_EVENT_STOP) | (1u << HSM_EVENT_ABORT) | \
+   (1u << HSM_EVENT_CLEAR_ERROR) | (1u << HSM_EVENT_PAUSE) | (1u << HSM_EVENT_RESUME))
+#endif
+
 /**
  * @brief HSM states
  */
@@ -67,6 +85,7 @@ enum hsm_state {
   HSM_STATE_STOP,
   HSM_STATE_ERROR,
   HSM_STATE_CALIBRATION,
+  HSM_STATE_PAUSE,
 
   // run substates
   HSM_STATE_RUN_STARTUP,
@@ -79,6 +98,108 @@ enum hsm_state {
   HSM_STATE_COUNT
 };
 
+/**
+ * @brief HSM_EVENT_RUN payload
+ */
+struct hsm_run_params {
+  uint16_t profile_id; // motor profile to run
+  float setpoint;      // target setpoint in profile units
+};
+
+/**
+ * @brief HSM_EVENT_CALIBRATION payload
+ */
+struct hsm_calibration_params {
+  uint8_t channel; // ESC channel to calibrate
+  float trim;      // trim offset
+  float scale;     // scale factor
+};
+
+/**
+ * @brief HSM_EVENT_TIMEOUT payload
+ */
+struct hsm_timeout_params {
+  enum hsm_state state; // state whose timer expired
+};
+
+/**
+ * @brief Pooled HSM event. Events are allocated from a fixed size static pool and only pointers
+ * travel through the event queue, so payloads are never copied. Each holder owns a reference; the
+ * event returns to the pool when the last reference is released.
+ */
+struct hsm_event_msg {
+  enum hsm_event event;
+  uint8_t refcount;
+  uint64_t post_timestamp; // timebase ticks when posted
+  uint16_t queue_ticket;   // queue position stamp (internal)
+  uint32_t abort_epoch;    // aborts posted before this event (internal)
+  union {
+    struct hsm_run_params run;
+    struct hsm_calibration_params calibration;
+    struct hsm_timeout_params timeout;
+  } payload;
+};
+
+/**
+ * @brief State timer. Each state owns one timer in the HSM timer wheel; it is cancelled when the
+ * state exits and its expiry is dispatched as HSM_EVENT_TIMEOUT.
+ */
+struct hsm_timer {
+  struct twheel_timer node;
+  TickType_t period; // re-armed period (ticks), 0 for one shot
+};
+
+enum hsm_trace_kind {
+  HSM_TRACE_EVENT, // event dispatch including the transition it caused
+  HSM_TRACE_TICK,  // state tick
+};
+
+/**
+ * @brief HSM trace record. Times are timebase ticks.
+ */
+struct hsm_trace_record {
+  uint64_t timestamp; // handler start
+  uint32_t duration;  // handler duration (saturated)
+  uint8_t kind;       // enum hsm_trace_kind
+  uint8_t event;      // enum hsm_event, HSM_EVENT_NONE for ticks
+  uint8_t from;       // enum hsm_state the handler ran in
+  uint8_t to;         // enum hsm_state after the handler
+};
+
+/**
+ * @brief Latency histogram with log2 microsecond buckets: bucket 0 counts samples under 1 us,
+ * bucket i counts [2^(i-1), 2^i) us and the last bucket also counts everything longer.
+ */
+struct hsm_latency_hist {
+  uint32_t buckets[HSM_LATENCY_BUCKETS];
+  uint32_t max_us;
+};
+
+struct hsm_latency_stats {
+  struct hsm_latency_hist queue_wait[HSM_EVENT_COUNT]; // post to dispatch
+  struct hsm_latency_hist dispatch[HSM_EVENT_COUNT];   // handlers and the transition they caused
+  struct hsm_latency_hist tick[HSM_STATE_COUNT];       // tick callback
+  struct hsm_latency_hist enter[HSM_STATE_COUNT];      // enter callback
+  struct hsm_latency_hist exit[HSM_STATE_COUNT];       // exit callback
+};
+
+/**
+ * @brief Event queue counters per event
+ */
+struct hsm_queue_stats {
+  uint32_t coalesced[HSM_EVENT_COUNT]; // merged into an identical queued event
+  uint32_t dropped[HSM_EVENT_COUNT];   // rejected by a full queue or an empty pool, or discarded by an abort or stop
+  uint32_t deferred[HSM_EVENT_COUNT];  // held back by a state until it exits
+};
+
+/**
+ * @brief Event held back by the state that deferred it
+ */
+struct hsm_deferred_event {
+  struct hsm_event_msg *msg;
+  enum hsm_state state;
+};
+
 struct hsm_init_context {
   const struct led_init_context led_init_ctx[HSM_LED_ID_COUNT];
   const size_t num_led_init_ctx;
@@ -88,13 +209,24 @@ struct hsm_context {
   enum hsm_state current_state;
   enum hsm_state next_state;
   enum DTCID pending_dtc;
-  uint32_t enter_timestamp;
-  uint32_t exit_timestamp;
-  uint32_t hsm_tick_rate_ms;
-  uint8_t event_queue_buffer[HSM_EVENT_QUEUE_SIZE];
+  uint64_t enter_timestamp; // timebase ticks
+  uint64_t exit_timestamp;  // timebase ticks
+  TickType_t tick_deadline[HSM_STATE_COUNT]; // next tick of each active state
+  struct twheel timer_wheel;
+  struct hsm_timer timers[HSM_STATE_COUNT];
+  enum hsm_state history[HSM_STATE_COUNT]; // last active substate of each history state, ROOT if none
+  struct hsm_deferred_event deferred[HSM_DEFERRED_LEN]; // oldest first
+  uint8_t deferred_count;
+  uint32_t abort_epoch; // epoch of the last ABORT or HARD_RESET handled
+  struct hsm_run_params run_params;                 // parameters of the last accepted run
+  struct hsm_calibration_params calibration_params; // parameters of the last accepted calibration
+  uint8_t event_queue_buffer[HSM_EVENT_QUEUE_LEN * sizeof(struct hsm_event_msg *)];
   TaskHandle_t task_handle;
   StaticQueue_t event_queue_ctrl;
   QueueHandle_t event_queue;
+  uint8_t priority_queue_buffer[HSM_PRIORITY_QUEUE_LEN * sizeof(struct hsm_event_msg *)];
+  StaticQueue_t priority_queue_ctrl;
+  QueueHandle_t priority_queue; // ABORT and HARD_RESET, serviced before the event queue
   struct led_context led_ctx[HSM_LED_ID_COUNT];
 };
 
@@ -113,30 +245,110 @@ void hsm_start(const struct system_task_context *task_ctx);
 enum hsm_state hsm_get_current_state(void);
 
 /**
- * @brief Post an event to the HSM event queue
+ * @brief Copy the most recent HSM trace records, oldest first. The trace is always on and is read
+ * without stopping or locking the HSM; callable from any task.
+ *
+ * @param[out] records record storage
+ * @param[in] n maximum number of records (at most HSM_TRACE_LEN are kept)
+ * @return number of records copied
+ */
+size_t hsm_trace_snapshot(struct hsm_trace_record *records, const size_t n);
+
+/**
+ * @brief Copy the HSM latency histograms without stopping the HSM. Counters are read one at a
+ * time, so a sample recorded during the copy may appear in one histogram and not another.
+ *
+ * @param[out] stats histogram storage
+ */
+void hsm_latency_snapshot(struct hsm_latency_stats *stats);
+
+/**
+ * @brief Copy the event queue counters. Callable from any task.
+ *
+ * @param[out] stats counter storage
+ */
+void hsm_queue_stats_snapshot(struct hsm_queue_stats *stats);
+
+/**
+ * @brief Allocate an event from the static event pool with a single reference. Lock-free and ISR
+ * safe.
+ *
+ * @param[in] event HSM event
+ * @return pooled event with a zeroed payload or NULL if the pool is exhausted
+ */
+struct hsm_event_msg *hsm_event_alloc(const enum hsm_event event);
+
+/**
+ * @brief Take an additional reference to a pooled event. ISR safe.
+ *
+ * @param[in] msg pooled event
+ */
+void hsm_event_ref(struct hsm_event_msg *msg);
+
+/**
+ * @brief Release a reference to a pooled event, returning it to the pool on the last one. ISR safe.
+ *
+ * @param[in] msg pooled event
+ */
+void hsm_event_release(struct hsm_event_msg *msg);
+
+/**
+ * @brief Number of free events in the pool
+ *
+ * @return free event count
+ */
+uint8_t hsm_event_pool_available(void);
+
+/**
+ * @brief Post an event to the HSM event queue. The caller's reference is handed over: the HSM
+ * releases it once the event is handled, or it is released here if the queue is full. ABORT and
+ * HARD_RESET go to the priority queue and are handled before any event queued ahead of them. An
+ * event in HSM_EVENT_COALESCE_MASK that is already queued is merged into the queued one and
+ * reports success.
  * 
  * @warning not ISR safe -> use `hsm_post_event_isr`
- * @param[in] event HSM event pointer
+ * @param[in] msg pooled event from `hsm_event_alloc`
  * @param[in] wait_ms millis to block waiting for queue space.
  * @return hsm status code
  */
-enum hsm_status hsm_post_event(const enum hsm_event *event, const uint16_t wait_ms);
+enum hsm_status hsm_post_event(struct hsm_event_msg *msg, const uint16_t wait_ms);
 
 /**
- * @brief ISR safe post to HSM event queue
+ * @brief ISR safe post to HSM event queue. The caller's reference is handed over, and the event
+ * routed and coalesced, as for `hsm_post_event`.
  * 
- * @param[in] event HSM event pointer
+ * @param[in] msg pooled event from `hsm_event_alloc`
  * @param[out] req_ctx_switch caller is required to perform a context switch
  * @return hsm status code
  */
-enum hsm_status hsm_post_event_isr(const enum hsm_event *event, bool* req_ctx_switch);
+enum hsm_status hsm_post_event_isr(struct hsm_event_msg *msg, bool* req_ctx_switch);
+
+/**
+ * @brief Allocate and post an event without a payload
+ *
+ * @warning not ISR safe
+ * @param[in] event HSM event
+ * @param[in] wait_ms millis to block waiting for queue space.
+ * @return hsm status code
+ */
+enum hsm_status hsm_post(const enum hsm_event event, const uint16_t wait_ms);
 
 #ifdef UNITTEST
 struct hsm_context *test_hsm_get_context(void);
 TaskFunction_t test_hsm_get_main(void);
 void test_hsm_service_event_queue(void);
+TickType_t test_hsm_next_tick_wait(const TickType_t now);
+void test_hsm_tick_states(const TickType_t now);
 void test_hsm_enter_state(void);
 void test_hsm_exit_state(void);
+void test_hsm_transition(void);
+TickType_t test_hsm_next_timer_wait(const TickType_t now);
+void test_hsm_expire_timers(const TickType_t now);
+void test_hsm_reset_timers(void);
+void test_hsm_reset_trace(void);
+void test_hsm_build_lca_table(void);
+enum hsm_state test_hsm_lca(const enum hsm_state a, const enum hsm_state b);
+void test_hsm_reset_event_pool(void);
 #endif // UNITTEST
 
 #endif // __HSM_H__
@@ -0,0 +1,196 @@
+/**
+ * @file nvstore.c
+ * @brief Persistent system register store
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ */
+
+#include "nvstore.h"
+#include "flash.h"
+#include "logger.h"
+#include "uassert.h"
+
+#include <string.h>
+
+#define NV_OFFSET(name, dtype) SYSREG_##name,
+#define NV_DTYPE(name, dtype) dtype,
+
+_Static_assert(SYSREG_NV_COUNT > 0, "nvstore requires at least one nv register in sysreg.json");
+
+// persisted registers are keyed by register offset
+static const size_t nv_offsets[SYSREG_NV_COUNT] = {SYSREG_NV_MAP(NV_OFFSET)};
+static const sysreg_dtype_t nv_dtypes[SYSREG_NV_COUNT] = {SYSREG_NV_MAP(NV_DTYPE)};
+
+static struct nvstore_context ctx = {0};
+
+static uint32_t _to_raw(const sysreg_dtype_t dtype, const sysreg_value_t value) {
+  switch (dtype) {
+    case SYSREG_DTYPE_U8:
+      return value.u8;
+    case SYSREG_DTYPE_U16:
+      return value.u16;
+    default:
+      // u32 and f32 share storage
+      return value.u32;
+  }
+}
+
+static sysreg_value_t _from_raw(const sysreg_dtype_t dtype, const uint32_t raw) {
+  sysreg_value_t value = {0};
+  switch (dtype) {
+    case SYSREG_DTYPE_U8:
+      value.u8 = (uint8_t)raw;
+      break;
+    case SYSREG_DTYPE_U16:
+      value.u16 = (uint16_t)raw;
+      break;
+    default:
+      value.u32 = raw;
+      break;
+  }
+  return value;
+}
+
+/**
+ * @brief Stage a replayed record into the committed values. Records of registers which are no
+ * longer persisted are dropped.
+ */
+static void _replay(uint16_t key, uint32_t value, void *arg) {
+  bool *restored = arg;
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    if (nv_offsets[i] == key) {
+      ctx.committed[i] = value;
+      restored[i] = true;
+      return;
+    }
+  }
+}
+
+static nvlog_status_t _snapshot(struct nvlog *log, void __attribute__((unused)) * arg) {
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    nvlog_status_t status = nvlog_append(log, (uint16_t)nv_offsets[i], ctx.committed[i]);
+    if (status != NVLOG_OK) {
+      return status;
+    }
+  }
+  return NVLOG_OK;
+}
+
+/**
+ * @brief Read the current value of every persisted register into the committed values
+ */
+static void _read_registers(sysreg_op_t *ops) {
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    ops[i] = (sysreg_op_t){.offset = nv_offsets[i], .op = SYSREG_OP_READ, .dtype = nv_dtypes[i]};
+  }
+  uassert(sysreg_transact(ops, SYSREG_NV_COUNT) == SYSREG_OK);
+}
+
+/**
+ * @brief Restore persisted registers in a single batch so readers never observe a partial
+ * restore. Restored values go through the usual saturation so out of range records are clamped.
+ */
+static void _restore(void) {
+  bool restored[SYSREG_NV_COUNT] = {false};
+  sysreg_op_t ops[SYSREG_NV_COUNT];
+  nvlog_status_t status = nvlog_mount(&ctx.log, flash_nvlog(), _replay, _snapshot, restored);
+  if (status != NVLOG_OK) {
+    error("nvstore mount failed with %d", status);
+  }
+  size_t num_ops = 0;
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    if (restored[i]) {
+      ops[num_ops++] = (sysreg_op_t){.offset = nv_offsets[i], .op = SYSREG_OP_WRITE, .dtype = nv_dtypes[i], .value = _from_raw(nv_dtypes[i], ctx.committed[i])};
+    }
+  }
+  if (num_ops > 0) {
+    uassert(sysreg_transact(ops, num_ops) == SYSREG_OK);
+  }
+  // registers absent from the log hold their reset value which becomes part of the next snapshot
+  _read_registers(ops);
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    ctx.committed[i] = _to_raw(nv_dtypes[i], ops[i].value);
+  }
+  info("nvstore restored %u registers", (unsigned)num_ops);
+}
+
+/**
+ * @brief Append every changed persisted register to the log
+ */
+static void _commit(void) {
+  sysreg_op_t ops[SYSREG_NV_COUNT];
+  bool dirty[SYSREG_NV_COUNT] = {false};
+  // clear before reading so a write racing the commit marks its register for the next pass
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    sysreg_test_and_clear_dirty(ctx.subscriber_id, nv_offsets[i], &dirty[i]);
+  }
+  _read_registers(ops);
+  for (size_t i = 0; i < SYSREG_NV_COUNT; i++) {
+    uint32_t raw = _to_raw(nv_dtypes[i], ops[i].value);
+    if ((!dirty[i] && !ctx.resync) || raw == ctx.committed[i]) {
+      continue;
+    }
+    nvlog_status_t status = nvlog_append(&ctx.log, (uint16_t)nv_offsets[i], raw);
+    if (status != NVLOG_OK) {
+      // the log must be remounted after a failed append; retry every register on the next pass
+      error("nvstore commit failed with %d", status);
+      status = nvlog_mount(&ctx.log, flash_nvlog(), NULL, _snapshot, NULL);
+      if (status != NVLOG_OK) {
+        error("nvstore mount failed with %d", status);
+      }
+      ctx.resync = true;
+      xTaskNotifyGive(ctx.task_handle);
+      return;
+    }
+    ctx.committed[i] = raw;
+  }
+  ctx.resync = false;
+}
+
+static void _notify(void *arg) {
+  xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+/**
+ * @brief Persistent store task runner
+ *
+ * @param[in] argument task argument (unused)
+ */
+static void nvstore_task(void __attribute__((unused)) * argument) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // coalesce a burst of register writes into a single commit
+    vTaskDelay(pdMS_TO_TICKS(ctx.init->commit_delay_ms));
+    ulTaskNotifyTake(pdTRUE, 0);
+    _commit();
+  }
+}
+
+void nvstore_start(const struct system_task_context *task_ctx) {
+  // header guards
+  uassert(task_ctx != NULL);
+  uassert(task_ctx->init_ctx != NULL);
+
+  // restore before any other task observes the registers
+  ctx.init = task_ctx->init_ctx;
+  uassert(sysreg_init() == SYSREG_OK);
+  _restore();
+
+  // start task
+  BaseType_t ret = xTaskCreate(nvstore_task, task_ctx->name, task_ctx->stack_size, NULL, task_ctx->priority, &ctx.task_handle);
+  uassert(ret == pdPASS);
+  uassert(sysreg_subscribe(nv_offsets, SYSREG_NV_COUNT, _notify, ctx.task_handle, &ctx.subscriber_id) == SYSREG_OK);
+}
+
+#ifdef UNITTEST
+
+struct nvstore_context *test_nvstore_get_context(void) {
+  return &ctx;
+}
+
+void test_nvstore_commit(void) {
+  _commit();
+}
+
+#endif // UNITTEST
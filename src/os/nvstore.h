@@ -0,0 +1,49 @@
+/**
+ * @file nvstore.h
+ * @brief Persistent system register store
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ */
+
+#ifndef __NVSTORE_H__
+#define __NVSTORE_H__
+
+#include "nvlog.h"
+#include "sysreg.h"
+#include "system.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#define NVSTORE_DEFAULT_COMMIT_DELAY_MS 500
+
+struct nvstore_init_context {
+  uint32_t commit_delay_ms; // delay after the first change before committing a burst
+};
+
+struct nvstore_context {
+  const struct nvstore_init_context *init;
+  TaskHandle_t task_handle;
+  struct nvlog log;
+  uint8_t subscriber_id;
+  bool resync;                         // compare every persisted register on the next commit
+  uint32_t committed[SYSREG_NV_COUNT]; // raw register values present in the log
+};
+
+/**
+ * @brief Reset the system registers, restore every persisted register from flash and start the
+ * task committing register changes to flash.
+ *
+ * @param[in] task_ctx task context
+ */
+void nvstore_start(const struct system_task_context *task_ctx);
+
+#ifdef UNITTEST
+struct nvstore_context *test_nvstore_get_context(void);
+void test_nvstore_commit(void);
+#endif // UNITTEST
+
+#endif // __NVSTORE_H__
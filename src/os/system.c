@@ -6,6 +6,7 @@
 #include "hsm.h"
 #include "led.h"
 #include "logger.h"
+#include "nvstore.h"
 #include "uassert.h"
 
 #include <FreeRTOS.h>
@@ -41,6 +42,12 @@ static const struct hsm_init_context hsm_init_ctx = {
 static const struct logger_init_context logger_init_ctx = {
   .log_level = LOGGER_DEFAULT_LEVEL,
   .port = LOGGER_DEFAULT_PORT,
+  .udp_addr = LOGGER_DEFAULT_UDP_ADDR,
+  .udp_port = 0, // UDP streaming disabled; LOGGER_DEFAULT_UDP_PORT streams to udp_addr
+};
+
+static const struct nvstore_init_context nvstore_init_ctx = {
+  .commit_delay_ms = NVSTORE_DEFAULT_COMMIT_DELAY_MS,
 };
 
 
@@ -65,6 +72,16 @@ static struct system_task system_task_registry[] = {
     },
     .start = logger_start 
   },
+  {
+    // restores persisted registers before the hsm starts
+    .task_context = {
+      .name = "nvstore",
+      .priority = tskIDLE_PRIORITY + 1,
+      .stack_size = configMINIMAL_STACK_SIZE,
+      .init_ctx = &nvstore_init_ctx,
+    },
+    .start = nvstore_start
+  },
   {
     .task_context = {
       .name = "hsm",
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "nvlog.h"
+}
+
+/**
+ * @brief Host NOR flash emulator backing an nvlog. Erase sets a sector to 0xFF and programming can
+ * only clear bits of erased bytes. A power loss can be injected after a budget of programmed or
+ * erased bytes; the operation in flight is torn and every later operation fails until `power_on`.
+ */
+class FlashEmulator {
+public:
+  FlashEmulator(size_t sector_size, size_t num_sectors, size_t program_size)
+      : memory(sector_size * num_sectors, 0xFF), erase_count(num_sectors, 0) {
+    flash.ctx = this;
+    flash.sector_size = sector_size;
+    flash.num_sectors = num_sectors;
+    flash.program_size = program_size;
+    flash.read = read;
+    flash.program = program;
+    flash.erase = erase;
+  }
+
+  // fail once `bytes` more bytes have been programmed or erased
+  void power_loss_after(size_t bytes) {
+    budget = bytes;
+    budget_enabled = true;
+  }
+
+  void power_on() {
+    powered = true;
+    budget_enabled = false;
+  }
+
+  struct nvlog_flash flash;
+  std::vector<uint8_t> memory;
+  std::vector<uint32_t> erase_count;
+  size_t bytes_programmed = 0;
+  bool powered = true;
+  bool program_violation = false; // programmed a byte that was not erased
+
+private:
+  size_t budget = 0;
+  bool budget_enabled = false;
+
+  // number of bytes of an operation of `len` bytes that complete before power is lost
+  size_t consume(size_t len) {
+    if (!budget_enabled || len <= budget) {
+      budget -= budget_enabled ? len : 0;
+      return len;
+    }
+    size_t done = budget;
+    budget = 0;
+    powered = false;
+    return done;
+  }
+
+  static nvlog_status_t read(void *ctx, size_t addr, void *data, size_t len) {
+    auto *self = static_cast<FlashEmulator *>(ctx);
+    if (!self->powered || addr + len > self->memory.size()) {
+      return NVLOG_FLASH_ERR;
+    }
+    memcpy(data, &self->memory[addr], len);
+    return NVLOG_OK;
+  }
+
+  static nvlog_status_t program(void *ctx, size_t addr, const void *data, size_t len) {
+    auto *self = static_cast<FlashEmulator *>(ctx);
+    if (!self->powered || addr + len > self->memory.size() || addr % self->flash.program_size || len % self->flash.program_size) {
+      return NVLOG_FLASH_ERR;
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    size_t done = self->consume(len);
+    for (size_t i = 0; i < done; i++) {
+      if (self->memory[addr + i] != 0xFF) {
+        self->program_violation = true;
+      }
+      self->memory[addr + i] &= bytes[i];
+    }
+    self->bytes_programmed += done;
+    return done == len ? NVLOG_OK : NVLOG_FLASH_ERR;
+  }
+
+  static nvlog_status_t erase(void *ctx, size_t sector) {
+    auto *self = static_cast<FlashEmulator *>(ctx);
+    if (!self->powered || sector >= self->flash.num_sectors) {
+      return NVLOG_FLASH_ERR;
+    }
+    size_t done = self->consume(self->flash.sector_size);
+    memset(&self->memory[sector * self->flash.sector_size], 0xFF, done);
+    self->erase_count[sector]++;
+    return done == self->flash.sector_size ? NVLOG_OK : NVLOG_FLASH_ERR;
+  }
+};
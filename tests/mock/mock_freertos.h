@@ -5,16 +5,20 @@
 extern "C" {
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "task.h"
 }
 
 class MockFreeRTOS {
 public:
   MOCK_METHOD(void, vTaskDelay, (const TickType_t));
+  MOCK_METHOD(TickType_t, xTaskGetTickCount, ());
   MOCK_METHOD(BaseType_t, xQueueReceive, (QueueHandle_t, void *const, TickType_t));
   MOCK_METHOD(BaseType_t, xQueueGenericSend, ( QueueHandle_t, const void * const, TickType_t, const BaseType_t));
   MOCK_METHOD(BaseType_t, xQueueGenericSendFromISR, ( QueueHandle_t, const void * const, BaseType_t * const, const BaseType_t));
 	MOCK_METHOD(QueueHandle_t, xQueueGenericCreateStatic, (const UBaseType_t, const UBaseType_t, uint8_t *, StaticQueue_t *, const uint8_t));
   MOCK_METHOD(BaseType_t, xTaskCreate, (TaskFunction_t, const char * const, const configSTACK_DEPTH_TYPE, void * const, UBaseType_t, TaskHandle_t * const));
+  MOCK_METHOD(BaseType_t, xTaskGenericNotify, (TaskHandle_t, UBaseType_t, uint32_t, eNotifyAction, uint32_t *));
+  MOCK_METHOD(uint32_t, ulTaskGenericNotifyTake, (UBaseType_t, BaseType_t, TickType_t));
 };
 
 MockFreeRTOS *mock_freertos = nullptr;
@@ -26,6 +30,10 @@ void vTaskDelay(const TickType_t xTicksToDelay) {
   return mock_freertos->vTaskDelay(xTicksToDelay);
 }
 
+TickType_t xTaskGetTickCount(void) {
+  return mock_freertos->xTaskGetTickCount();
+}
+
 BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait) {
   return mock_freertos->xQueueReceive(xQueue, pvBuffer, xTicksToWait);
 }
@@ -45,5 +53,13 @@ QueueHandle_t xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const U
 BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const configSTACK_DEPTH_TYPE usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask) {
   return mock_freertos->xTaskCreate(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask);
 }
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue) {
+  return mock_freertos->xTaskGenericNotify(xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotificationValue);
+}
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+  return mock_freertos->ulTaskGenericNotifyTake(uxIndexToWaitOn, xClearCountOnExit, xTicksToWait);
+}
 }
 
@@ -12,7 +12,9 @@ public:
   MOCK_METHOD(void, logger_start, (const struct system_task_context *));
   MOCK_METHOD(enum logger_level, logger_get_level, ());
   MOCK_METHOD(void, logger_set_level, (const enum logger_level));
-  MOCK_METHOD(void, logger_out, (const enum logger_level level, const char *fmt, va_list args));
+  MOCK_METHOD(enum logger_level, logger_get_module_level, (const enum logger_module));
+  MOCK_METHOD(void, logger_set_module_level, (const enum logger_module, const enum logger_level));
+  MOCK_METHOD(void, logger_write, (const enum logger_level level, const char *fmt, const logfmt_arg_t *args, const uint8_t nargs));
 };
 
 MockLogger *mock_logger = nullptr;
@@ -20,6 +22,9 @@ MockLogger *mock_logger = nullptr;
 // C-style wrapper functions for the mocks
 extern "C" {
 
+// every module at LOGGER_TRACE so all log calls reach the logger_write mock
+uint8_t logger_levels[LOGGER_MODULE_COUNT] = {0};
+
 void logger_start(const struct system_task_context *task_ctx) {
   return mock_logger->logger_start(task_ctx);
 }
@@ -32,9 +37,16 @@ void logger_set_level(const enum logger_level level) {
   return mock_logger->logger_set_level(level);
 }
 
-void logger_out(const enum logger_level level, const char *fmt, ...) {
-  va_list args;
-  return mock_logger->logger_out(level, fmt, args);
+enum logger_level logger_get_module_level(const enum logger_module module) {
+  return mock_logger->logger_get_module_level(module);
+}
+
+void logger_set_module_level(const enum logger_module module, const enum logger_level level) {
+  return mock_logger->logger_set_module_level(module, level);
+}
+
+void logger_write(const enum logger_level level, const char *fmt, const logfmt_arg_t *args, const uint8_t nargs) {
+  return mock_logger->logger_write(level, fmt, args, nargs);
 }
 
 }
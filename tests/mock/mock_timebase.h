@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "timebase.h"
+}
+
+class MockTimebase {
+public:
+  MOCK_METHOD(void, timebase_init, ());
+  MOCK_METHOD(uint64_t, timebase_now, ());
+  MOCK_METHOD(uint32_t, timebase_frequency, ());
+};
+
+// Provide a way to access the mock globally
+MockTimebase *mock_timebase = nullptr;
+
+// C-style wrapper functions for the mocks
+extern "C" {
+void timebase_init(void) {
+  return mock_timebase->timebase_init();
+}
+
+uint64_t timebase_now(void) {
+  return mock_timebase->timebase_now();
+}
+
+uint32_t timebase_frequency(void) {
+  return mock_timebase->timebase_frequency();
+}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * Virtual time FreeRTOS and timebase shim for host simulation. A single simulated task runs on the
+ * calling thread; the tick count only moves when that task blocks, so a simulation runs as fast as
+ * the host allows (or paced to a speed-up factor). Blocking is delegated to SimKernel::on_block,
+ * which advances time and posts work; returning false ends the simulation by unwinding the task
+ * back to SimKernel::run with longjmp, so the task code may be an infinite loop.
+ *
+ * The timebase is virtual time plus the host time spent since the last advance, capped below one
+ * tick so it stays monotonic: handler durations are measured on the host while waits across
+ * ticks are measured in virtual time.
+ */
+
+#include <chrono>
+#include <csetjmp>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include "timebase.h"
+}
+
+struct SimKernel {
+  TickType_t now = 0;
+  double speedup = 0;  // virtual ms per host ms, 0 for as fast as possible
+  std::function<bool(TickType_t wait)> on_block;
+  std::function<void()> on_receive;  // optional: called on every queue receive
+  TaskFunction_t task = nullptr;
+  void *task_arg = nullptr;
+
+  struct Queue {
+    std::deque<std::vector<uint8_t>> items;
+    size_t item_size = 0;
+    size_t capacity = 0;
+  };
+  // static queues by handle
+  std::map<QueueHandle_t, Queue> queues;
+
+  std::jmp_buf exit;
+  uint64_t host_base_ns = 0;
+
+  static uint64_t host_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void advance(TickType_t to) {
+    if ((int32_t)(to - now) <= 0) {
+      return;
+    }
+    if (speedup > 0) {
+      std::this_thread::sleep_for(std::chrono::duration<double, std::milli>((to - now) / speedup));
+    }
+    now = to;
+    host_base_ns = host_ns();
+  }
+
+  // run the created task until on_block ends the simulation
+  void run() {
+    host_base_ns = host_ns();
+    if (setjmp(exit) == 0) {
+      task(task_arg);
+    }
+  }
+};
+
+SimKernel *sim_kernel = nullptr;
+
+extern "C" {
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+  sim_kernel->advance(sim_kernel->now + xTicksToDelay);
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return sim_kernel->now;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait) {
+  SimKernel::Queue &queue = sim_kernel->queues.at(xQueue);
+  if (sim_kernel->on_receive) {
+    sim_kernel->on_receive();
+  }
+  if (queue.items.empty() && xTicksToWait > 0 && !sim_kernel->on_block(xTicksToWait)) {
+    // no C++ objects live in this frame: safe to unwind the task
+    std::longjmp(sim_kernel->exit, 1);
+  }
+  if (queue.items.empty()) {
+    return pdFALSE;
+  }
+  memcpy(pvBuffer, queue.items.front().data(), queue.item_size);
+  queue.items.pop_front();
+  return pdTRUE;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+  (void)xTicksToWait;
+  SimKernel::Queue &queue = sim_kernel->queues.at(xQueue);
+  if (queue.items.size() >= queue.capacity) {
+    return errQUEUE_FULL;
+  }
+  const uint8_t *item = static_cast<const uint8_t *>(pvItemToQueue);
+  if (xCopyPosition == queueSEND_TO_FRONT) {
+    queue.items.emplace_front(item, item + queue.item_size);
+  } else {
+    queue.items.emplace_back(item, item + queue.item_size);
+  }
+  return pdTRUE;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition) {
+  if (pxHigherPriorityTaskWoken != NULL) {
+    *pxHigherPriorityTaskWoken = pdFALSE;
+  }
+  return xQueueGenericSend(xQueue, pvItemToQueue, 0, xCopyPosition);
+}
+
+QueueHandle_t xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType) {
+  (void)pucQueueStorage;
+  (void)ucQueueType;
+  QueueHandle_t handle = reinterpret_cast<QueueHandle_t>(pxStaticQueue);
+  SimKernel::Queue &queue = sim_kernel->queues[handle];
+  queue.items.clear();
+  queue.item_size = uxItemSize;
+  queue.capacity = uxQueueLength;
+  return handle;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const configSTACK_DEPTH_TYPE usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask) {
+  (void)pcName;
+  (void)usStackDepth;
+  (void)uxPriority;
+  sim_kernel->task = pxTaskCode;
+  sim_kernel->task_arg = pvParameters;
+  if (pxCreatedTask != NULL) {
+    *pxCreatedTask = reinterpret_cast<TaskHandle_t>(sim_kernel);
+  }
+  return pdPASS;
+}
+
+void timebase_init(void) {}
+
+uint64_t timebase_now(void) {
+  const uint64_t host = SimKernel::host_ns() - sim_kernel->host_base_ns;
+  return (uint64_t)sim_kernel->now * 1000000u + (host < 999999u ? host : 999999u);
+}
+
+uint32_t timebase_frequency(void) {
+  return 1000000000u;
+}
+}
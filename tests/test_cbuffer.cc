@@ -0,0 +1,373 @@
+/**
+ * @file test_cbuffer.cc
+ * @brief Circular buffer tests
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+extern "C" {
+#include "cbuffer.h"
+}
+
+class CBufferTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(CBufferTest, PushPopOrder) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage, sizeof(uint32_t), size);
+  uint32_t value;
+  EXPECT_EQ(cbuffer_pop(&cb, &value), CBUFFER_UNDERFLOW);
+  // wrap around several times; one slot is always kept free
+  for (uint32_t lap = 0; lap < 4; lap++) {
+    for (uint32_t i = 0; i < size - 1; i++) {
+      value = lap * 100 + i;
+      ASSERT_EQ(cbuffer_push(&cb, &value), CBUFFER_SUCCESS);
+    }
+    EXPECT_EQ(cbuffer_push(&cb, &value), CBUFFER_OVERFLOW);
+    for (uint32_t i = 0; i < size - 1; i++) {
+      ASSERT_EQ(cbuffer_pop(&cb, &value), i + 2 < size ? CBUFFER_SUCCESS : CBUFFER_EMPTY);
+      EXPECT_EQ(value, lap * 100 + i);
+    }
+    EXPECT_EQ(cbuffer_pop(&cb, &value), CBUFFER_UNDERFLOW);
+  }
+}
+
+TEST_P(CBufferTest, ReserveCommitPeekRelease) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage, sizeof(uint32_t), size);
+  const void *out;
+  EXPECT_EQ(cbuffer_peek(&cb, &out), CBUFFER_UNDERFLOW);
+  for (uint32_t i = 0; i < 3 * size; i++) {
+    void *in;
+    ASSERT_EQ(cbuffer_reserve(&cb, &in), CBUFFER_SUCCESS);
+    // the slot is ring storage, not a staging copy
+    EXPECT_GE((uint8_t *)in, (uint8_t *)storage);
+    EXPECT_LT((uint8_t *)in, (uint8_t *)(storage + size));
+    *(uint32_t *)in = i;
+    // an uncommitted element is not visible to the consumer
+    EXPECT_EQ(cbuffer_peek(&cb, &out), CBUFFER_UNDERFLOW);
+    cbuffer_commit(&cb);
+    ASSERT_EQ(cbuffer_peek(&cb, &out), CBUFFER_SUCCESS);
+    EXPECT_EQ(out, in);
+    EXPECT_EQ(*(const uint32_t *)out, i);
+    EXPECT_EQ(cbuffer_release(&cb), CBUFFER_EMPTY);
+  }
+}
+
+TEST_P(CBufferTest, ReserveWhenFull) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage, sizeof(uint32_t), size);
+  void *in;
+  for (size_t i = 0; i < size - 1; i++) {
+    ASSERT_EQ(cbuffer_reserve(&cb, &in), CBUFFER_SUCCESS);
+    cbuffer_commit(&cb);
+  }
+  EXPECT_EQ(cbuffer_reserve(&cb, &in), CBUFFER_OVERFLOW);
+  const void *out;
+  ASSERT_EQ(cbuffer_peek(&cb, &out), CBUFFER_SUCCESS);
+  EXPECT_EQ(cbuffer_release(&cb), size > 2 ? CBUFFER_SUCCESS : CBUFFER_EMPTY);
+  EXPECT_EQ(cbuffer_reserve(&cb, &in), CBUFFER_SUCCESS);
+}
+
+TEST_P(CBufferTest, SpscPushPopOrder) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(uint32_t), size);
+  uint32_t value;
+  EXPECT_EQ(cbuffer_spsc_pop(&cb, &value), CBUFFER_UNDERFLOW);
+  for (uint32_t lap = 0; lap < 4; lap++) {
+    for (uint32_t i = 0; i < size - 1; i++) {
+      value = lap * 100 + i;
+      ASSERT_EQ(cbuffer_spsc_push(&cb, &value), CBUFFER_SUCCESS);
+    }
+    EXPECT_EQ(cbuffer_spsc_push(&cb, &value), CBUFFER_OVERFLOW);
+    for (uint32_t i = 0; i < size - 1; i++) {
+      ASSERT_NE(cbuffer_spsc_pop(&cb, &value), CBUFFER_UNDERFLOW);
+      EXPECT_EQ(value, lap * 100 + i);
+    }
+    EXPECT_EQ(cbuffer_spsc_pop(&cb, &value), CBUFFER_UNDERFLOW);
+  }
+}
+
+TEST_P(CBufferTest, CountAndSpace) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage, sizeof(uint32_t), size);
+  uint32_t value = 0;
+  for (size_t step = 0; step < 3 * size; step++) {
+    // fill and drain across the wrap point
+    for (size_t i = 0; i < size - 1; i++) {
+      EXPECT_EQ(cbuffer_count(&cb), i);
+      EXPECT_EQ(cbuffer_space(&cb), size - 1 - i);
+      cbuffer_push(&cb, &value);
+    }
+    EXPECT_EQ(cbuffer_space(&cb), 0u);
+    cbuffer_pop(&cb, &value);
+    EXPECT_EQ(cbuffer_count(&cb), size - 2);
+    cbuffer_pop_n(&cb, storage, 0);
+    while (cbuffer_pop(&cb, &value) == CBUFFER_SUCCESS) {
+    }
+    EXPECT_EQ(cbuffer_count(&cb), 0u);
+    // shift the start position for the next lap
+    cbuffer_push(&cb, &value);
+    cbuffer_pop(&cb, &value);
+  }
+}
+
+TEST_P(CBufferTest, BulkPushPopWraps) {
+  const size_t size = GetParam();
+  uint32_t storage[16];
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage, sizeof(uint32_t), size);
+  uint32_t in[32], out[32];
+  uint32_t next_in = 0, next_out = 0;
+  for (size_t lap = 0; lap < 8 * size; lap++) {
+    // odd block sizes walk the head and tail through every wrap offset
+    const size_t block = lap % size + 1;
+    for (size_t i = 0; i < block; i++) {
+      in[i] = next_in + (uint32_t)i;
+    }
+    const size_t space = cbuffer_space(&cb);
+    const size_t pushed = cbuffer_push_n(&cb, in, block);
+    EXPECT_EQ(pushed, block < space ? block : space);
+    next_in += (uint32_t)pushed;
+    const size_t count = cbuffer_count(&cb);
+    const size_t popped = cbuffer_pop_n(&cb, out, (lap % 3) + 1);
+    EXPECT_EQ(popped, count < (lap % 3) + 1 ? count : (lap % 3) + 1);
+    for (size_t i = 0; i < popped; i++) {
+      ASSERT_EQ(out[i], next_out++);
+    }
+  }
+  const size_t rest = cbuffer_pop_n(&cb, out, 32);
+  for (size_t i = 0; i < rest; i++) {
+    ASSERT_EQ(out[i], next_out++);
+  }
+  EXPECT_EQ(next_out, next_in);
+  EXPECT_EQ(cbuffer_pop_n(&cb, out, 32), 0u);
+}
+
+TEST(CBufferSpsc, IndicesOnSeparateCacheLines) {
+  EXPECT_GE(offsetof(struct cbuffer_spsc, head), offsetof(struct cbuffer_spsc, mask) + sizeof(size_t));
+  EXPECT_EQ(offsetof(struct cbuffer_spsc, head) % CBUFFER_CACHE_LINE, 0u);
+  EXPECT_GE(offsetof(struct cbuffer_spsc, tail) - offsetof(struct cbuffer_spsc, head), (size_t)CBUFFER_CACHE_LINE);
+  EXPECT_EQ(sizeof(struct cbuffer_spsc) % CBUFFER_CACHE_LINE, 0u);
+}
+
+/**
+ * @brief One thread streams a sequence through a small ring while another checks it arrives
+ * complete and in order. Run under ThreadSanitizer to check the acquire/release pairing.
+ */
+TEST(CBufferSpsc, ConcurrentStream) {
+  constexpr uint32_t kCount = 200000;
+  struct sample {
+    uint32_t seq;
+    uint32_t check;
+    uint8_t payload[24];
+  };
+  static sample storage[16];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(sample), 16);
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < kCount;) {
+      sample s;
+      s.seq = seq;
+      s.check = ~seq;
+      memset(s.payload, (int)seq, sizeof(s.payload));
+      if (cbuffer_spsc_push(&cb, &s) == CBUFFER_SUCCESS) {
+        seq++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool ordered = true;
+  while (ordered && expected < kCount) {
+    const void *slot;
+    if (cbuffer_spsc_peek(&cb, &slot) != CBUFFER_SUCCESS) {
+      std::this_thread::yield();
+      continue;
+    }
+    const sample *s = (const sample *)slot;
+    ordered = s->seq == expected && s->check == ~expected && s->payload[sizeof(s->payload) - 1] == (uint8_t)expected;
+    EXPECT_TRUE(ordered) << "sample " << expected << " corrupt or out of order";
+    cbuffer_spsc_release(&cb);
+    expected++;
+  }
+  // drain so the producer can finish after a failure
+  for (uint32_t value[8]; expected < kCount;) {
+    if (cbuffer_spsc_pop(&cb, value) != CBUFFER_UNDERFLOW) {
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  uint32_t value;
+  EXPECT_EQ(cbuffer_spsc_pop(&cb, &value), CBUFFER_UNDERFLOW);
+}
+
+TEST(CBufferSpsc, ConcurrentBlockStream) {
+  constexpr uint32_t kCount = 200000;
+  static uint16_t storage[64];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(uint16_t), 64);
+  std::thread producer([&] {
+    uint16_t block[24];
+    for (uint32_t seq = 0; seq < kCount;) {
+      const size_t n = kCount - seq < 24 ? kCount - seq : 24;
+      for (size_t i = 0; i < n; i++) {
+        block[i] = (uint16_t)(seq + i);
+      }
+      // a partial push leaves the rest of the block to retry from the next sequence number
+      const size_t pushed = cbuffer_spsc_push_n(&cb, block, n);
+      seq += (uint32_t)pushed;
+      if (pushed < n) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  size_t errors = 0;
+  uint16_t block[40];
+  while (expected < kCount) {
+    const size_t popped = cbuffer_spsc_pop_n(&cb, block, 40);
+    for (size_t i = 0; i < popped; i++) {
+      errors += block[i] != (uint16_t)expected++;
+    }
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_EQ(errors, 0u);
+}
+
+TEST_P(CBufferTest, OverwriteKeepsNewest) {
+  const size_t size = GetParam();
+  uint32_t storage[16], out[16];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(uint32_t), size);
+  cbuffer_spsc_set_overwrite(&cb);
+  EXPECT_EQ(cbuffer_spsc_snapshot(&cb, out, 16), 0u);
+  for (uint32_t value = 0; value < 5 * size; value++) {
+    ASSERT_EQ(cbuffer_spsc_push(&cb, &value), CBUFFER_SUCCESS);
+    const size_t kept = value + 1 < size - 1 ? value + 1 : size - 1;
+    EXPECT_EQ(cbuffer_spsc_overwritten(&cb), value + 1 - kept);
+    ASSERT_EQ(cbuffer_spsc_snapshot(&cb, out, 16), kept);
+    for (size_t i = 0; i < kept; i++) {
+      ASSERT_EQ(out[i], value + 1 - kept + i);
+    }
+  }
+  // a short snapshot returns the most recent window
+  const uint32_t newest = 5 * (uint32_t)size - 1;
+  ASSERT_EQ(cbuffer_spsc_snapshot(&cb, out, 1), 1u);
+  EXPECT_EQ(out[0], newest);
+}
+
+TEST_P(CBufferTest, OverwriteBlocks) {
+  const size_t size = GetParam();
+  uint32_t storage[16], in[40], out[16];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(uint32_t), size);
+  cbuffer_spsc_set_overwrite(&cb);
+  uint32_t next = 0;
+  for (size_t block = 1; block < 40; block += 3) {
+    for (size_t i = 0; i < block; i++) {
+      in[i] = next++;
+    }
+    // blocks larger than the ring keep only their newest elements
+    EXPECT_EQ(cbuffer_spsc_push_n(&cb, in, block), block < size - 1 ? block : size - 1);
+    const size_t kept = next < size - 1 ? next : size - 1;
+    EXPECT_EQ(cbuffer_spsc_overwritten(&cb), next - kept);
+    ASSERT_EQ(cbuffer_spsc_snapshot(&cb, out, 16), kept);
+    for (size_t i = 0; i < kept; i++) {
+      ASSERT_EQ(out[i], next - kept + i);
+    }
+  }
+}
+
+TEST(CBufferSpsc, RejectModeDoesNotOverwrite) {
+  uint32_t storage[4];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(uint32_t), 4);
+  uint32_t in[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  EXPECT_EQ(cbuffer_spsc_push_n(&cb, in, 8), 3u);
+  EXPECT_EQ(cbuffer_spsc_push(&cb, in), CBUFFER_OVERFLOW);
+  EXPECT_EQ(cbuffer_spsc_overwritten(&cb), 0u);
+}
+
+/**
+ * @brief Snapshots taken while a producer keeps overwriting the ring must always be a contiguous,
+ * intact run of the sequence. Slot copies race with the producer by design (torn elements are
+ * detected and left out), so this test is not meaningful under ThreadSanitizer.
+ */
+TEST(CBufferSpsc, SnapshotWhileProducing) {
+  struct sample {
+    uint32_t seq;
+    uint32_t payload[6];
+    uint32_t check;
+  };
+  static sample storage[32];
+  struct cbuffer_spsc cb;
+  cbuffer_spsc_init(&cb, storage, sizeof(sample), 32);
+  cbuffer_spsc_set_overwrite(&cb);
+  std::atomic<bool> done{false};
+  std::thread producer([&] {
+    for (uint32_t seq = 0; !done.load(std::memory_order_relaxed); seq++) {
+      sample s;
+      s.seq = seq;
+      for (uint32_t &word : s.payload) {
+        word = seq;
+      }
+      s.check = ~seq;
+      cbuffer_spsc_push(&cb, &s);
+    }
+  });
+  size_t snapshots = 0, elements = 0, errors = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  while (std::chrono::steady_clock::now() < deadline) {
+    sample window[32];
+    const size_t n = cbuffer_spsc_snapshot(&cb, window, 32);
+    for (size_t i = 0; i < n; i++) {
+      const sample &s = window[i];
+      bool intact = s.check == ~s.seq && (i == 0 || s.seq == window[i - 1].seq + 1);
+      for (uint32_t word : s.payload) {
+        intact = intact && word == s.seq;
+      }
+      errors += !intact;
+    }
+    snapshots++;
+    elements += n;
+    if ((snapshots & 15) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  done = true;
+  producer.join();
+  EXPECT_EQ(errors, 0u);
+  EXPECT_GT(elements, 0u);
+  EXPECT_GT(cbuffer_spsc_overwritten(&cb), 0u);
+  printf("[ STRESS   ] %zu snapshots, %zu elements, %zu overwritten\n", snapshots, elements, cbuffer_spsc_overwritten(&cb));
+}
+
+// power of two capacities take the masked path, the others the modulo path
+INSTANTIATE_TEST_SUITE_P(Capacity, CBufferTest, ::testing::Values(2, 3, 5, 8, 16));
@@ -0,0 +1,256 @@
+/**
+ * @file test_cbuffer_bench.cc
+ * @brief Circular buffer copy and zero-copy benchmarks. Timings are reported, not asserted: the
+ * tests build unoptimized for coverage and run on shared hosts.
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "cbuffer.h"
+}
+
+namespace {
+
+constexpr size_t kIterations = 200000;
+
+/**
+ * @brief Original push/pop: two modulo operations per call with runtime sizes
+ */
+struct legacy_cbuffer {
+  void *buffer;
+  size_t size;
+  size_t elem_size;
+  size_t head;
+  size_t tail;
+};
+
+__attribute__((noinline)) int legacy_push(legacy_cbuffer *cb, const void *data) {
+  if ((cb->head + 1) % cb->size == cb->tail) {
+    return CBUFFER_OVERFLOW;
+  }
+  size_t index = (cb->head * cb->elem_size) % (cb->size * cb->elem_size);
+  memcpy((uint8_t *)cb->buffer + index, data, cb->elem_size);
+  cb->head = (cb->head + 1) % cb->size;
+  return CBUFFER_SUCCESS;
+}
+
+__attribute__((noinline)) int legacy_pop(legacy_cbuffer *cb, void *data) {
+  if (cb->tail == cb->head) {
+    return CBUFFER_UNDERFLOW;
+  }
+  size_t index = (cb->tail * cb->elem_size) % (cb->size * cb->elem_size);
+  memcpy(data, (uint8_t *)cb->buffer + index, cb->elem_size);
+  cb->tail = (cb->tail + 1) % cb->size;
+  return cb->tail == cb->head ? CBUFFER_EMPTY : CBUFFER_SUCCESS;
+}
+
+template <typename Fn>
+double ns_per_op(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kIterations; i++) {
+    fn(i);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() / kIterations;
+}
+
+// keep a few elements queued so head and tail chase each other around the ring
+constexpr size_t kDepth = 8;
+// ring slots: small enough that 1 KiB elements stay cache resident and copies, not misses, dominate
+constexpr size_t kSlots = 16;
+
+} // namespace
+
+class CBufferBench : public ::testing::TestWithParam<size_t> {};
+
+/**
+ * @brief One op is a producer building an element and a consumer reading its first word. The copy
+ * paths build the element on the stack and copy it in and out; the zero-copy path builds it in
+ * ring storage and reads it in place.
+ */
+TEST_P(CBufferBench, CopyVsZeroCopy) {
+  const size_t elem_size = GetParam();
+  std::vector<uint8_t> storage(elem_size * kSlots), element(elem_size), out(elem_size);
+  volatile uint32_t sink = 0;
+
+  legacy_cbuffer legacy = {storage.data(), kSlots - 1, elem_size, 0, 0};
+  for (size_t i = 0; i < kDepth; i++) {
+    legacy_push(&legacy, element.data());
+  }
+  double legacy_ns = ns_per_op([&](size_t i) {
+    memset(element.data(), (int)i, elem_size);
+    legacy_push(&legacy, element.data());
+    legacy_pop(&legacy, out.data());
+    sink += out[0];
+  });
+
+  auto copy = [&](size_t size) {
+    struct cbuffer_handle cb;
+    cbuffer_init(&cb, storage.data(), elem_size, size);
+    for (size_t i = 0; i < kDepth; i++) {
+      cbuffer_push(&cb, element.data());
+    }
+    return ns_per_op([&](size_t i) {
+      memset(element.data(), (int)i, elem_size);
+      cbuffer_push(&cb, element.data());
+      cbuffer_pop(&cb, out.data());
+      sink += out[0];
+    });
+  };
+  double modulo_ns = copy(kSlots - 1);
+  double masked_ns = copy(kSlots);
+
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage.data(), elem_size, kSlots);
+  for (size_t i = 0; i < kDepth; i++) {
+    cbuffer_push(&cb, element.data());
+  }
+  double zero_copy_ns = ns_per_op([&](size_t i) {
+    void *in;
+    const void *head;
+    cbuffer_reserve(&cb, &in);
+    memset(in, (int)i, elem_size);
+    cbuffer_commit(&cb);
+    cbuffer_peek(&cb, &head);
+    sink += *(const uint8_t *)head;
+    cbuffer_release(&cb);
+  });
+
+  printf("[ BENCH    ] %4zu byte elements: legacy %7.2f modulo %7.2f masked %7.2f zero-copy %7.2f ns/op\n", elem_size, legacy_ns,
+         modulo_ns, masked_ns, zero_copy_ns);
+  RecordProperty("legacy_ns", std::to_string(legacy_ns));
+  RecordProperty("modulo_ns", std::to_string(modulo_ns));
+  RecordProperty("masked_ns", std::to_string(masked_ns));
+  RecordProperty("zero_copy_ns", std::to_string(zero_copy_ns));
+}
+
+INSTANTIATE_TEST_SUITE_P(ElementSize, CBufferBench, ::testing::Values(4, 64, 1024));
+
+namespace {
+
+constexpr uint32_t kStreamCount = 500000;
+
+/**
+ * @brief Stream kStreamCount 4 byte samples from a producer thread to the calling thread, yielding
+ * whenever the ring is full or empty (the host may have a single core)
+ *
+ * @return million samples per second
+ */
+template <typename Push, typename Pop>
+double stream_throughput(Push push, Pop pop) {
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < kStreamCount;) {
+      if (push(seq)) {
+        seq++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t sum = 0;
+  for (uint32_t received = 0; received < kStreamCount;) {
+    uint32_t value;
+    if (pop(&value)) {
+      sum += value;
+      received++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  auto stop = std::chrono::steady_clock::now();
+  EXPECT_EQ(sum, (uint64_t)kStreamCount * (kStreamCount - 1) / 2);
+  return kStreamCount / std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+} // namespace
+
+TEST(CBufferBench, SpscVsMutex) {
+  uint32_t storage[256];
+  std::mutex lock;
+  struct cbuffer_handle locked;
+  cbuffer_init(&locked, storage, sizeof(uint32_t), 256);
+  double mutex_rate = stream_throughput(
+    [&](uint32_t seq) {
+      std::lock_guard<std::mutex> guard(lock);
+      return cbuffer_push(&locked, &seq) == CBUFFER_SUCCESS;
+    },
+    [&](uint32_t *value) {
+      std::lock_guard<std::mutex> guard(lock);
+      return cbuffer_pop(&locked, value) != CBUFFER_UNDERFLOW;
+    });
+
+  struct cbuffer_spsc spsc;
+  cbuffer_spsc_init(&spsc, storage, sizeof(uint32_t), 256);
+  double spsc_rate = stream_throughput([&](uint32_t seq) { return cbuffer_spsc_push(&spsc, &seq) == CBUFFER_SUCCESS; },
+                                       [&](uint32_t *value) { return cbuffer_spsc_pop(&spsc, value) != CBUFFER_UNDERFLOW; });
+
+  printf("[ BENCH    ] %u samples: mutex %7.2f M/s spsc %7.2f M/s\n", kStreamCount, mutex_rate, spsc_rate);
+  RecordProperty("mutex_msps", std::to_string(mutex_rate));
+  RecordProperty("spsc_msps", std::to_string(spsc_rate));
+}
+
+class CBufferBulkBench : public ::testing::TestWithParam<size_t> {};
+
+/**
+ * @brief Move kStreamCount 2 byte ADC samples through the ring in blocks, comparing one call per
+ * element against one push_n/pop_n per block
+ */
+TEST_P(CBufferBulkBench, BulkVsElement) {
+  const size_t block = GetParam();
+  std::vector<uint16_t> storage(1024), in(block), out(block);
+  for (size_t i = 0; i < block; i++) {
+    in[i] = (uint16_t)i;
+  }
+  volatile uint32_t sink = 0;
+  struct cbuffer_handle cb;
+  cbuffer_init(&cb, storage.data(), sizeof(uint16_t), storage.size());
+
+  auto rate = [&](auto move_block) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t moved = 0; moved < kStreamCount; moved += block) {
+      move_block();
+      sink += out[block - 1];
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return kStreamCount / std::chrono::duration<double, std::micro>(stop - start).count();
+  };
+  // start part way through the ring so blocks keep straddling the wrap point
+  cbuffer_push_n(&cb, in.data(), block / 2);
+  double element_rate = rate([&] {
+    for (size_t i = 0; i < block; i++) {
+      cbuffer_push(&cb, &in[i]);
+    }
+    for (size_t i = 0; i < block; i++) {
+      cbuffer_pop(&cb, &out[i]);
+    }
+  });
+  double bulk_rate = rate([&] {
+    cbuffer_push_n(&cb, in.data(), block);
+    cbuffer_pop_n(&cb, out.data(), block);
+  });
+
+  printf("[ BENCH    ] %4zu sample blocks: element %8.2f M/s bulk %8.2f M/s\n", block, element_rate, bulk_rate);
+  RecordProperty("element_msps", std::to_string(element_rate));
+  RecordProperty("bulk_msps", std::to_string(bulk_rate));
+  // the last block popped lags by the half block queued up front
+  for (size_t i = 0; i < block; i++) {
+    EXPECT_EQ(out[i], in[(i + block / 2) % block]);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(BlockSize, CBufferBulkBench, ::testing::Values(4, 64, 256));
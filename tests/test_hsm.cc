@@ -16,6 +16,7 @@
 #include "mock_led.h"
 #include "mock_uassert.h"
 #include "mock_stm32h7xx.h"
+#include "mock_timebase.h"
 #include "mock_freertos.h"
 #include "mock_esc_engine.h"
 #include "mock_power_manager.h"
@@ -32,15 +33,19 @@ protected:
   MockDTC m_dtc;
   MockLED m_led;
   MockSTM32H7HAL m_stm32_hal;
+  MockTimebase m_timebase;
   MockFreeRTOS m_freertos;
   MockEscEngine m_esc_engine;
   MockPowerManager m_power_manager;
+  StaticQueue_t m_event_queue;
+  StaticQueue_t m_priority_queue;
 
   void SetUp() override {
     mock_logger = &m_logger;
     mock_uassert = &m_uassert;
     mock_led = &m_led;
     mock_stm32_hal = &m_stm32_hal;
+    mock_timebase = &m_timebase;
     mock_freertos = &m_freertos;
     mock_dtc = &m_dtc;
     mock_esc_engine = &m_esc_engine;
@@ -48,6 +53,19 @@ protected:
     struct hsm_context *ctx = test_hsm_get_context();
     ctx->current_state = HSM_STATE_RESET;
     ctx->next_state = HSM_STATE_RESET;
+    // events left queued in the mocked queue by a previous test are dropped
+    test_hsm_reset_event_pool();
+    test_hsm_build_lca_table();
+    test_hsm_reset_timers();
+    test_hsm_reset_trace();
+    memset(ctx->history, 0, sizeof(ctx->history));
+    ctx->deferred_count = 0;
+    ctx->event_queue = reinterpret_cast<QueueHandle_t>(&m_event_queue);
+    ctx->priority_queue = reinterpret_cast<QueueHandle_t>(&m_priority_queue);
+    // the priority queue is empty unless a test queues to it
+    EXPECT_CALL(m_freertos, xQueueReceive(ctx->priority_queue, ::testing::_, 0)).WillRepeatedly(::testing::Return(pdFALSE));
+    // 1 MHz timebase: ticks are microseconds
+    EXPECT_CALL(m_timebase, timebase_frequency()).WillRepeatedly(::testing::Return(1000000));
   }
 
   void TearDown() override {
@@ -55,6 +73,7 @@ protected:
     mock_uassert = nullptr;
     mock_led = nullptr;
     mock_stm32_hal = nullptr;
+    mock_timebase = nullptr;
     mock_freertos = nullptr;
     mock_dtc = nullptr;
     mock_esc_engine = nullptr;
@@ -82,14 +101,22 @@ TEST_F(HsmTestFixture, HsmTaskStart) {
   };
   struct hsm_context *ctx = test_hsm_get_context();
   TaskFunction_t hsm_main = test_hsm_get_main();
-  QueueHandle_t queue_handle;
+  StaticQueue_t queue_storage;
+  StaticQueue_t priority_queue_storage;
+  QueueHandle_t queue_handle = reinterpret_cast<QueueHandle_t>(&queue_storage);
+  QueueHandle_t priority_queue_handle = reinterpret_cast<QueueHandle_t>(&priority_queue_storage);
   BaseType_t base = pdPASS;
 
   EXPECT_CALL(
     *mock_freertos,
-    xQueueGenericCreateStatic(sizeof(ctx->event_queue_buffer), sizeof(enum hsm_event), ctx->event_queue_buffer, &ctx->event_queue_ctrl, queueQUEUE_TYPE_BASE))
+    xQueueGenericCreateStatic(HSM_EVENT_QUEUE_LEN, sizeof(struct hsm_event_msg *), ctx->event_queue_buffer, &ctx->event_queue_ctrl, queueQUEUE_TYPE_BASE))
     .Times(1)
     .WillOnce(::testing::Return(queue_handle));
+  EXPECT_CALL(
+    *mock_freertos,
+    xQueueGenericCreateStatic(HSM_PRIORITY_QUEUE_LEN, sizeof(struct hsm_event_msg *), ctx->priority_queue_buffer, &ctx->priority_queue_ctrl, queueQUEUE_TYPE_BASE))
+    .Times(1)
+    .WillOnce(::testing::Return(priority_queue_handle));
   EXPECT_CALL(
     *mock_freertos,
     xTaskCreate(hsm_main, task_ctx.name, task_ctx.stack_size, NULL, task_ctx.priority, &ctx->task_handle))
@@ -97,62 +124,250 @@ TEST_F(HsmTestFixture, HsmTaskStart) {
     .WillOnce(::testing::Return(base));
   EXPECT_CALL(*mock_uassert, assert_handler(::testing::_, ::testing::_, ::testing::_)).Times(0);
   EXPECT_CALL(*mock_led, led_init(&ctx->led_ctx[0], &hsm_init_ctx.led_init_ctx[0])).Times(1);
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
 
   hsm_start(&task_ctx);
 
-  EXPECT_EQ(ctx->hsm_tick_rate_ms, HSM_DEFAULT_TICK_RATE_MS) << "hsm tick rate not initialized to default";
   EXPECT_EQ(ctx->event_queue, queue_handle) << "event queue not initialized";
+  EXPECT_EQ(ctx->priority_queue, priority_queue_handle) << "priority queue not initialized";
   EXPECT_EQ(ctx->current_state, HSM_STATE_RESET) << "current state not set to reset state";
   EXPECT_EQ(ctx->next_state, HSM_STATE_RESET) << "next state not set to reset state";
   EXPECT_EQ(ctx->enter_timestamp, 0) << "enter timestamp not reset to 0";
 }
 
+// queue items are event pointers: match the pointer the item holds
+MATCHER_P(QueuesEvent, msg, "") { return *static_cast<struct hsm_event_msg *const *>(arg) == msg; }
+
+ACTION_P(SetArg1ToHsmEvent, param) { *static_cast<struct hsm_event_msg **>(arg1) = param; }
+
 TEST_F(HsmTestFixture, HsmEventPostSuccess){
   // event post success
-  enum hsm_event event = HSM_EVENT_ABORT;
-  EXPECT_CALL(*mock_freertos, xQueueGenericSend(::testing::_, &event, 0, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(pdPASS));
-  EXPECT_CALL(*mock_logger, logger_out);
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_STOP);
+  ASSERT_NE(msg, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(test_hsm_get_context()->event_queue, QueuesEvent(msg), 0, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_logger, logger_write);
   EXPECT_CALL(*mock_uassert, assert_handler(::testing::_, ::testing::_, ::testing::_)).Times(0);
-  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(&event, 0)) << "hsm event post reported failure";
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(msg, 0)) << "hsm event post reported failure";
+  // the queued reference now belongs to the HSM
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE - 1);
+  hsm_event_release(msg);
+}
+
+TEST_F(HsmTestFixture, HsmLogFilteredByModuleLevel) {
+  // hsm logging disabled at runtime: the post still succeeds but nothing reaches the logger
+  logger_levels[LOGGER_MODULE_HSM] = LOGGER_WARNING;
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(::testing::_, ::testing::_, 0, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_logger, logger_write).Times(0);
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_RUN, 0)) << "hsm event post reported failure";
+  // other modules keep their level
+  logger_levels[LOGGER_MODULE_SYSTEM] = LOGGER_DISABLE;
+  logger_levels[LOGGER_MODULE_HSM] = LOGGER_TRACE;
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(::testing::_, ::testing::_, 0, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_logger, logger_write(LOGGER_INFO, ::testing::_, ::testing::_, 1)).Times(1);
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_RUN, 0)) << "hsm event post reported failure";
+  logger_levels[LOGGER_MODULE_SYSTEM] = LOGGER_TRACE;
 }
 
 TEST_F(HsmTestFixture, HsmEventPostFail) {
   // queue full with blocking
-  enum hsm_event event = HSM_EVENT_RUN;
-  EXPECT_CALL(*mock_freertos, xQueueGenericSend(::testing::_, &event, 10, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(errQUEUE_FULL));
-  EXPECT_CALL(*mock_logger, logger_out);
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_RUN);
+  ASSERT_NE(msg, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(::testing::_, QueuesEvent(msg), 10, queueSEND_TO_BACK)).Times(1).WillOnce(::testing::Return(errQUEUE_FULL));
+  EXPECT_CALL(*mock_logger, logger_write);
   EXPECT_CALL(*mock_uassert, assert_handler(::testing::_, ::testing::_, ::testing::_)).Times(0);
-  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post_event(&event, 10)) << "hsm event post reported success";
+  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post_event(msg, 10)) << "hsm event post reported success";
+  // a rejected event goes straight back to the pool
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
 }
 
 TEST_F(HsmTestFixture, HsmEventPostISRSuccess){
   // event post from isr success
-  enum hsm_event event = HSM_EVENT_ABORT;
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_STOP);
+  ASSERT_NE(msg, nullptr);
   bool req_ctx_switch;
-  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(::testing::_, &event, ::testing::_, queueSEND_TO_BACK))
+  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(test_hsm_get_context()->event_queue, QueuesEvent(msg), ::testing::_, queueSEND_TO_BACK))
     .Times(1)
     .WillOnce(::testing::DoAll(
       ::testing::SetArgPointee<2>(pdTRUE),
       ::testing::Return(pdPASS)
     ));
   EXPECT_CALL(*mock_uassert, assert_handler(::testing::_, ::testing::_, ::testing::_)).Times(0);
-  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event_isr(&event, &req_ctx_switch)) << "hsm event post reported failure";
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event_isr(msg, &req_ctx_switch)) << "hsm event post reported failure";
   EXPECT_TRUE(req_ctx_switch);
+  hsm_event_release(msg);
 }
 
 TEST_F(HsmTestFixture, HsmEventPostISRFail) {
   // queue full from isr
-  enum hsm_event event = HSM_EVENT_RUN;
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_RUN);
+  ASSERT_NE(msg, nullptr);
   bool req_ctx_switch;
-  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(::testing::_, &event, ::testing::_, queueSEND_TO_BACK))
+  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(::testing::_, QueuesEvent(msg), ::testing::_, queueSEND_TO_BACK))
     .Times(1)
     .WillOnce(::testing::DoAll(
       ::testing::SetArgPointee<2>(pdFALSE),
       ::testing::Return(errQUEUE_FULL)
     ));
   EXPECT_CALL(*mock_uassert, assert_handler(::testing::_, ::testing::_, ::testing::_)).Times(0);
-  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post_event_isr(&event, &req_ctx_switch)) << "hsm event post did not succeed";
+  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post_event_isr(msg, &req_ctx_switch)) << "hsm event post did not succeed";
   EXPECT_FALSE(req_ctx_switch);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmPriorityEventPost) {
+  // abort bypasses the event queue and queues a wakeup ahead of the events already waiting
+  struct hsm_context *ctx = test_hsm_get_context();
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_ABORT);
+  ASSERT_NE(msg, nullptr);
+  ::testing::InSequence seq;
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->priority_queue, QueuesEvent(msg), 0, queueSEND_TO_BACK)).WillOnce(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, QueuesEvent(nullptr), 0, queueSEND_TO_FRONT)).WillOnce(::testing::Return(errQUEUE_FULL));
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  // a full event queue only loses the wakeup: the post still succeeds
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(msg, 0));
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE - 1);
+  hsm_event_release(msg);
+}
+
+TEST_F(HsmTestFixture, HsmPriorityEventPostISR) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_HARD_RESET);
+  ASSERT_NE(msg, nullptr);
+  bool req_ctx_switch;
+  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(ctx->priority_queue, QueuesEvent(msg), ::testing::_, queueSEND_TO_BACK))
+    .WillOnce(::testing::DoAll(::testing::SetArgPointee<2>(pdFALSE), ::testing::Return(pdPASS)));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSendFromISR(ctx->event_queue, QueuesEvent(nullptr), ::testing::_, queueSEND_TO_FRONT))
+    .WillOnce(::testing::DoAll(::testing::SetArgPointee<2>(pdTRUE), ::testing::Return(pdPASS)));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event_isr(msg, &req_ctx_switch));
+  // the wakeup unblocks the HSM task
+  EXPECT_TRUE(req_ctx_switch);
+  hsm_event_release(msg);
+}
+
+TEST_F(HsmTestFixture, HsmEventCoalescing) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  // repeated stops merge into the newest queued stop; payload events are always queued and a
+  // stop after them is queued again so the commands keep their order
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, ::testing::_, 0, queueSEND_TO_BACK)).Times(4).WillRepeatedly(::testing::Return(pdPASS));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_STOP, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_STOP, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_STOP, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_RUN, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_RUN, 0));
+  struct hsm_event_msg *stop = hsm_event_alloc(HSM_EVENT_STOP);
+  ASSERT_NE(stop, nullptr);
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(stop, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_STOP, 0));
+  // merged events go straight back to the pool
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE - 4);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_STOP], 3u);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_RUN], 0u);
+
+  // once the newest stop is taken off the queue a new one is queued again
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(stop), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  test_hsm_service_event_queue();
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, ::testing::_, 0, queueSEND_TO_BACK)).WillOnce(::testing::Return(pdPASS));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_STOP, 0));
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_STOP], 3u);
+}
+
+TEST_F(HsmTestFixture, HsmAbortCancelsEarlierRequests) {
+  // a run posted before an abort is discarded once the abort is handled; one posted after is not
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend).WillRepeatedly(::testing::Return(pdPASS));
+  struct hsm_event_msg *early = hsm_event_alloc(HSM_EVENT_RUN);
+  struct hsm_event_msg *abort = hsm_event_alloc(HSM_EVENT_ABORT);
+  struct hsm_event_msg *late = hsm_event_alloc(HSM_EVENT_RUN);
+  ASSERT_NE(early, nullptr);
+  ASSERT_NE(abort, nullptr);
+  ASSERT_NE(late, nullptr);
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(early, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(abort, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(late, 0));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(early), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(late), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->priority_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(abort), ::testing::Return(pdTRUE)))
+    .WillRepeatedly(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(1);
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_STARTUP);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_RUN], 1u);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmMergedAbortCancelsEarlierRequests) {
+  // the second abort is merged into the queued one but still cancels the run posted between them
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->priority_queue, ::testing::_, 0, queueSEND_TO_BACK)).Times(1).WillRepeatedly(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, ::testing::_, 0, ::testing::_)).WillRepeatedly(::testing::Return(pdPASS));
+  struct hsm_event_msg *abort = hsm_event_alloc(HSM_EVENT_ABORT);
+  struct hsm_event_msg *run = hsm_event_alloc(HSM_EVENT_RUN);
+  ASSERT_NE(abort, nullptr);
+  ASSERT_NE(run, nullptr);
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(abort, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(run, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post(HSM_EVENT_ABORT, 0));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(run), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->priority_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(abort), ::testing::Return(pdTRUE)))
+    .WillRepeatedly(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(0);
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_IDLE);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_ABORT], 1u);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_RUN], 1u);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmEventDropCount) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, ::testing::_, 0, queueSEND_TO_BACK)).WillRepeatedly(::testing::Return(errQUEUE_FULL));
+  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post(HSM_EVENT_STOP, 0));
+  // the rejected stop is not pending: the next one is not merged into it
+  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post(HSM_EVENT_STOP, 0));
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->priority_queue, ::testing::_, 0, queueSEND_TO_BACK)).WillOnce(::testing::Return(errQUEUE_FULL));
+  EXPECT_EQ(HSM_STATUS_EVE_QUEUE_FULL, hsm_post(HSM_EVENT_ABORT, 0));
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_STOP], 2u);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_ABORT], 1u);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_STOP], 0u);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
 }
 
 TEST_F(HsmTestFixture, HsmServiceEventNonePending) {
@@ -170,53 +385,524 @@ TEST_F(HsmTestFixture, HsmServiceEventNonePending) {
   EXPECT_EQ(ctx->next_state, current_state);
 }
 
-ACTION_P(SetArg1ToHsmEvent, param) { *static_cast<enum hsm_event*>(arg1) = param; }
-
 TEST_F(HsmTestFixture, HsmServiceEventProcessPending) {
   // simulate inbound abort event from queue during startup sequence
   struct hsm_context *ctx = test_hsm_get_context();
   ctx->current_state = HSM_STATE_RUN_STARTUP;
+  ctx->next_state = HSM_STATE_RUN_STARTUP;
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_ABORT);
+  ASSERT_NE(msg, nullptr);
   EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
-    .Times(1)
+    .Times(2)
     .WillOnce(::testing::DoAll(
-      SetArg1ToHsmEvent(HSM_EVENT_ABORT),
+      SetArg1ToHsmEvent(msg),
       ::testing::Return(pdTRUE)
-    ));
+    ))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(1);
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
 
   // run startup should defer to the parent run state to handle the abort event
   test_hsm_service_event_queue();
 
+  // the transition runs as soon as the event is handled
   EXPECT_EQ(ctx->next_state, HSM_STATE_STOP);
+  EXPECT_EQ(ctx->current_state, HSM_STATE_STOP);
+  // the HSM releases the queue's reference once the event is handled
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmServiceEventPayload) {
+  // a run request carries its profile through the queue without side channels
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_RUN);
+  ASSERT_NE(msg, nullptr);
+  msg->payload.run.profile_id = 7;
+  msg->payload.run.setpoint = 1250.0f;
+  // the poster keeps its own reference to inspect the event after handling
+  hsm_event_ref(msg);
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .Times(2)
+    .WillOnce(::testing::DoAll(
+      SetArg1ToHsmEvent(msg),
+      ::testing::Return(pdTRUE)
+    ))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(1);
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_STARTUP);
+  EXPECT_EQ(ctx->run_params.profile_id, 7);
+  EXPECT_FLOAT_EQ(ctx->run_params.setpoint, 1250.0f);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE - 1);
+  EXPECT_EQ(msg->refcount, 1);
+  hsm_event_release(msg);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmServiceEventDrainsInOrder) {
+  // both events are drained in one wakeup and the second is handled in the state the first led to
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_ERROR;
+  ctx->next_state = HSM_STATE_ERROR;
+  struct hsm_event_msg *clear = hsm_event_alloc(HSM_EVENT_CLEAR_ERROR);
+  struct hsm_event_msg *calibrate = hsm_event_alloc(HSM_EVENT_CALIBRATION);
+  ASSERT_NE(clear, nullptr);
+  ASSERT_NE(calibrate, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .Times(3)
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(clear), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(calibrate), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_disable(::testing::_)).Times(2);
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_CALIBRATION);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmPriorityEventOvertakes) {
+  // an abort posted behind a calibration request is handled first, woken by the wakeup at the
+  // front of the event queue, and the calibration it overtook is cancelled rather than started
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  struct hsm_event_msg *calibrate = hsm_event_alloc(HSM_EVENT_CALIBRATION);
+  struct hsm_event_msg *abort = hsm_event_alloc(HSM_EVENT_ABORT);
+  ASSERT_NE(calibrate, nullptr);
+  ASSERT_NE(abort, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend).WillRepeatedly(::testing::Return(pdPASS));
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(calibrate, 0));
+  EXPECT_EQ(HSM_STATUS_OK, hsm_post_event(abort, 0));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(nullptr), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(calibrate), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->priority_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(abort), ::testing::Return(pdTRUE)))
+    .WillRepeatedly(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_led, led_disable).Times(0);
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_IDLE);
+  struct hsm_trace_record records[HSM_TRACE_LEN];
+  ASSERT_EQ(hsm_trace_snapshot(records, HSM_TRACE_LEN), 1u);
+  EXPECT_EQ(records[0].event, HSM_EVENT_ABORT);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmDeferredEventRecalledOnExit) {
+  // requests arriving during reset wait for it to finish instead of raising a DTC
+  struct hsm_context *ctx = test_hsm_get_context();
+  struct hsm_event_msg *run = hsm_event_alloc(HSM_EVENT_RUN);
+  struct hsm_event_msg *calibrate = hsm_event_alloc(HSM_EVENT_CALIBRATION);
+  ASSERT_NE(run, nullptr);
+  ASSERT_NE(calibrate, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(run), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(calibrate), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_dtc, dtc_post_event).Times(0);
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RESET);
+  EXPECT_EQ(ctx->deferred_count, 2);
+  // the deferred references keep both events out of the pool
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE - 2);
+
+  // leaving reset puts them back at the front of the queue in their original order
+  {
+    ::testing::InSequence seq;
+    EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, QueuesEvent(calibrate), 0, queueSEND_TO_FRONT)).WillOnce(::testing::Return(pdPASS));
+    EXPECT_CALL(*mock_freertos, xQueueGenericSend(ctx->event_queue, QueuesEvent(run), 0, queueSEND_TO_FRONT)).WillOnce(::testing::Return(pdPASS));
+  }
+  EXPECT_CALL(*mock_led, led_disable(::testing::_)).Times(HSM_LED_ID_COUNT);
+  ctx->next_state = HSM_STATE_INIT;
+  test_hsm_transition();
+  EXPECT_EQ(ctx->deferred_count, 0);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.deferred[HSM_EVENT_RUN], 1u);
+  EXPECT_EQ(stats.deferred[HSM_EVENT_CALIBRATION], 1u);
+  hsm_event_release(run);
+  hsm_event_release(calibrate);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmUnhandledEventReachesRoot) {
+  // with nothing to stop a stop is ignored, a resume without a pause is a fault
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_IDLE;
+  struct hsm_event_msg *stop = hsm_event_alloc(HSM_EVENT_STOP);
+  struct hsm_event_msg *resume = hsm_event_alloc(HSM_EVENT_RESUME);
+  ASSERT_NE(stop, nullptr);
+  ASSERT_NE(resume, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(stop), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(resume), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_dtc, dtc_post_event(DTCID_HSM_UNHANDLED_EVENT)).Times(1);
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_IDLE);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmHardResetRestarts) {
+  // a hard reset is handled by the root from any state and forgets the run history
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_RUN_PROFILE;
+  ctx->next_state = HSM_STATE_RUN_PROFILE;
+  ctx->history[HSM_STATE_RUN] = HSM_STATE_RUN_PROFILE;
+  struct hsm_event_msg *reset = hsm_event_alloc(HSM_EVENT_HARD_RESET);
+  ASSERT_NE(reset, nullptr);
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(reset), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  EXPECT_CALL(*mock_dtc, dtc_post_event).Times(0);
+  EXPECT_CALL(*mock_led, led_enable).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_led, led_disable).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  test_hsm_service_event_queue();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RESET);
+  EXPECT_EQ(ctx->history[HSM_STATE_RUN], HSM_STATE_ROOT);
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
+}
+
+TEST_F(HsmTestFixture, HsmShallowHistory) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+
+  // without history run starts in its initial substate
+  ctx->current_state = HSM_STATE_PAUSE;
+  ctx->next_state = HSM_STATE_RUN;
+  test_hsm_transition();
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_STARTUP);
+
+  // paused in the profile, run resumes the profile without replaying startup
+  ctx->next_state = HSM_STATE_RUN_PROFILE;
+  test_hsm_transition();
+  ctx->next_state = HSM_STATE_PAUSE;
+  test_hsm_transition();
+  EXPECT_EQ(ctx->history[HSM_STATE_RUN], HSM_STATE_RUN_PROFILE);
+  ctx->next_state = HSM_STATE_RUN;
+  test_hsm_transition();
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_PROFILE);
+  EXPECT_EQ(ctx->next_state, HSM_STATE_RUN_PROFILE);
+  // the run timer is armed again on re-entry
+  EXPECT_TRUE(twheel_timer_pending(&ctx->timers[HSM_STATE_RUN].node));
+
+  // explicit substate targets ignore history
+  ctx->next_state = HSM_STATE_PAUSE;
+  test_hsm_transition();
+  ctx->next_state = HSM_STATE_RUN_STARTUP;
+  test_hsm_transition();
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_STARTUP);
+}
+
+TEST_F(HsmTestFixture, HsmTickScheduling) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_INIT;
+  ctx->next_state = HSM_STATE_ERROR;
+  ctx->pending_dtc = DTCID_NONE;
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(100));
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_ERROR])).Times(1);
+  test_hsm_enter_state();
+
+  // a newly entered state ticks straight away, then on its own period
+  EXPECT_EQ(test_hsm_next_tick_wait(100), 0u);
+  EXPECT_CALL(*mock_led, led_toggle(&ctx->led_ctx[HSM_LED_ID_ERROR])).Times(1);
+  test_hsm_tick_states(100);
+  EXPECT_EQ(test_hsm_next_tick_wait(101), 9u);
+  // nothing is due before the deadline
+  test_hsm_tick_states(109);
+  EXPECT_EQ(test_hsm_next_tick_wait(109), 1u);
+  // the wait is wrap safe across the tick counter overflow
+  ctx->tick_deadline[HSM_STATE_ERROR] = 5;
+  EXPECT_EQ(test_hsm_next_tick_wait(0xFFFFFFFEu), 7u);
+}
+
+TEST_F(HsmTestFixture, HsmTickNearestDeadline) {
+  // the wait is the nearest deadline of any active state in the hierarchy
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_RUN_STARTUP;
+  ctx->tick_deadline[HSM_STATE_RUN_STARTUP] = 110;
+  EXPECT_EQ(test_hsm_next_tick_wait(100), 10u);
+  EXPECT_CALL(*mock_led, led_toggle).Times(0);
+  test_hsm_tick_states(110);
+  EXPECT_EQ(ctx->tick_deadline[HSM_STATE_RUN_STARTUP], 120u);
+  EXPECT_EQ(ctx->next_state, HSM_STATE_RUN_PROFILE);
+  // states without periodic work never wake the task
+  ctx->current_state = HSM_STATE_RUN_PROFILE;
+  EXPECT_EQ(test_hsm_next_tick_wait(100), portMAX_DELAY);
+  ctx->current_state = HSM_STATE_CALIBRATION;
+  EXPECT_EQ(test_hsm_next_tick_wait(100), portMAX_DELAY);
+}
+
+TEST_F(HsmTestFixture, HsmResetTimer) {
+  // reset holds the lamp test on a timer instead of blocking the task
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_ROOT;
+  ctx->next_state = HSM_STATE_RESET;
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_led, led_enable).Times(HSM_LED_ID_COUNT);
+  EXPECT_CALL(*mock_freertos, vTaskDelay).Times(0);
+  test_hsm_transition();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RESET);
+  EXPECT_EQ(test_hsm_next_timer_wait(0), pdMS_TO_TICKS(500));
+  EXPECT_EQ(test_hsm_next_timer_wait(200), pdMS_TO_TICKS(300));
+  test_hsm_expire_timers(499);
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RESET);
+
+  EXPECT_CALL(*mock_led, led_disable).Times(HSM_LED_ID_COUNT);
+  test_hsm_expire_timers(500);
+  EXPECT_EQ(ctx->current_state, HSM_STATE_INIT);
+  EXPECT_EQ(test_hsm_next_timer_wait(500), portMAX_DELAY);
+}
+
+TEST_F(HsmTestFixture, HsmStateTimerCancelledOnExit) {
+  // the idle LED blinks from a periodic state timer that stops with the state
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_INIT;
+  ctx->next_state = HSM_STATE_IDLE;
+  TickType_t now = 0;
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::ReturnPointee(&now));
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+  test_hsm_transition();
+
+  EXPECT_CALL(*mock_led, led_toggle(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(3);
+  now = 3500;
+  test_hsm_expire_timers(now);
+  EXPECT_EQ(test_hsm_next_timer_wait(now), pdMS_TO_TICKS(500));
+
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+  ctx->next_state = HSM_STATE_CALIBRATION;
+  test_hsm_transition();
+  EXPECT_FALSE(twheel_timer_pending(&ctx->timers[HSM_STATE_IDLE].node));
+  EXPECT_EQ(test_hsm_next_timer_wait(now), portMAX_DELAY);
+}
+
+TEST_F(HsmTestFixture, HsmEventPoolExhaustion) {
+  struct hsm_event_msg *msgs[HSM_EVENT_POOL_SIZE];
+  for (auto &msg : msgs) {
+    msg = hsm_event_alloc(HSM_EVENT_STOP);
+    ASSERT_NE(msg, nullptr);
+    EXPECT_EQ(msg->event, HSM_EVENT_STOP);
+    EXPECT_EQ(msg->refcount, 1);
+  }
+  EXPECT_EQ(hsm_event_pool_available(), 0);
+  EXPECT_EQ(hsm_event_alloc(HSM_EVENT_ABORT), nullptr);
+  // posting without a free event fails before touching the queue
+  EXPECT_CALL(*mock_freertos, xQueueGenericSend).Times(0);
+  EXPECT_CALL(*mock_logger, logger_write);
+  EXPECT_EQ(hsm_post(HSM_EVENT_RUN, 0), HSM_STATUS_EVE_POOL_EMPTY);
+  hsm_event_release(msgs[3]);
+  struct hsm_event_msg *reused = hsm_event_alloc(HSM_EVENT_ABORT);
+  EXPECT_EQ(reused, msgs[3]);
+  EXPECT_EQ(reused->event, HSM_EVENT_ABORT);
+  for (auto &msg : msgs) {
+    hsm_event_release(msg);
+  }
+  EXPECT_EQ(hsm_event_pool_available(), HSM_EVENT_POOL_SIZE);
 }
 
 TEST_F(HsmTestFixture, HsmEnterState) {
   struct hsm_context *ctx = test_hsm_get_context();
   ctx->current_state = HSM_STATE_INIT;
   ctx->next_state = HSM_STATE_IDLE;
-  const uint32_t enter_ts = 10000;
-  EXPECT_CALL(*mock_stm32_hal, HAL_GetTick())
-    .Times(1)
-    .WillOnce(::testing::Return(enter_ts));
+  const uint64_t enter_ts = 0x100002710ull;
+  EXPECT_CALL(*mock_timebase, timebase_now())
+    .Times(2)
+    .WillOnce(::testing::Return(enter_ts))
+    .WillOnce(::testing::Return(enter_ts + 40));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
   EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
 
   test_hsm_enter_state();
 
   EXPECT_EQ(ctx->enter_timestamp, enter_ts);
   EXPECT_EQ(ctx->current_state, ctx->next_state);
+  struct hsm_latency_stats stats;
+  hsm_latency_snapshot(&stats);
+  EXPECT_EQ(stats.enter[HSM_STATE_IDLE].buckets[6], 1u);  // [32, 64) us
+  EXPECT_EQ(stats.enter[HSM_STATE_IDLE].max_us, 40u);
 }
 
 TEST_F(HsmTestFixture, HsmExitState) {
   struct hsm_context *ctx = test_hsm_get_context();
   ctx->current_state = HSM_STATE_IDLE;
-  const uint32_t exit_ts = 10000;
-  EXPECT_CALL(*mock_stm32_hal, HAL_GetTick())
-    .Times(1)
+  const uint64_t exit_ts = 0x100002710ull;
+  EXPECT_CALL(*mock_timebase, timebase_now())
+    .Times(2)
+    .WillOnce(::testing::Return(exit_ts - 3))
     .WillOnce(::testing::Return(exit_ts));
   EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
 
   test_hsm_exit_state();
 
   EXPECT_EQ(ctx->exit_timestamp, exit_ts);
+  struct hsm_latency_stats stats;
+  hsm_latency_snapshot(&stats);
+  EXPECT_EQ(stats.exit[HSM_STATE_IDLE].buckets[2], 1u);  // [2, 4) us
+}
+
+TEST_F(HsmTestFixture, HsmTraceAndLatency) {
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_ERROR;
+  ctx->next_state = HSM_STATE_ERROR;
+  ctx->tick_deadline[HSM_STATE_ERROR] = 0;
+  // every timebase read advances 10 us
+  uint64_t now = 1000;
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Invoke([&now]() { return now += 10; }));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_led, led_toggle(&ctx->led_ctx[HSM_LED_ID_ERROR])).Times(1);
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_ERROR])).Times(1);
+  EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+
+  // tick: 1010 to 1020
+  test_hsm_tick_states(0);
+
+  struct hsm_event_msg *msg = hsm_event_alloc(HSM_EVENT_CLEAR_ERROR);
+  ASSERT_NE(msg, nullptr);
+  msg->post_timestamp = 1000;
+  EXPECT_CALL(*mock_freertos, xQueueReceive(ctx->event_queue, ::testing::_, 0))
+    .Times(2)
+    .WillOnce(::testing::DoAll(SetArg1ToHsmEvent(msg), ::testing::Return(pdTRUE)))
+    .WillOnce(::testing::Return(pdFALSE));
+  // dispatch from 1030: exit error 1040 to 1050, enter idle 1060 to 1070, done 1080
+  test_hsm_service_event_queue();
+
+  struct hsm_trace_record trace[HSM_TRACE_LEN];
+  ASSERT_EQ(hsm_trace_snapshot(trace, HSM_TRACE_LEN), 2u);
+  EXPECT_EQ(trace[0].kind, HSM_TRACE_TICK);
+  EXPECT_EQ(trace[0].from, HSM_STATE_ERROR);
+  EXPECT_EQ(trace[0].timestamp, 1010u);
+  EXPECT_EQ(trace[0].duration, 10u);
+  EXPECT_EQ(trace[1].kind, HSM_TRACE_EVENT);
+  EXPECT_EQ(trace[1].event, HSM_EVENT_CLEAR_ERROR);
+  EXPECT_EQ(trace[1].from, HSM_STATE_ERROR);
+  EXPECT_EQ(trace[1].to, HSM_STATE_IDLE);
+  EXPECT_EQ(trace[1].timestamp, 1030u);
+  EXPECT_EQ(trace[1].duration, 50u);
+
+  struct hsm_latency_stats stats;
+  hsm_latency_snapshot(&stats);
+  EXPECT_EQ(stats.tick[HSM_STATE_ERROR].buckets[4], 1u);               // [8, 16) us
+  EXPECT_EQ(stats.queue_wait[HSM_EVENT_CLEAR_ERROR].buckets[5], 1u);   // [16, 32) us
+  EXPECT_EQ(stats.dispatch[HSM_EVENT_CLEAR_ERROR].buckets[6], 1u);     // [32, 64) us
+  EXPECT_EQ(stats.dispatch[HSM_EVENT_CLEAR_ERROR].max_us, 50u);
+  EXPECT_EQ(stats.exit[HSM_STATE_ERROR].buckets[4], 1u);
+  EXPECT_EQ(stats.enter[HSM_STATE_IDLE].buckets[4], 1u);
+}
+
+TEST_F(HsmTestFixture, HsmTraceKeepsNewest) {
+  // the trace overwrites its oldest records and saturates long samples in the last bucket
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_ERROR;
+  ctx->tick_deadline[HSM_STATE_ERROR] = 0;
+  uint64_t now = 0;
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Invoke([&now]() { return now += 100000; }));
+  EXPECT_CALL(*mock_led, led_toggle).Times(HSM_TRACE_LEN * 2);
+  for (TickType_t tick = 0; tick < HSM_TRACE_LEN * 2; tick++) {
+    test_hsm_tick_states(tick * 10);
+  }
+  struct hsm_trace_record trace[HSM_TRACE_LEN];
+  const size_t n = hsm_trace_snapshot(trace, HSM_TRACE_LEN);
+  ASSERT_GT(n, 0u);
+  EXPECT_EQ(trace[n - 1].timestamp, (HSM_TRACE_LEN * 2 * 2 - 1) * 100000ull);
+  struct hsm_latency_stats stats;
+  hsm_latency_snapshot(&stats);
+  EXPECT_EQ(stats.tick[HSM_STATE_ERROR].buckets[HSM_LATENCY_BUCKETS - 1], HSM_TRACE_LEN * 2u);
+  EXPECT_EQ(stats.tick[HSM_STATE_ERROR].max_us, 100000u);
+}
+
+TEST_F(HsmTestFixture, HsmLeastCommonAncestor) {
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_RUN_STARTUP, HSM_STATE_RUN_PROFILE), HSM_STATE_RUN);
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_RUN_PROFILE, HSM_STATE_RUN), HSM_STATE_RUN);
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_RUN, HSM_STATE_RUN_STARTUP), HSM_STATE_RUN);
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_RUN_PROFILE, HSM_STATE_STOP), HSM_STATE_ROOT);
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_IDLE, HSM_STATE_RUN_STARTUP), HSM_STATE_ROOT);
+  EXPECT_EQ(test_hsm_lca(HSM_STATE_IDLE, HSM_STATE_IDLE), HSM_STATE_IDLE);
+}
+
+TEST_F(HsmTestFixture, HsmSiblingTransitionKeepsParent) {
+  // moving between run substates neither exits nor re-enters run
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_RUN_STARTUP;
+  ctx->next_state = HSM_STATE_RUN_PROFILE;
+  ctx->tick_deadline[HSM_STATE_RUN] = 600;
+  EXPECT_CALL(*mock_led, led_enable).Times(0);
+  EXPECT_CALL(*mock_led, led_disable).Times(0);
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(100));
+
+  test_hsm_transition();
+
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_PROFILE);
+  EXPECT_EQ(ctx->tick_deadline[HSM_STATE_RUN], 600u);
+  EXPECT_EQ(ctx->tick_deadline[HSM_STATE_RUN_PROFILE], 100u);
+}
+
+TEST_F(HsmTestFixture, HsmTransitionOrder) {
+  // exits run innermost first and enters run outermost first
+  struct hsm_context *ctx = test_hsm_get_context();
+  ctx->current_state = HSM_STATE_IDLE;
+  ctx->next_state = HSM_STATE_RUN_STARTUP;
+  EXPECT_CALL(*mock_logger, logger_write).Times(::testing::AnyNumber());
+  EXPECT_CALL(*mock_timebase, timebase_now()).WillRepeatedly(::testing::Return(0));
+  EXPECT_CALL(*mock_freertos, xTaskGetTickCount()).WillRepeatedly(::testing::Return(0));
+  {
+    ::testing::InSequence seq;
+    EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_IDLE])).Times(1);
+    EXPECT_CALL(*mock_led, led_enable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(1);
+  }
+  test_hsm_transition();
+  EXPECT_EQ(ctx->current_state, HSM_STATE_RUN_STARTUP);
+
+  ctx->next_state = HSM_STATE_STOP;
+  EXPECT_CALL(*mock_led, led_disable(&ctx->led_ctx[HSM_LED_ID_RUN])).Times(1);
+  test_hsm_transition();
+  EXPECT_EQ(ctx->current_state, HSM_STATE_STOP);
 }
 
 TEST(HsmTest, HsmGetState) {
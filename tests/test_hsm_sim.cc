@@ -0,0 +1,492 @@
+/**
+ * @file test_hsm_sim.cc
+ * @brief Host simulation of the HSM task in virtual time
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ * Runs the real hsm_main loop against the virtual time kernel in sim_freertos.h and replays
+ * scripted event sequences. Each scenario checks the transition sequence and its timing, and
+ * prints the transition trace and a latency report.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mock_logger.h"
+#include "mock_dtc.h"
+#include "mock_led.h"
+#include "mock_uassert.h"
+#include "mock_esc_engine.h"
+#include "mock_power_manager.h"
+#include "sim_freertos.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include "hsm.h"
+}
+
+namespace {
+
+const char *const kEventNames[HSM_EVENT_COUNT] = {
+  "NONE", "SOFT_RESET", "HARD_RESET", "RUN", "STOP", "ABORT", "CLEAR_ERROR", "CALIBRATION", "PAUSE", "RESUME", "TIMEOUT",
+};
+
+const char *state_name(const enum hsm_state state) {
+  switch (state) {
+    case HSM_STATE_ROOT: return "ROOT";
+    case HSM_STATE_RESET: return "RESET";
+    case HSM_STATE_INIT: return "INIT";
+    case HSM_STATE_IDLE: return "IDLE";
+    case HSM_STATE_RUN: return "RUN";
+    case HSM_STATE_STOP: return "STOP";
+    case HSM_STATE_ERROR: return "ERROR";
+    case HSM_STATE_CALIBRATION: return "CALIBRATION";
+    case HSM_STATE_PAUSE: return "PAUSE";
+    case HSM_STATE_RUN_STARTUP: return "RUN_STARTUP";
+    case HSM_STATE_RUN_PROFILE: return "RUN_PROFILE";
+    default: return "?";
+  }
+}
+
+// scripted event posted at a virtual time (ms)
+struct Step {
+  TickType_t at;
+  enum hsm_event event;
+  struct hsm_run_params run;
+  struct hsm_calibration_params calibration;
+};
+
+struct Transition {
+  TickType_t at;
+  enum hsm_state state;
+  bool operator==(const Transition &other) const { return at == other.at && state == other.state; }
+};
+
+void PrintTo(const Transition &t, std::ostream *os) {
+  *os << "{" << t.at << " ms, " << state_name(t.state) << "}";
+}
+
+uint32_t hist_count(const struct hsm_latency_hist &hist) {
+  uint32_t count = 0;
+  for (uint32_t bucket : hist.buckets) {
+    count += bucket;
+  }
+  return count;
+}
+
+} // namespace
+
+class HsmSimFixture : public ::testing::Test {
+protected:
+  ::testing::NiceMock<MockLogger> m_logger;
+  ::testing::NiceMock<MockLED> m_led;
+  ::testing::NiceMock<MockDTC> m_dtc;
+  ::testing::NiceMock<MockEscEngine> m_esc_engine;
+  ::testing::NiceMock<MockPowerManager> m_power_manager;
+  MockUassert m_uassert;
+  SimKernel kernel;
+
+  std::deque<Step> script;
+  std::vector<Transition> transitions;
+  TickType_t end = 0;
+  uint32_t dropped_posts = 0;
+
+  void SetUp() override {
+    mock_logger = &m_logger;
+    mock_led = &m_led;
+    mock_dtc = &m_dtc;
+    mock_esc_engine = &m_esc_engine;
+    mock_power_manager = &m_power_manager;
+    mock_uassert = &m_uassert;
+    sim_kernel = &kernel;
+    EXPECT_CALL(m_uassert, assert_handler).Times(0);
+    kernel.on_block = [this](TickType_t wait) { return block(wait); };
+    kernel.on_receive = [this]() { observe(); };
+    // events still queued when a previous simulation ended are dropped
+    test_hsm_reset_event_pool();
+  }
+
+  void TearDown() override {
+    mock_logger = nullptr;
+    mock_led = nullptr;
+    mock_dtc = nullptr;
+    mock_esc_engine = nullptr;
+    mock_power_manager = nullptr;
+    mock_uassert = nullptr;
+    sim_kernel = nullptr;
+  }
+
+  // sampled on every queue receive: states left within the same wakeup (INIT) are not seen
+  void observe() {
+    const enum hsm_state state = hsm_get_current_state();
+    if (transitions.empty() || transitions.back().state != state) {
+      transitions.push_back({kernel.now, state});
+    }
+  }
+
+  void post(const Step &step) {
+    struct hsm_event_msg *msg = hsm_event_alloc(step.event);
+    if (msg == NULL) {
+      dropped_posts++;
+      return;
+    }
+    if (step.event == HSM_EVENT_RUN) {
+      msg->payload.run = step.run;
+    } else if (step.event == HSM_EVENT_CALIBRATION) {
+      msg->payload.calibration = step.calibration;
+    }
+    if (hsm_post_event(msg, 0) != HSM_STATUS_OK) {
+      dropped_posts++;
+    }
+  }
+
+  // the HSM task would block for `wait` ticks: run the script up to the first wakeup
+  bool block(TickType_t wait) {
+    const TickType_t deadline = wait == portMAX_DELAY || end - kernel.now < wait ? end : kernel.now + wait;
+    if (!script.empty() && script.front().at <= deadline) {
+      kernel.advance(script.front().at);
+      while (!script.empty() && script.front().at == kernel.now) {
+        post(script.front());
+        script.pop_front();
+      }
+      return true;
+    }
+    kernel.advance(deadline);
+    return deadline != end;
+  }
+
+  // boot the HSM and run the script until `until` ms of virtual time
+  void run(TickType_t until) {
+    static const struct hsm_init_context init = {
+      .led_init_ctx = {},
+      .num_led_init_ctx = HSM_LED_ID_COUNT,
+    };
+    const struct system_task_context task_ctx = {
+      .name = "hsm",
+      .priority = 1,
+      .stack_size = 1024,
+      .init_ctx = &init,
+    };
+    end = until;
+    hsm_start(&task_ctx);
+    kernel.run();
+    observe();
+  }
+
+  void report() {
+    printf("[ SIM      ] transitions\n");
+    for (const Transition &t : transitions) {
+      printf("[ SIM      ] %8u ms  %s\n", (unsigned)t.at, state_name(t.state));
+    }
+    struct hsm_trace_record trace[HSM_TRACE_LEN];
+    const size_t n = hsm_trace_snapshot(trace, HSM_TRACE_LEN);
+    printf("[ SIM      ] trace (last %zu)\n", n);
+    for (size_t i = 0; i < n; i++) {
+      printf("[ SIM      ] %8llu.%06llu ms  %-5s %-11s %-11s -> %-11s %6u ns\n",
+             (unsigned long long)(trace[i].timestamp / 1000000u), (unsigned long long)(trace[i].timestamp % 1000000u),
+             trace[i].kind == HSM_TRACE_TICK ? "tick" : "event", trace[i].kind == HSM_TRACE_TICK ? "" : kEventNames[trace[i].event],
+             state_name((enum hsm_state)trace[i].from), state_name((enum hsm_state)trace[i].to), (unsigned)trace[i].duration);
+    }
+    struct hsm_latency_stats stats;
+    hsm_latency_snapshot(&stats);
+    struct hsm_queue_stats queue;
+    hsm_queue_stats_snapshot(&queue);
+    printf("[ SIM      ] %-12s %8s %14s %14s %10s %8s %9s\n", "event", "count", "queue max us", "dispatch max us", "coalesced", "dropped", "deferred");
+    for (int e = 0; e < HSM_EVENT_COUNT; e++) {
+      if (hist_count(stats.dispatch[e]) > 0 || queue.coalesced[e] > 0 || queue.dropped[e] > 0 || queue.deferred[e] > 0) {
+        printf("[ SIM      ] %-12s %8u %14u %14u %10u %8u %9u\n", kEventNames[e], hist_count(stats.dispatch[e]), stats.queue_wait[e].max_us,
+               stats.dispatch[e].max_us, queue.coalesced[e], queue.dropped[e], queue.deferred[e]);
+      }
+    }
+    printf("[ SIM      ] %-12s %8s %14s\n", "state", "ticks", "tick max us");
+    for (int s = 0; s < HSM_STATE_COUNT; s++) {
+      if (hist_count(stats.tick[s]) > 0) {
+        printf("[ SIM      ] %-12s %8u %14u\n", state_name((enum hsm_state)s), hist_count(stats.tick[s]), stats.tick[s].max_us);
+      }
+    }
+  }
+};
+
+TEST_F(HsmSimFixture, BootReachesIdle) {
+  run(2000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+}
+
+TEST_F(HsmSimFixture, RunStop) {
+  script = {
+    {1000, HSM_EVENT_RUN, {.profile_id = 3, .setpoint = 1500.0f}, {}},
+    {3000, HSM_EVENT_STOP, {}, {}},
+  };
+  run(4000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+    {1000, HSM_STATE_RUN_STARTUP},
+    {1000, HSM_STATE_RUN_PROFILE},
+    {3000, HSM_STATE_STOP},
+    {3000, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+  EXPECT_EQ(test_hsm_get_context()->run_params.profile_id, 3);
+  EXPECT_EQ(dropped_posts, 0u);
+}
+
+TEST_F(HsmSimFixture, AbortDuringRun) {
+  script = {
+    {1000, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1200, HSM_EVENT_ABORT, {}, {}},
+  };
+  run(2000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+    {1000, HSM_STATE_RUN_STARTUP},
+    {1000, HSM_STATE_RUN_PROFILE},
+    {1200, HSM_STATE_STOP},
+    {1200, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+}
+
+TEST_F(HsmSimFixture, Calibration) {
+  script = {
+    {1000, HSM_EVENT_CALIBRATION, {}, {.channel = 2, .trim = 0.5f, .scale = 1.25f}},
+    {1500, HSM_EVENT_STOP, {}, {}},
+  };
+  run(2000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+    {1000, HSM_STATE_CALIBRATION},
+    {1500, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+  EXPECT_EQ(test_hsm_get_context()->calibration_params.channel, 2);
+  EXPECT_FLOAT_EQ(test_hsm_get_context()->calibration_params.scale, 1.25f);
+}
+
+TEST_F(HsmSimFixture, AbortDuringResetIsNotDelayed) {
+  // the reset lamp test must not hold off events: the abort is dispatched when it is posted
+  script = {{100, HSM_EVENT_ABORT, {}, {}}};
+  run(1000);
+  report();
+  struct hsm_trace_record trace[HSM_TRACE_LEN];
+  const size_t n = hsm_trace_snapshot(trace, HSM_TRACE_LEN);
+  bool found = false;
+  for (size_t i = 0; i < n; i++) {
+    if (trace[i].kind == HSM_TRACE_EVENT && trace[i].event == HSM_EVENT_ABORT) {
+      EXPECT_EQ(trace[i].timestamp / 1000000u, 100u);
+      EXPECT_EQ(trace[i].from, HSM_STATE_RESET);
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+  EXPECT_EQ(transitions.back().state, HSM_STATE_IDLE);
+}
+
+// events dispatched as traced, without state timeouts
+std::vector<enum hsm_event> traced_events() {
+  struct hsm_trace_record records[HSM_TRACE_LEN];
+  const size_t n = hsm_trace_snapshot(records, HSM_TRACE_LEN);
+  std::vector<enum hsm_event> events;
+  for (size_t i = 0; i < n; i++) {
+    if (records[i].kind == HSM_TRACE_EVENT && records[i].event != HSM_EVENT_TIMEOUT) {
+      events.push_back((enum hsm_event)records[i].event);
+    }
+  }
+  return events;
+}
+
+TEST_F(HsmSimFixture, AbortCancelsEarlierRequests) {
+  // an abort overtakes the requests posted ahead of it and cancels them; the burst of stops
+  // collapses into the one still queued
+  script = {
+    {1000, HSM_EVENT_CALIBRATION, {}, {.channel = 1, .trim = 0.0f, .scale = 1.0f}},
+    {1000, HSM_EVENT_ABORT, {}, {}},
+    {1200, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1200, HSM_EVENT_ABORT, {}, {}},
+    {1500, HSM_EVENT_STOP, {}, {}},
+    {1500, HSM_EVENT_STOP, {}, {}},
+    {1500, HSM_EVENT_STOP, {}, {}},
+    {1500, HSM_EVENT_STOP, {}, {}},
+  };
+  run(2000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+  EXPECT_EQ(dropped_posts, 0u);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_CALIBRATION], 1u);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_RUN], 1u);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_STOP], 3u);
+  const std::vector<enum hsm_event> expected_events = {HSM_EVENT_ABORT, HSM_EVENT_ABORT, HSM_EVENT_STOP};
+  EXPECT_EQ(traced_events(), expected_events);
+}
+
+TEST_F(HsmSimFixture, MergedAbortCancelsEarlierRun) {
+  // the second abort merges into the first, which is still queued, and the run between them is
+  // cancelled: the last command was an abort
+  script = {
+    {1000, HSM_EVENT_ABORT, {}, {}},
+    {1000, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1000, HSM_EVENT_ABORT, {}, {}},
+  };
+  run(2000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_ABORT], 1u);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_RUN], 1u);
+}
+
+TEST_F(HsmSimFixture, RunStopBurstKeepsOrder) {
+  // the last command wins: the second stop is not merged into the first across the second run
+  script = {
+    {1000, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1000, HSM_EVENT_STOP, {}, {}},
+    {1000, HSM_EVENT_RUN, {.profile_id = 2, .setpoint = 100.0f}, {}},
+    {1000, HSM_EVENT_STOP, {}, {}},
+  };
+  run(2000);
+  report();
+  EXPECT_EQ(transitions.back().state, HSM_STATE_IDLE);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.coalesced[HSM_EVENT_STOP], 0u);
+}
+
+TEST_F(HsmSimFixture, PauseResumeBurstKeepsOrder) {
+  script = {
+    {1000, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1200, HSM_EVENT_PAUSE, {}, {}},
+    {1200, HSM_EVENT_RESUME, {}, {}},
+    {1200, HSM_EVENT_PAUSE, {}, {}},
+  };
+  run(2000);
+  report();
+  EXPECT_EQ(transitions.back().state, HSM_STATE_PAUSE);
+}
+
+TEST_F(HsmSimFixture, AbortDiscardsDeferredRun) {
+  // a run deferred during boot is not replayed once an abort has been posted after it
+  script = {
+    {100, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {200, HSM_EVENT_ABORT, {}, {}},
+  };
+  run(1000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+  struct hsm_queue_stats stats;
+  hsm_queue_stats_snapshot(&stats);
+  EXPECT_EQ(stats.deferred[HSM_EVENT_RUN], 1u);
+  EXPECT_EQ(stats.dropped[HSM_EVENT_RUN], 1u);
+}
+
+TEST_F(HsmSimFixture, RunDuringBootIsDeferred) {
+  // a run requested before the HSM is ready starts as soon as it reaches idle, without a DTC
+  EXPECT_CALL(m_dtc, dtc_post_event).Times(0);
+  script = {
+    {100, HSM_EVENT_RUN, {.profile_id = 2, .setpoint = 500.0f}, {}},
+  };
+  run(1000);
+  report();
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+    {500, HSM_STATE_RUN_STARTUP},
+    {500, HSM_STATE_RUN_PROFILE},
+  };
+  EXPECT_EQ(transitions, expected);
+  EXPECT_EQ(test_hsm_get_context()->run_params.profile_id, 2);
+}
+
+TEST_F(HsmSimFixture, PauseResumesProfile) {
+  script = {
+    {1000, HSM_EVENT_RUN, {.profile_id = 1, .setpoint = 100.0f}, {}},
+    {1200, HSM_EVENT_PAUSE, {}, {}},
+    {1400, HSM_EVENT_RESUME, {}, {}},
+    {1600, HSM_EVENT_STOP, {}, {}},
+  };
+  run(2000);
+  report();
+  // resuming skips the startup substate
+  const std::vector<Transition> expected = {
+    {0, HSM_STATE_RESET},
+    {500, HSM_STATE_IDLE},
+    {1000, HSM_STATE_RUN_STARTUP},
+    {1000, HSM_STATE_RUN_PROFILE},
+    {1200, HSM_STATE_PAUSE},
+    {1400, HSM_STATE_RUN_PROFILE},
+    {1600, HSM_STATE_STOP},
+    {1600, HSM_STATE_IDLE},
+  };
+  EXPECT_EQ(transitions, expected);
+}
+
+TEST_F(HsmSimFixture, RunStopThroughput) {
+  // many run/stop cycles at full speed: every cycle completes and no event waits on the loop
+  constexpr uint32_t kCycles = 2000;
+  for (uint32_t i = 0; i < kCycles; i++) {
+    const TickType_t at = 1000 + i * 20;
+    script.push_back({at, HSM_EVENT_RUN, {.profile_id = (uint16_t)i, .setpoint = 1.0f}, {}});
+    script.push_back({at + 10, HSM_EVENT_STOP, {}, {}});
+  }
+  const TickType_t until = 1000 + kCycles * 20;
+  const auto start = std::chrono::steady_clock::now();
+  run(until);
+  const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  uint32_t idle_entries = 0;
+  for (const Transition &t : transitions) {
+    idle_entries += t.state == HSM_STATE_IDLE;
+  }
+  EXPECT_EQ(idle_entries, kCycles + 1);
+  EXPECT_EQ(dropped_posts, 0u);
+  struct hsm_latency_stats stats;
+  hsm_latency_snapshot(&stats);
+  EXPECT_EQ(hist_count(stats.dispatch[HSM_EVENT_RUN]), kCycles);
+  // posted events are dispatched in the same virtual millisecond rather than on a later poll
+  EXPECT_LT(stats.queue_wait[HSM_EVENT_RUN].max_us, 1000u);
+  EXPECT_LT(stats.queue_wait[HSM_EVENT_STOP].max_us, 1000u);
+
+  const double events_per_s = 2.0 * kCycles / (wall_ms / 1000.0);
+  printf("[ SIM      ] %u cycles, %u ms virtual in %.1f ms host (%.0fx), %.0f events/s\n", kCycles, (unsigned)until, wall_ms,
+         until / wall_ms, events_per_s);
+  RecordProperty("events_per_s", std::to_string(events_per_s));
+  RecordProperty("speedup", std::to_string(until / wall_ms));
+}
+
+TEST_F(HsmSimFixture, PacedSpeedup) {
+  // a paced simulation takes at least virtual time divided by the speed-up
+  kernel.speedup = 200;
+  const auto start = std::chrono::steady_clock::now();
+  run(2000);
+  const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_GE(wall_ms, 2000 / kernel.speedup * 0.9);
+  EXPECT_EQ(transitions.back().state, HSM_STATE_IDLE);
+}
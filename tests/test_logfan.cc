@@ -0,0 +1,350 @@
+/**
+ * @file test_logfan.cc
+ * @brief Shared log line ring tests and loopback socket benchmark
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "logfan.h"
+}
+
+namespace {
+
+// TCP_MSS in lwipopts.h
+constexpr size_t kMss = 1500 - 40;
+
+std::string peek(struct logfan *fan, int id, size_t size) {
+  std::string out(size, '\0');
+  out.resize(logfan_peek(fan, id, &out[0], size));
+  return out;
+}
+
+std::string consume(struct logfan *fan, int id, size_t size) {
+  std::string out = peek(fan, id, size);
+  logfan_advance(fan, id, out.size());
+  return out;
+}
+
+void append(struct logfan *fan, const std::string &text, uint32_t now = 0) {
+  logfan_append(fan, text.data(), text.size(), now);
+}
+
+} // namespace
+
+TEST(LogFan, AttachDetach) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  for (int id = 0; id < LOGFAN_MAX_CLIENTS; id++) {
+    EXPECT_EQ(logfan_attach(&fan), id);
+  }
+  EXPECT_EQ(logfan_attach(&fan), -1);
+  logfan_detach(&fan, 1);
+  EXPECT_EQ(logfan_attach(&fan), 1);
+}
+
+TEST(LogFan, IndependentCursors) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int fast = logfan_attach(&fan);
+  int slow = logfan_attach(&fan);
+  append(&fan, "one\n");
+  append(&fan, "two\n");
+  EXPECT_EQ(consume(&fan, fast, 64), "one\ntwo\n");
+  EXPECT_EQ(logfan_pending(&fan, fast), 0u);
+  EXPECT_EQ(logfan_pending(&fan, slow), 8u);
+  append(&fan, "three\n");
+  EXPECT_EQ(consume(&fan, fast, 64), "three\n");
+  EXPECT_EQ(consume(&fan, slow, 64), "one\ntwo\nthree\n");
+  EXPECT_EQ(logfan_skipped(&fan, slow), 0u);
+}
+
+TEST(LogFan, NewClientReplaysHistory) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  append(&fan, "before any client\n");
+  int id = logfan_attach(&fan);
+  EXPECT_EQ(consume(&fan, id, 64), "before any client\n");
+}
+
+TEST(LogFan, PeekWholeLines) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, "aaaa\n");
+  append(&fan, "bbbb\n");
+  append(&fan, "cccccccccccccccc\n");
+  // the third line does not fit behind the first two, it is not split
+  EXPECT_EQ(peek(&fan, id, 16), "aaaa\nbbbb\n");
+  EXPECT_EQ(consume(&fan, id, 16), "aaaa\nbbbb\n");
+  // a single line larger than the destination is split
+  EXPECT_EQ(consume(&fan, id, 8), "cccccccc");
+  EXPECT_EQ(logfan_pending(&fan, id), 9u);
+  EXPECT_EQ(consume(&fan, id, 64), "cccccccc\n");
+}
+
+TEST(LogFan, PartialAdvance) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, "hello\n");
+  append(&fan, "world\n");
+  ASSERT_EQ(peek(&fan, id, 64), "hello\nworld\n");
+  // a short send consumes part of a line
+  logfan_advance(&fan, id, 3);
+  EXPECT_EQ(logfan_pending(&fan, id), 9u);
+  EXPECT_EQ(peek(&fan, id, 64), "lo\nworld\n");
+  logfan_advance(&fan, id, 9);
+  EXPECT_EQ(logfan_pending(&fan, id), 0u);
+  EXPECT_EQ(peek(&fan, id, 64), "");
+}
+
+TEST(LogFan, LaggingClientSkips) {
+  uint8_t buffer[64];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int fast = logfan_attach(&fan);
+  int stalled = logfan_attach(&fan);
+  // 10 byte lines take 16 bytes each, the ring keeps the last 4
+  for (int i = 0; i < 100; i++) {
+    char text[16];
+    snprintf(text, sizeof(text), "line %03d\n", i);
+    append(&fan, std::string(text) + "-");
+    std::string got = consume(&fan, fast, 64);
+    EXPECT_EQ(got, std::string(text) + "-");
+  }
+  EXPECT_EQ(logfan_pending(&fan, stalled), 40u);
+  EXPECT_EQ(logfan_skipped(&fan, stalled), 96u);
+  EXPECT_EQ(logfan_skipped(&fan, stalled), 0u);
+  EXPECT_EQ(consume(&fan, stalled, 64), "line 096\n-line 097\n-line 098\n-line 099\n-");
+  EXPECT_EQ(logfan_skipped(&fan, fast), 0u);
+}
+
+TEST(LogFan, PartiallySentLineOverwritten) {
+  uint8_t buffer[64];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, "0123456789");
+  logfan_advance(&fan, id, 4);
+  for (int i = 0; i < 4; i++) {
+    append(&fan, "abcdefghij");
+  }
+  // the torn line is terminated before the client resumes at the oldest retained line
+  EXPECT_EQ(logfan_pending(&fan, id), 41u);
+  EXPECT_EQ(logfan_skipped(&fan, id), 1u);
+  EXPECT_EQ(consume(&fan, id, 64), "\nabcdefghijabcdefghijabcdefghijabcdefghij");
+  EXPECT_EQ(logfan_pending(&fan, id), 0u);
+}
+
+TEST(LogFan, TornLineEndSentAlone) {
+  uint8_t buffer[64];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, "0123456789");
+  logfan_advance(&fan, id, 4);
+  for (int i = 0; i < 4; i++) {
+    append(&fan, "abcdefghij");
+  }
+  // a destination too small for a whole line still gets the terminator first
+  EXPECT_EQ(consume(&fan, id, 1), "\n");
+  EXPECT_EQ(logfan_skipped(&fan, id), 1u);
+  EXPECT_EQ(consume(&fan, id, 4), "abcd");
+  EXPECT_EQ(consume(&fan, id, 64), "efghijabcdefghijabcdefghijabcdefghij");
+  // a line that was fully consumed is not terminated again
+  append(&fan, "klmnopqrst");
+  EXPECT_EQ(logfan_skipped(&fan, id), 0u);
+  EXPECT_EQ(consume(&fan, id, 64), "klmnopqrst");
+}
+
+TEST(LogFan, Age) {
+  uint8_t buffer[256];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  EXPECT_EQ(logfan_age(&fan, id, 100), 0u);
+  append(&fan, "a\n", 0xFFFFFFFAu);
+  append(&fan, "b\n", 4);
+  EXPECT_EQ(logfan_age(&fan, id, 10), 16u);
+  logfan_advance(&fan, id, 2);
+  EXPECT_EQ(logfan_age(&fan, id, 10), 6u);
+  logfan_advance(&fan, id, 2);
+  EXPECT_EQ(logfan_age(&fan, id, 10), 0u);
+}
+
+TEST(LogFan, TruncatesLongLines) {
+  uint8_t buffer[32];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, std::string(40, 'x'));
+  EXPECT_EQ(logfan_pending(&fan, id), 26u);
+  EXPECT_EQ(consume(&fan, id, 64), std::string(26, 'x'));
+}
+
+TEST(LogFan, EmptyLines) {
+  uint8_t buffer[64];
+  struct logfan fan;
+  logfan_init(&fan, buffer, sizeof(buffer));
+  int id = logfan_attach(&fan);
+  append(&fan, "a");
+  append(&fan, "");
+  append(&fan, "b");
+  EXPECT_EQ(consume(&fan, id, 64), "ab");
+  EXPECT_EQ(logfan_age(&fan, id, 0), 0u);
+}
+
+namespace {
+
+/**
+ * @brief Loopback TCP connection with a receive thread that can be held back to model a stalled
+ * subscriber
+ */
+class Loopback {
+public:
+  explicit Loopback(bool drain = true) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(address);
+    bind(listener, (sockaddr *)&address, sizeof(address));
+    listen(listener, 1);
+    getsockname(listener, (sockaddr *)&address, &size);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    // lwIP sockets in the firmware push every write out as its own segment
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connect(fd, (sockaddr *)&address, sizeof(address));
+    peer = accept(listener, nullptr, nullptr);
+    close(listener);
+    if (drain) {
+      reader = std::thread([this] {
+        char buffer[16384];
+        ssize_t n;
+        while ((n = read(peer, buffer, sizeof(buffer))) > 0) {
+          received += (size_t)n;
+        }
+      });
+    }
+  }
+
+  size_t finish() {
+    shutdown(fd, SHUT_WR);
+    if (reader.joinable()) {
+      reader.join();
+    }
+    close(fd);
+    close(peer);
+    return received;
+  }
+
+  int fd;
+
+private:
+  int peer;
+  std::thread reader;
+  size_t received = 0;
+};
+
+constexpr int kLines = 200000;
+// LOG_DRAIN_BATCH in logger.c: clients are serviced after every batch of records
+constexpr int kDrainBatch = 32;
+
+/**
+ * @brief Host model of the logger task's client service loop: send segment sized chunks without
+ * blocking and leave the rest for the next pass
+ */
+void service(struct logfan *fan, int id, int fd, char *chunk) {
+  while (logfan_pending(fan, id) >= kMss) {
+    size_t len = logfan_peek(fan, id, chunk, kMss);
+    ssize_t sent = send(fd, chunk, len, MSG_DONTWAIT);
+    if (sent < 0) {
+      ASSERT_TRUE(errno == EWOULDBLOCK || errno == EAGAIN);
+      return;
+    }
+    logfan_advance(fan, id, (size_t)sent);
+  }
+}
+
+} // namespace
+
+TEST(LogFanBench, LoopbackThroughput) {
+  const std::string text = "[        42  INFO ]\tposted <3> to HSM event queue\n";
+
+  // one write per line
+  Loopback unbatched;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLines; i++) {
+    ASSERT_EQ(write(unbatched.fd, text.data(), text.size()), (ssize_t)text.size());
+  }
+  ASSERT_EQ(unbatched.finish(), kLines * text.size());
+  std::chrono::duration<double> per_line = std::chrono::steady_clock::now() - start;
+
+  // segment sized chunks from the shared ring to two subscribers, one of which never reads
+  std::vector<uint8_t> buffer(8192);
+  struct logfan fan;
+  logfan_init(&fan, buffer.data(), buffer.size());
+  Loopback fast, stalled(false);
+  int fast_id = logfan_attach(&fan);
+  int stalled_id = logfan_attach(&fan);
+  fcntl(fast.fd, F_SETFL, O_NONBLOCK);
+  fcntl(stalled.fd, F_SETFL, O_NONBLOCK);
+  char chunk[kMss];
+  uint64_t fast_skipped = 0, stalled_skipped = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLines; i++) {
+    append(&fan, text);
+    if (i % kDrainBatch == kDrainBatch - 1) {
+      service(&fan, fast_id, fast.fd, chunk);
+      service(&fan, stalled_id, stalled.fd, chunk);
+    }
+  }
+  // flush the tail of the fast client
+  fcntl(fast.fd, F_SETFL, 0);
+  while (logfan_pending(&fan, fast_id) > 0) {
+    size_t len = logfan_peek(&fan, fast_id, chunk, kMss);
+    ssize_t sent = send(fast.fd, chunk, len, 0);
+    ASSERT_GT(sent, 0);
+    logfan_advance(&fan, fast_id, (size_t)sent);
+  }
+  fast_skipped = logfan_skipped(&fan, fast_id);
+  stalled_skipped = logfan_skipped(&fan, stalled_id);
+  size_t received = fast.finish();
+  std::chrono::duration<double> batched = std::chrono::steady_clock::now() - start;
+  stalled.finish();
+
+  // the stalled subscriber never holds back the fast one
+  EXPECT_EQ(fast_skipped, 0u);
+  EXPECT_EQ(received, kLines * text.size());
+  EXPECT_GT(stalled_skipped, 0u);
+  printf("[ BENCH    ] %d lines of %zu bytes: per line write %.0f lines/s, %zu byte chunks %.0f lines/s (%.1fx), "
+         "stalled client skipped %llu lines\n",
+         kLines, text.size(), kLines / per_line.count(), kMss, kLines / batched.count(), per_line.count() / batched.count(),
+         (unsigned long long)stalled_skipped);
+  RecordProperty("per_line_lines_per_s", std::to_string(kLines / per_line.count()));
+  RecordProperty("batched_lines_per_s", std::to_string(kLines / batched.count()));
+}
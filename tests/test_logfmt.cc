@@ -0,0 +1,135 @@
+/**
+ * @file test_logfmt.cc
+ * @brief Deferred log formatting tests
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include "logfmt.h"
+}
+
+namespace {
+
+std::string format(const char *fmt, std::initializer_list<logfmt_arg_t> args, size_t size = 128) {
+  std::vector<char> buffer(size);
+  size_t len = logfmt_format(buffer.data(), buffer.size(), fmt, args.begin(), (uint8_t)args.size());
+  EXPECT_EQ(len, strlen(buffer.data()));
+  return std::string(buffer.data());
+}
+
+} // namespace
+
+TEST(LogFmt, Literal) {
+  EXPECT_EQ(format("HSM Reset\n", {}), "HSM Reset\n");
+  EXPECT_EQ(format("100%%", {}), "100%");
+}
+
+TEST(LogFmt, Integers) {
+  EXPECT_EQ(format("%d %i", {logfmt_arg_int(-42), logfmt_arg_int(7)}), "-42 7");
+  EXPECT_EQ(format("%u", {logfmt_arg_int(0xDECAFBADu)}), "3737844653");
+  EXPECT_EQ(format("0x%08X", {logfmt_arg_int(0xBEEF)}), "0x0000BEEF");
+  EXPECT_EQ(format("%-4d|", {logfmt_arg_int(5)}), "5   |");
+  // length modifiers are ignored: every argument is a word
+  EXPECT_EQ(format("%lu %hhu %zu", {logfmt_arg_int(1), logfmt_arg_int(2), logfmt_arg_int(3)}), "1 2 3");
+  EXPECT_EQ(format("%c", {logfmt_arg_int('x')}), "x");
+}
+
+TEST(LogFmt, Float) {
+  EXPECT_EQ(format("%.2f", {logfmt_arg_float(1200.125)}), "1200.12");
+  EXPECT_EQ(format("%g", {logfmt_arg_float(-0.5f)}), "-0.5");
+}
+
+TEST(LogFmt, Pointers) {
+  static const char name[] = "hsm";
+  EXPECT_EQ(format("task %s", {logfmt_arg_ptr(name)}), "task hsm");
+  EXPECT_EQ(format("%s", {logfmt_arg_ptr(nullptr)}), "(null)");
+}
+
+TEST(LogFmt, MissingArguments) {
+  EXPECT_EQ(format("%d %d", {logfmt_arg_int(1)}), "1 %d");
+  EXPECT_EQ(format("%k", {logfmt_arg_int(1)}), "%k");
+  EXPECT_EQ(format("trailing %", {}), "trailing %");
+}
+
+TEST(LogFmt, Truncation) {
+  EXPECT_EQ(format("%d-%d", {logfmt_arg_int(12345), logfmt_arg_int(678)}, 8), "12345-6");
+  EXPECT_EQ(format("abcdefgh", {}, 4), "abc");
+  char buffer[1] = {'x'};
+  EXPECT_EQ(logfmt_format(buffer, sizeof(buffer), "abc", nullptr, 0), 0u);
+  EXPECT_EQ(buffer[0], '\0');
+}
+
+namespace {
+
+constexpr size_t kIterations = 200000;
+
+// legacy logger_out record formatted on the caller's stack
+struct legacy_msg {
+  uint32_t epoch;
+  int level;
+  char message[249];
+};
+
+struct deferred_record {
+  uint32_t epoch;
+  const char *fmt;
+  uint8_t level;
+  uint8_t nargs;
+  logfmt_arg_t args[LOGFMT_MAX_ARGS];
+};
+
+volatile uint32_t sink;
+
+void legacy_out(void *queue, const char *fmt, ...) {
+  legacy_msg log = {};
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(log.message, sizeof(log.message) - 1, fmt, args);
+  va_end(args);
+  memcpy(queue, &log, sizeof(log));
+}
+
+void deferred_out(void *queue, const char *fmt, const logfmt_arg_t *args, uint8_t nargs) {
+  deferred_record log = {};
+  log.fmt = fmt;
+  log.nargs = nargs;
+  memcpy(log.args, args, nargs * sizeof(logfmt_arg_t));
+  memcpy(queue, &log, sizeof(log));
+}
+
+} // namespace
+
+TEST(LogFmtBench, CallerCost) {
+  static legacy_msg legacy_slot;
+  static deferred_record deferred_slot;
+  const char *fmt = "failed to post <%i> to HSM event queue waiting: %u ms\n";
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kIterations; i++) {
+    legacy_out(&legacy_slot, fmt, (int)i, (unsigned)i * 10);
+    sink += legacy_slot.message[0];
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kIterations; i++) {
+    const logfmt_arg_t args[] = {logfmt_arg_int((int)i), logfmt_arg_int((unsigned)i * 10), logfmt_arg_ptr("")};
+    deferred_out(&deferred_slot, fmt, args, 2);
+    sink += deferred_slot.nargs;
+  }
+  auto stop = std::chrono::steady_clock::now();
+  double legacy = std::chrono::duration<double, std::nano>(mid - start).count() / kIterations;
+  double deferred = std::chrono::duration<double, std::nano>(stop - mid).count() / kIterations;
+  printf("[ BENCH    ] caller cost: vsnprintf %7.1f ns (%zu B record) deferred %7.1f ns (%zu B record)\n", legacy,
+         sizeof(legacy_msg), deferred, sizeof(deferred_record));
+  RecordProperty("legacy_ns", std::to_string(legacy));
+  RecordProperty("deferred_ns", std::to_string(deferred));
+  EXPECT_LT(deferred, legacy);
+}
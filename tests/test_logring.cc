@@ -0,0 +1,361 @@
+/**
+ * @file test_logring.cc
+ * @brief Multi-producer log ring tests and producer benchmark
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <sys/time.h>
+
+extern "C" {
+#include "logring.h"
+}
+
+namespace {
+
+struct alignas(4) Storage {
+  uint8_t bytes[256];
+};
+
+// variable length test record: producer id, sequence number and a payload derived from both
+struct Record {
+  uint32_t producer;
+  uint32_t seq;
+  uint8_t payload[48];
+};
+
+size_t record_len(uint32_t seq) {
+  return offsetof(Record, payload) + seq % (sizeof(Record::payload) + 1);
+}
+
+void fill(Record &record, uint32_t producer, uint32_t seq) {
+  record.producer = producer;
+  record.seq = seq;
+  for (size_t i = 0; i < sizeof(record.payload); i++) {
+    record.payload[i] = (uint8_t)(producer * 31 + seq + i);
+  }
+}
+
+bool check(const Record &record, size_t len) {
+  if (len != record_len(record.seq)) {
+    return false;
+  }
+  for (size_t i = 0; i < len - offsetof(Record, payload); i++) {
+    if (record.payload[i] != (uint8_t)(record.producer * 31 + record.seq + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(LogRing, WriteRead) {
+  Storage storage;
+  struct logring ring;
+  logring_init(&ring, storage.bytes, sizeof(storage.bytes));
+  char out[16];
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 0u);
+  EXPECT_EQ(logring_write(&ring, "hello", 5), LOGRING_WAKE);
+  EXPECT_EQ(logring_write(&ring, "abc", 3), LOGRING_OK);
+  // records are padded to 4 bytes behind an 8 byte header
+  EXPECT_EQ(logring_used(&ring), 16u + 12u);
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 5u);
+  EXPECT_EQ(std::string(out, 5), "hello");
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 3u);
+  EXPECT_EQ(std::string(out, 3), "abc");
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 0u);
+  EXPECT_EQ(logring_used(&ring), 0u);
+}
+
+TEST(LogRing, EmptyRecord) {
+  Storage storage;
+  struct logring ring;
+  logring_init(&ring, storage.bytes, sizeof(storage.bytes));
+  char out[4];
+  EXPECT_EQ(logring_write(&ring, nullptr, 0), LOGRING_WAKE);
+  EXPECT_EQ(logring_used(&ring), 8u);
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 0u);
+  EXPECT_EQ(logring_used(&ring), 0u);
+}
+
+TEST(LogRing, FullAndSizeErrors) {
+  Storage storage;
+  struct logring ring;
+  logring_init(&ring, storage.bytes, 64);
+  uint8_t data[64] = {0};
+  EXPECT_EQ(logring_write(&ring, data, 57), LOGRING_SIZE_ERR);
+  EXPECT_EQ(logring_write(&ring, data, 24), LOGRING_WAKE);
+  EXPECT_EQ(logring_write(&ring, data, 24), LOGRING_OK);
+  EXPECT_EQ(logring_write(&ring, data, 0), LOGRING_FULL);
+  uint8_t out[64];
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 24u);
+  EXPECT_EQ(logring_write(&ring, data, 0), LOGRING_OK);
+}
+
+TEST(LogRing, WrapAndTruncate) {
+  Storage storage;
+  struct logring ring;
+  logring_init(&ring, storage.bytes, 64);
+  Record record, out;
+  // odd record lengths walk records across the end of the buffer
+  for (uint32_t seq = 0; seq < 1000; seq++) {
+    fill(record, 1, seq);
+    size_t len = record_len(seq) % 40;
+    ASSERT_NE(logring_write(&ring, &record, len), LOGRING_FULL);
+    memset(&out, 0, sizeof(out));
+    ASSERT_EQ(logring_read(&ring, &out, sizeof(out)), len);
+    ASSERT_EQ(memcmp(&out, &record, len), 0) << "seq " << seq;
+  }
+  fill(record, 2, 48);
+  ASSERT_EQ(logring_write(&ring, &record, sizeof(record.producer) + sizeof(record.seq) + 16), LOGRING_WAKE);
+  uint32_t producer = 0;
+  EXPECT_EQ(logring_read(&ring, &producer, sizeof(producer)), 24u);
+  EXPECT_EQ(producer, 2u);
+  EXPECT_EQ(logring_used(&ring), 0u);
+}
+
+TEST(LogRing, SingleProducer) {
+  Storage storage;
+  struct logring ring;
+  logring_init(&ring, storage.bytes, 64);
+  uint8_t data[64] = {0};
+  EXPECT_EQ(logring_write_single(&ring, data, 57), LOGRING_SIZE_ERR);
+  EXPECT_EQ(logring_write_single(&ring, data, 24), LOGRING_WAKE);
+  EXPECT_EQ(logring_write_single(&ring, data, 24), LOGRING_OK);
+  EXPECT_EQ(logring_write_single(&ring, data, 0), LOGRING_FULL);
+  EXPECT_EQ(logring_used(&ring), 64u);
+  uint8_t out[64];
+  EXPECT_EQ(logring_peek(&ring, out, sizeof(out)), 24u);
+  EXPECT_EQ(logring_used(&ring), 64u);
+  EXPECT_EQ(logring_read(&ring, out, sizeof(out)), 24u);
+  EXPECT_EQ(logring_used(&ring), 32u);
+}
+
+namespace {
+
+struct Stamped {
+  uint64_t timestamp;
+  uint32_t stream;
+};
+
+} // namespace
+
+TEST(LogRing, MergeByTimestamp) {
+  Storage task_storage, isr_storage;
+  struct logring task, isr;
+  logring_init(&task, task_storage.bytes, sizeof(task_storage.bytes));
+  logring_init(&isr, isr_storage.bytes, sizeof(isr_storage.bytes));
+  struct logring *const rings[] = {&task, &isr};
+  // timestamps cross 2^32 part way through and must still compare as 64 bit values
+  const uint64_t task_stamps[] = {0xFFFFFFF0u, 0xFFFFFFF8u, 0x100000003u, 0x100000003u, 0x100000009u};
+  const uint64_t isr_stamps[] = {0xFFFFFFF4u, 0x100000000u, 0x100000003u, 0x10000000Cu};
+  for (uint64_t stamp : task_stamps) {
+    Stamped record = {stamp, 0};
+    ASSERT_NE(logring_write(&task, &record, sizeof(record)), LOGRING_FULL);
+  }
+  for (uint64_t stamp : isr_stamps) {
+    Stamped record = {stamp, 1};
+    ASSERT_NE(logring_write_single(&isr, &record, sizeof(record)), LOGRING_FULL);
+  }
+  const Stamped expected[] = {{0xFFFFFFF0u, 0},  {0xFFFFFFF4u, 1},  {0xFFFFFFF8u, 0},
+                              {0x100000000u, 1}, {0x100000003u, 0}, {0x100000003u, 0},
+                              {0x100000003u, 1}, {0x100000009u, 0}, {0x10000000Cu, 1}};
+  for (const Stamped &want : expected) {
+    Stamped got = {0, 0};
+    ASSERT_EQ(logring_read_merged(rings, 2, &got, sizeof(got)), sizeof(got));
+    EXPECT_EQ(got.timestamp, want.timestamp);
+    EXPECT_EQ(got.stream, want.stream);
+  }
+  Stamped got;
+  EXPECT_EQ(logring_read_merged(rings, 2, &got, sizeof(got)), 0u);
+}
+
+namespace {
+
+// interrupt simulation: the "task" is the main thread and the "ISR" is a SIGALRM handler that
+// preempts it at arbitrary points, including in the middle of its own ring writes
+std::atomic<uint64_t> isr_clock{0};
+struct logring *isr_ring;
+volatile sig_atomic_t isr_count;
+volatile sig_atomic_t isr_drops;
+
+void isr_handler(int) {
+  Stamped record = {isr_clock.fetch_add(1, std::memory_order_relaxed), 1};
+  if (logring_write_single(isr_ring, &record, sizeof(record)) == LOGRING_FULL) {
+    isr_drops = isr_drops + 1;
+  } else {
+    isr_count = isr_count + 1;
+  }
+}
+
+} // namespace
+
+TEST(LogRing, InterruptPreemption) {
+  std::vector<uint32_t> task_storage(1u << 20), isr_storage(1u << 16);
+  struct logring task, isr;
+  logring_init(&task, task_storage.data(), task_storage.size() * sizeof(uint32_t));
+  logring_init(&isr, isr_storage.data(), isr_storage.size() * sizeof(uint32_t));
+  isr_ring = &isr;
+  isr_count = 0;
+  isr_drops = 0;
+  struct sigaction action = {};
+  action.sa_handler = isr_handler;
+  ASSERT_EQ(sigaction(SIGALRM, &action, nullptr), 0);
+  struct itimerval timer = {{0, 20}, {0, 20}};
+  ASSERT_EQ(setitimer(ITIMER_REAL, &timer, nullptr), 0);
+
+  uint32_t task_records = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  while (std::chrono::steady_clock::now() < deadline || isr_count < 100) {
+    Stamped record = {isr_clock.fetch_add(1, std::memory_order_relaxed), 0};
+    if (logring_write(&task, &record, sizeof(record)) == LOGRING_FULL) {
+      break;
+    }
+    task_records++;
+  }
+  timer = {};
+  setitimer(ITIMER_REAL, &timer, nullptr);
+  signal(SIGALRM, SIG_DFL);
+
+  // each stream is written in clock order, so the merged stream must be strictly increasing
+  struct logring *const rings[] = {&task, &isr};
+  Stamped record;
+  uint32_t counts[2] = {0, 0};
+  int64_t last = -1;
+  while (logring_read_merged(rings, 2, &record, sizeof(record)) == sizeof(record)) {
+    ASSERT_LT(record.stream, 2u);
+    ASSERT_GT((int64_t)record.timestamp, last);
+    last = record.timestamp;
+    counts[record.stream]++;
+  }
+  EXPECT_EQ(counts[0], task_records);
+  EXPECT_EQ(counts[1], (uint32_t)isr_count);
+  EXPECT_EQ(isr_drops, 0);
+  EXPECT_GE(counts[1], 100u);
+  printf("[ INFO     ] merged %u task and %u interrupt records\n", counts[0], counts[1]);
+}
+
+namespace {
+
+struct RunResult {
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  uint64_t read = 0;
+  double mean_ns = 0;
+  double p99_ns = 0;
+};
+
+/**
+ * @brief Run producers against a single consumer thread and verify per producer ordering and
+ * record integrity. Producers yield after every `burst` records, modelling tasks that log a few
+ * records and then block, so the consumer gets scheduled even on a single core host.
+ */
+RunResult run(size_t ring_size, unsigned producers, uint32_t records_per_producer, uint32_t burst) {
+  std::vector<uint32_t> storage(ring_size / sizeof(uint32_t));
+  struct logring ring;
+  logring_init(&ring, storage.data(), ring_size);
+  std::atomic<unsigned> done{0};
+  std::atomic<uint64_t> dropped{0};
+  std::vector<std::vector<uint32_t>> latencies(producers);
+  RunResult result;
+
+  std::thread consumer([&] {
+    std::vector<int64_t> last(producers, -1);
+    Record record;
+    for (;;) {
+      bool finished = done.load(std::memory_order_acquire) == producers;
+      size_t len = logring_read(&ring, &record, sizeof(record));
+      if (len == 0) {
+        if (finished) {
+          break;
+        }
+        std::this_thread::yield();
+        continue;
+      }
+      ASSERT_LT(record.producer, producers);
+      ASSERT_TRUE(check(record, len)) << "corrupt record from producer " << record.producer;
+      ASSERT_GT((int64_t)record.seq, last[record.producer]) << "records reordered";
+      last[record.producer] = record.seq;
+      result.read++;
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < producers; p++) {
+    threads.emplace_back([&, p] {
+      Record record;
+      latencies[p].reserve(records_per_producer);
+      uint64_t drops = 0;
+      for (uint32_t seq = 0; seq < records_per_producer; seq++) {
+        fill(record, p, seq);
+        auto start = std::chrono::steady_clock::now();
+        logring_status_t status = logring_write(&ring, &record, record_len(seq));
+        auto stop = std::chrono::steady_clock::now();
+        latencies[p].push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        if (status == LOGRING_FULL) {
+          drops++;
+        }
+        if ((seq + 1) % burst == 0) {
+          std::this_thread::yield();
+        }
+      }
+      dropped += drops;
+      done.fetch_add(1, std::memory_order_release);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  consumer.join();
+
+  std::vector<uint32_t> all;
+  for (auto &samples : latencies) {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+  std::sort(all.begin(), all.end());
+  double sum = 0;
+  for (uint32_t sample : all) {
+    sum += sample;
+  }
+  result.written = all.size();
+  result.dropped = dropped.load();
+  result.mean_ns = sum / all.size();
+  result.p99_ns = all[all.size() * 99 / 100];
+  return result;
+}
+
+} // namespace
+
+TEST(LogRing, ConcurrentProducers) {
+  RunResult result = run(1024, 4, 20000, 1);
+  EXPECT_EQ(result.read + result.dropped, result.written) << "records lost without being counted";
+}
+
+class LogRingBench : public ::testing::TestWithParam<unsigned> {};
+
+TEST_P(LogRingBench, ProducerLatency) {
+  const unsigned producers = GetParam();
+  RunResult result = run(2048, producers, 50000, 8);
+  double loss = 100.0 * result.dropped / result.written;
+  printf("[ BENCH    ] %u producers (%u cpus): write mean %7.1f ns p99 %7.1f ns, loss %5.2f%% (%llu/%llu)\n", producers,
+         std::thread::hardware_concurrency(), result.mean_ns, result.p99_ns, loss, (unsigned long long)result.dropped, (unsigned long long)result.written);
+  RecordProperty("mean_ns", std::to_string(result.mean_ns));
+  RecordProperty("p99_ns", std::to_string(result.p99_ns));
+  RecordProperty("loss_pct", std::to_string(loss));
+  EXPECT_EQ(result.read + result.dropped, result.written);
+}
+
+INSTANTIATE_TEST_SUITE_P(Producers, LogRingBench, ::testing::Values(1, 2, 4, 8));
@@ -0,0 +1,237 @@
+/**
+ * @file test_nvlog.cc
+ * @brief Log-structured non-volatile store tests on the host flash emulator
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+
+#include "flash_emulator.h"
+
+extern "C" {
+#include "nvlog.h"
+}
+
+namespace {
+
+/**
+ * @brief Reference key/value store the log is restored into and snapshotted from
+ */
+struct Store {
+  std::map<uint16_t, uint32_t> values;
+
+  static void replay(uint16_t key, uint32_t value, void *arg) {
+    static_cast<Store *>(arg)->values[key] = value;
+  }
+
+  static nvlog_status_t snapshot(struct nvlog *log, void *arg) {
+    for (const auto &entry : static_cast<Store *>(arg)->values) {
+      nvlog_status_t status = nvlog_append(log, entry.first, entry.second);
+      if (status != NVLOG_OK) {
+        return status;
+      }
+    }
+    return NVLOG_OK;
+  }
+};
+
+nvlog_status_t mount(struct nvlog *log, FlashEmulator &emu, Store &store) {
+  return nvlog_mount(log, &emu.flash, Store::replay, Store::snapshot, &store);
+}
+
+nvlog_status_t set(struct nvlog *log, Store &store, uint16_t key, uint32_t value) {
+  nvlog_status_t status = nvlog_append(log, key, value);
+  if (status == NVLOG_OK) {
+    store.values[key] = value;
+  }
+  return status;
+}
+
+std::map<uint16_t, uint32_t> restore(FlashEmulator &emu) {
+  struct nvlog log;
+  Store store;
+  EXPECT_EQ(mount(&log, emu, store), NVLOG_OK);
+  return store.values;
+}
+
+} // namespace
+
+TEST(NvLog, FormatBlank) {
+  FlashEmulator emu(256, 2, 16);
+  struct nvlog log;
+  Store store;
+  EXPECT_EQ(mount(&log, emu, store), NVLOG_OK);
+  EXPECT_TRUE(store.values.empty());
+  EXPECT_EQ(emu.erase_count[0], 1u);
+  EXPECT_TRUE(restore(emu).empty());
+  // a formatted log is not formatted again
+  EXPECT_EQ(emu.erase_count[0], 1u);
+}
+
+TEST(NvLog, InvalidConfig) {
+  struct nvlog log;
+  Store store;
+  FlashEmulator one_sector(256, 1, 16);
+  EXPECT_EQ(mount(&log, one_sector, store), NVLOG_CONFIG_ERR);
+  FlashEmulator wide_program(256, 2, 64);
+  EXPECT_EQ(mount(&log, wide_program, store), NVLOG_CONFIG_ERR);
+  FlashEmulator small_sector(16, 2, 16);
+  EXPECT_EQ(mount(&log, small_sector, store), NVLOG_CONFIG_ERR);
+}
+
+TEST(NvLog, ReplayLatest) {
+  FlashEmulator emu(256, 2, 16);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  EXPECT_EQ(set(&log, store, 1, 10), NVLOG_OK);
+  EXPECT_EQ(set(&log, store, 2, 5), NVLOG_OK);
+  EXPECT_EQ(set(&log, store, 1, 20), NVLOG_OK);
+  EXPECT_EQ(nvlog_append(&log, NVLOG_KEY_RESERVED, 0), NVLOG_KEY_ERR);
+  std::map<uint16_t, uint32_t> expected = {{1, 20}, {2, 5}};
+  EXPECT_EQ(restore(emu), expected);
+}
+
+TEST(NvLog, ProgramSizePadding) {
+  // 32 byte flash words (STM32H7) use one word per record
+  FlashEmulator emu(1024, 2, 32);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  for (uint32_t i = 0; i < 100; i++) {
+    ASSERT_EQ(set(&log, store, i % 3, i), NVLOG_OK);
+  }
+  EXPECT_FALSE(emu.program_violation);
+  EXPECT_EQ(restore(emu), store.values);
+}
+
+TEST(NvLog, Compaction) {
+  FlashEmulator emu(256, 4, 16);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  for (uint32_t i = 0; i < 1000; i++) {
+    ASSERT_EQ(set(&log, store, i % 4, i), NVLOG_OK);
+  }
+  EXPECT_GT(log.compactions, 0u);
+  EXPECT_LE(log.chain, emu.flash.num_sectors - 1);
+  EXPECT_FALSE(emu.program_violation);
+  EXPECT_EQ(restore(emu), store.values);
+  // the log continues where it left off after a remount
+  Store remounted;
+  ASSERT_EQ(mount(&log, emu, remounted), NVLOG_OK);
+  for (uint32_t i = 0; i < 1000; i++) {
+    ASSERT_EQ(set(&log, remounted, i % 5, i * 3), NVLOG_OK);
+  }
+  EXPECT_EQ(restore(emu), remounted.values);
+}
+
+TEST(NvLog, SnapshotTooLarge) {
+  // 8 slots per sector: header + 6 records + commit
+  FlashEmulator emu(128, 2, 16);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  for (uint16_t key = 0; key < 6; key++) {
+    ASSERT_EQ(set(&log, store, key, key), NVLOG_OK);
+  }
+  EXPECT_EQ(set(&log, store, 6, 6), NVLOG_FULL_ERR);
+}
+
+TEST(NvLog, WearLevelling) {
+  FlashEmulator emu(512, 4, 16);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  for (uint32_t i = 0; i < 20000; i++) {
+    ASSERT_EQ(set(&log, store, i % 8, i), NVLOG_OK);
+    // remount periodically to check allocation survives resets
+    if (i % 997 == 0) {
+      std::map<uint16_t, uint32_t> expected = store.values;
+      store.values.clear();
+      ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+      ASSERT_EQ(store.values, expected);
+    }
+  }
+  auto minmax = std::minmax_element(emu.erase_count.begin(), emu.erase_count.end());
+  printf("[ WEAR     ] erase counts min %u max %u\n", *minmax.first, *minmax.second);
+  EXPECT_GT(*minmax.first, 0u);
+  EXPECT_LE(*minmax.second - *minmax.first, 1u);
+  EXPECT_FALSE(emu.program_violation);
+}
+
+TEST(NvLog, PowerLoss) {
+  // power is lost after every possible byte of a sequence of appends spanning several compactions
+  constexpr uint32_t kSetup = 10;
+  constexpr uint32_t kAppends = 120;
+  auto key_of = [](uint32_t i) { return (uint16_t)(i % 5); };
+  size_t budget = 0;
+  size_t interrupted = 0;
+  for (;; budget++) {
+    FlashEmulator emu(256, 3, 16);
+    struct nvlog log;
+    Store store;
+    ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+    for (uint32_t i = 0; i < kSetup; i++) {
+      ASSERT_EQ(set(&log, store, key_of(i), i), NVLOG_OK);
+    }
+    emu.power_loss_after(budget);
+    uint32_t i = kSetup;
+    for (; i < kSetup + kAppends; i++) {
+      if (set(&log, store, key_of(i), i) != NVLOG_OK) {
+        break;
+      }
+    }
+    if (i == kSetup + kAppends) {
+      break;
+    }
+    interrupted++;
+    emu.power_on();
+    std::map<uint16_t, uint32_t> restored = restore(emu);
+    // every completed append survives and the interrupted one is either absent or complete
+    std::map<uint16_t, uint32_t> completed = store.values;
+    store.values[key_of(i)] = i;
+    ASSERT_TRUE(restored == completed || restored == store.values) << "power loss after " << budget << " bytes";
+    // the log remains usable
+    Store remounted;
+    ASSERT_EQ(mount(&log, emu, remounted), NVLOG_OK);
+    for (uint32_t j = 0; j < 40; j++) {
+      ASSERT_EQ(set(&log, remounted, key_of(j), j * 7), NVLOG_OK);
+    }
+    ASSERT_EQ(restore(emu), remounted.values) << "power loss after " << budget << " bytes";
+  }
+  EXPECT_GT(interrupted, 0u);
+}
+
+TEST(NvLogBench, Restore) {
+  // STM32H723 geometry: 2 x 128KB sectors programmed in 32 byte flash words
+  FlashEmulator emu(128 * 1024, 2, 32);
+  struct nvlog log;
+  Store store;
+  ASSERT_EQ(mount(&log, emu, store), NVLOG_OK);
+  // fill the active sector close to the compaction point (worst case replay)
+  const size_t records = emu.flash.sector_size / 32 - 3;
+  for (uint32_t i = 0; i < records; i++) {
+    ASSERT_EQ(set(&log, store, i % 8, i), NVLOG_OK);
+  }
+  ASSERT_EQ(log.compactions, 0u);
+  constexpr int kMounts = 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kMounts; i++) {
+    Store restored;
+    ASSERT_EQ(mount(&log, emu, restored), NVLOG_OK);
+    ASSERT_EQ(restored.values, store.values);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  double us = std::chrono::duration<double, std::micro>(stop - start).count() / kMounts;
+  printf("[ BENCH    ] restore %zu records: %8.1f us (%6.1f ns/record)\n", records, us, us * 1000.0 / records);
+  RecordProperty("restore_us", std::to_string(us));
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_nvstore.cc
+ * @brief Persistent system register store tests on the host flash emulator
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "flash_emulator.h"
+#include "mock_logger.h"
+#include "mock_uassert.h"
+#include "mock_freertos.h"
+
+extern "C" {
+#include "flash.h"
+#include "nvstore.h"
+}
+
+namespace {
+
+// emulated log region; programming runs `on_program` once so a test can race the commit
+std::unique_ptr<FlashEmulator> emu;
+struct nvlog_flash hooked_flash;
+std::function<void()> on_program;
+
+nvlog_status_t hooked_program(void *ctx, size_t addr, const void *data, size_t len) {
+  if (on_program) {
+    std::function<void()> hook = on_program;
+    on_program = nullptr;
+    hook();
+  }
+  return emu->flash.program(ctx, addr, data, len);
+}
+
+std::map<uint16_t, uint32_t> restore() {
+  std::map<uint16_t, uint32_t> values;
+  struct nvlog log;
+  auto replay = [](uint16_t key, uint32_t value, void *arg) { (*static_cast<std::map<uint16_t, uint32_t> *>(arg))[key] = value; };
+  // a log with room for every register is never compacted while mounting
+  auto snapshot = [](struct nvlog *, void *) { return NVLOG_FULL_ERR; };
+  EXPECT_EQ(nvlog_mount(&log, &emu->flash, replay, snapshot, &values), NVLOG_OK);
+  return values;
+}
+
+} // namespace
+
+extern "C" const struct nvlog_flash *flash_nvlog(void) {
+  return &hooked_flash;
+}
+
+class NvStoreTestFixture : public ::testing::Test {
+protected:
+  ::testing::NiceMock<MockLogger> m_logger;
+  MockUassert m_uassert;
+  ::testing::NiceMock<MockFreeRTOS> m_freertos;
+  const struct nvstore_init_context init_ctx = {.commit_delay_ms = NVSTORE_DEFAULT_COMMIT_DELAY_MS};
+  const struct system_task_context task_ctx = {.name = "nvstore", .priority = 1, .stack_size = 256, .init_ctx = &init_ctx};
+
+  void SetUp() override {
+    mock_logger = &m_logger;
+    mock_uassert = &m_uassert;
+    mock_freertos = &m_freertos;
+    emu.reset(new FlashEmulator(1024, 2, 32));
+    hooked_flash = emu->flash;
+    hooked_flash.program = hooked_program;
+    on_program = nullptr;
+    EXPECT_CALL(m_uassert, assert_handler).Times(0);
+    ON_CALL(m_freertos, xTaskCreate).WillByDefault(::testing::Return(pdPASS));
+    nvstore_start(&task_ctx);
+  }
+
+  void TearDown() override {
+    sysreg_unsubscribe(test_nvstore_get_context()->subscriber_id);
+    mock_logger = nullptr;
+    mock_uassert = nullptr;
+    mock_freertos = nullptr;
+  }
+};
+
+TEST_F(NvStoreTestFixture, CommitChangedRegisters) {
+  const uint8_t u8 = 42;
+  const uint16_t u16 = 1234;
+  EXPECT_CALL(m_freertos, xTaskGenericNotify(::testing::_, 0, 0, eIncrement, NULL)).Times(2);
+  ASSERT_EQ(sysreg_set_u8(SYSREG_GPU8_UL, &u8), SYSREG_OK);
+  ASSERT_EQ(sysreg_set_u16(SYSREG_GPU16_UL, &u16), SYSREG_OK);
+  test_nvstore_commit();
+  std::map<uint16_t, uint32_t> values = restore();
+  EXPECT_EQ(values[SYSREG_GPU8_UL], 42u);
+  EXPECT_EQ(values[SYSREG_GPU16_UL], 1234u);
+}
+
+TEST_F(NvStoreTestFixture, WriteRacingCommitIsKept) {
+  const uint8_t u8 = 42;
+  const uint16_t u16 = 1234;
+  ASSERT_EQ(sysreg_set_u8(SYSREG_GPU8_UL, &u8), SYSREG_OK);
+  // the second register changes while the first is being appended
+  on_program = [&]() { ASSERT_EQ(sysreg_set_u16(SYSREG_GPU16_UL, &u16), SYSREG_OK); };
+  EXPECT_CALL(m_freertos, xTaskGenericNotify(::testing::_, 0, 0, eIncrement, NULL)).Times(1);
+  test_nvstore_commit();
+  EXPECT_EQ(on_program, nullptr);
+  // the racing write is still dirty and goes out on the commit its notification wakes
+  test_nvstore_commit();
+  std::map<uint16_t, uint32_t> values = restore();
+  EXPECT_EQ(values[SYSREG_GPU8_UL], 42u);
+  EXPECT_EQ(values[SYSREG_GPU16_UL], 1234u);
+}
@@ -58,3 +58,134 @@ TEST(SysRegTest, SysRegF32) {
   EXPECT_EQ(sysreg_get_f32(SYSREG_GPF32, &buffer), SYSREG_OK) << "getter returned non-zero status code";
   EXPECT_EQ(buffer, -1.0) << "Register R/W failed";
 }
+
+TEST(SysRegTest, SysRegTransact) {
+  const uint16_t gpu16 = 1234;
+  const float setpoint = 42.5f;
+  EXPECT_EQ(sysreg_set_u16(SYSREG_GPU16_UL, &gpu16), SYSREG_OK);
+  sysreg_op_t ops[] = {
+    {.offset = SYSREG_SETPOINT, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_F32, .value = {.f32 = setpoint}},
+    {.offset = SYSREG_SETPOINT, .op = SYSREG_OP_READ, .dtype = SYSREG_DTYPE_F32},
+    {.offset = SYSREG_GPU16_UL, .op = SYSREG_OP_READ, .dtype = SYSREG_DTYPE_U16},
+    {.offset = SYSREG_UUID, .op = SYSREG_OP_READ, .dtype = SYSREG_DTYPE_U32},
+  };
+  EXPECT_EQ(sysreg_transact(ops, 4), SYSREG_OK) << "transaction returned non-zero status code";
+  for (const sysreg_op_t &op : ops) {
+    EXPECT_EQ(op.status, SYSREG_OK) << "operation at offset " << op.offset << " failed";
+  }
+  EXPECT_EQ(ops[1].value.f32, setpoint) << "read did not observe earlier write in batch";
+  EXPECT_EQ(ops[2].value.u16, gpu16) << "u16 read failed";
+  EXPECT_EQ(ops[3].value.u32, SYSREG_UUID_RESET) << "u32 read failed";
+}
+
+TEST(SysRegTest, SysRegIndexMatchesMap) {
+  // every byte offset resolves to the register a linear scan of the map finds, or to none
+  struct map_entry {
+    size_t offset;
+    sysreg_dtype_t dtype;
+    uint8_t access;
+  };
+#define MAP_ENTRY(name, member, dtype, field, access, reset, min, max) {SYSREG_##name, dtype, (uint8_t)(access)},
+  const map_entry map[] = {SYSREG_MAP(MAP_ENTRY)};
+#undef MAP_ENTRY
+  for (size_t offset = 0; offset < sizeof(sysreg_t) + sizeof(uint32_t); offset++) {
+    const map_entry *entry = nullptr;
+    for (const map_entry &candidate : map) {
+      if (candidate.offset == offset) {
+        entry = &candidate;
+        break;
+      }
+    }
+    sysreg_op_t op = {.offset = offset, .op = SYSREG_OP_READ, .dtype = entry != nullptr ? entry->dtype : SYSREG_DTYPE_U8};
+    sysreg_transact(&op, 1);
+    if (entry == nullptr) {
+      EXPECT_EQ(op.status, SYSREG_NOT_FOUND_ERR) << "unmapped offset " << offset << " resolved to a register";
+      continue;
+    }
+    EXPECT_EQ(op.status, SYSREG_OK) << "offset " << offset << " resolved to a register of another type";
+    // the lock bit tells apart registers of the same type; rewriting the current access is a no-op
+    const sysreg_status_t expected = (entry->access & SYSREG_ACCESS_L) ? SYSREG_ACCESS_ERR : SYSREG_OK;
+    EXPECT_EQ(sysreg_set_access(offset, entry->access & ~SYSREG_ACCESS_L), expected) << "offset " << offset << " resolved to another register";
+  }
+}
+
+TEST(SysRegTest, SysRegTransactAbort) {
+  const float initial = 1.0f;
+  float buffer;
+  EXPECT_EQ(sysreg_set_f32(SYSREG_SETPOINT, &initial), SYSREG_OK);
+  sysreg_op_t ops[] = {
+    {.offset = SYSREG_SETPOINT, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_F32, .value = {.f32 = 99.0f}},
+    {.offset = SYSREG_UUID, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_U32, .value = {.u32 = 1}},
+    {.offset = SYSREG_GPU8_UL, .op = SYSREG_OP_READ, .dtype = SYSREG_DTYPE_U16},
+    {.offset = 999999, .op = SYSREG_OP_READ, .dtype = SYSREG_DTYPE_U8},
+  };
+  EXPECT_EQ(sysreg_transact(ops, 4), SYSREG_ACCESS_ERR) << "transaction did not report first failure";
+  EXPECT_EQ(ops[0].status, SYSREG_ABORT_ERR) << "valid operation not marked aborted";
+  EXPECT_EQ(ops[1].status, SYSREG_ACCESS_ERR) << "read only write did not return SYSREG_ACCESS_ERR";
+  EXPECT_EQ(ops[2].status, SYSREG_DTYPE_ERR) << "type mismatch did not return SYSREG_DTYPE_ERR";
+  EXPECT_EQ(ops[3].status, SYSREG_NOT_FOUND_ERR) << "invalid offset did not return SYSREG_NOT_FOUND_ERR";
+  EXPECT_EQ(sysreg_get_f32(SYSREG_SETPOINT, &buffer), SYSREG_OK);
+  EXPECT_EQ(buffer, initial) << "aborted transaction modified register";
+}
+
+static int notify_count = 0;
+
+static void notify_counter(void *arg) {
+  *(int *)arg += 1;
+}
+
+TEST(SysRegTest, SysRegSubscribe) {
+  const size_t offsets[] = {SYSREG_SETPOINT, SYSREG_GPU32_UL};
+  const float setpoint = 10.0f;
+  const uint32_t gpu32 = 7;
+  const uint16_t gpu16 = 3;
+  uint8_t id;
+  bool dirty;
+  notify_count = 0;
+  EXPECT_EQ(sysreg_set_f32(SYSREG_SETPOINT, &setpoint), SYSREG_OK);
+  EXPECT_EQ(sysreg_subscribe(offsets, 2, notify_counter, &notify_count, &id), SYSREG_OK) << "subscribe returned non-zero status code";
+
+  // unchanged value does not notify
+  EXPECT_EQ(sysreg_set_f32(SYSREG_SETPOINT, &setpoint), SYSREG_OK);
+  EXPECT_EQ(notify_count, 0) << "unchanged write notified subscriber";
+  // unsubscribed register does not notify
+  EXPECT_EQ(sysreg_set_u16(SYSREG_GPU16_UL, &gpu16), SYSREG_OK);
+  EXPECT_EQ(notify_count, 0) << "unsubscribed register notified subscriber";
+
+  EXPECT_EQ(sysreg_set_u32(SYSREG_GPU32_UL, &gpu32), SYSREG_OK);
+  EXPECT_EQ(notify_count, 1) << "changed write did not notify subscriber";
+  EXPECT_EQ(sysreg_test_and_clear_dirty(id, SYSREG_GPU32_UL, &dirty), SYSREG_OK);
+  EXPECT_TRUE(dirty) << "changed register not marked dirty";
+  EXPECT_EQ(sysreg_test_and_clear_dirty(id, SYSREG_GPU32_UL, &dirty), SYSREG_OK);
+  EXPECT_FALSE(dirty) << "dirty bit not cleared";
+  EXPECT_EQ(sysreg_test_and_clear_dirty(id, SYSREG_SETPOINT, &dirty), SYSREG_OK);
+  EXPECT_FALSE(dirty) << "unchanged register marked dirty";
+
+  // a transaction notifies once for the whole batch
+  sysreg_op_t ops[] = {
+    {.offset = SYSREG_SETPOINT, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_F32, .value = {.f32 = 11.0f}},
+    {.offset = SYSREG_GPU32_UL, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_U32, .value = {.u32 = 8}},
+  };
+  EXPECT_EQ(sysreg_transact(ops, 2), SYSREG_OK);
+  EXPECT_EQ(notify_count, 2) << "transaction did not notify subscriber once";
+
+  EXPECT_EQ(sysreg_unsubscribe(id), SYSREG_OK);
+  EXPECT_EQ(sysreg_unsubscribe(id), SYSREG_NOT_FOUND_ERR) << "double unsubscribe did not return SYSREG_NOT_FOUND_ERR";
+  EXPECT_EQ(sysreg_set_u32(SYSREG_GPU32_UL, &gpu32), SYSREG_OK);
+  EXPECT_EQ(notify_count, 2) << "unsubscribed callback notified";
+}
+
+TEST(SysRegTest, SysRegSubscribeFull) {
+  const size_t offsets[] = {SYSREG_SETPOINT};
+  const size_t bad_offsets[] = {999999};
+  uint8_t ids[SYSREG_MAX_SUBSCRIBERS];
+  uint8_t id;
+  EXPECT_EQ(sysreg_subscribe(bad_offsets, 1, notify_counter, &notify_count, &id), SYSREG_NOT_FOUND_ERR) << "invalid offset did not return SYSREG_NOT_FOUND_ERR";
+  for (uint8_t i = 0; i < SYSREG_MAX_SUBSCRIBERS; i++) {
+    EXPECT_EQ(sysreg_subscribe(offsets, 1, notify_counter, &notify_count, &ids[i]), SYSREG_OK);
+  }
+  EXPECT_EQ(sysreg_subscribe(offsets, 1, notify_counter, &notify_count, &id), SYSREG_MEMORY_ERR) << "full subscriber table did not return SYSREG_MEMORY_ERR";
+  for (uint8_t i = 0; i < SYSREG_MAX_SUBSCRIBERS; i++) {
+    EXPECT_EQ(sysreg_unsubscribe(ids[i]), SYSREG_OK);
+  }
+}
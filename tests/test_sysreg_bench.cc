@@ -0,0 +1,105 @@
+/**
+ * @file test_sysreg_bench.cc
+ * @brief Sysreg register lookup benchmarks
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include "sysreg.h"
+}
+
+namespace {
+
+constexpr size_t kIterations = 200000;
+
+struct bench_reg_conf {
+  size_t offset;
+  uint32_t value;
+};
+
+/**
+ * @brief Synthetic register map of 4 byte registers comparing the legacy linear scan against a
+ * re-implementation of the dense offset index of sysreg.c, so both can be sized beyond the real map
+ */
+class SyntheticMap {
+public:
+  explicit SyntheticMap(size_t num_registers) : config(num_registers), index(num_registers * sizeof(uint32_t), 0) {
+    for (size_t i = 0; i < num_registers; i++) {
+      config[i].offset = i * sizeof(uint32_t);
+      config[i].value = (uint32_t)i;
+      index[config[i].offset] = (uint16_t)(i + 1);
+    }
+  }
+
+  const bench_reg_conf *linear(size_t offset) const {
+    for (size_t i = 0; i < config.size(); i++) {
+      if (config[i].offset == offset) {
+        return &config[i];
+      }
+    }
+    return nullptr;
+  }
+
+  const bench_reg_conf *indexed(size_t offset) const {
+    if (offset >= index.size() || index[offset] == 0) {
+      return nullptr;
+    }
+    return &config[index[offset] - 1];
+  }
+
+  size_t size() const { return config.size(); }
+
+private:
+  std::vector<bench_reg_conf> config;
+  std::vector<uint16_t> index;
+};
+
+template <typename Fn>
+double ns_per_op(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kIterations; i++) {
+    fn(i);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() / kIterations;
+}
+
+} // namespace
+
+class SysRegLookupBench : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(SysRegLookupBench, IndexedVsLinear) {
+  SyntheticMap map(GetParam());
+  volatile uint32_t sink = 0;
+  // sweep every register so the linear scan pays its average cost
+  double linear = ns_per_op([&](size_t i) { sink += map.linear((i % map.size()) * sizeof(uint32_t))->value; });
+  double indexed = ns_per_op([&](size_t i) { sink += map.indexed((i % map.size()) * sizeof(uint32_t))->value; });
+  printf("[ BENCH    ] %4zu registers: linear %8.2f ns/op indexed %8.2f ns/op\n", map.size(), linear, indexed);
+  RecordProperty("linear_ns", std::to_string(linear));
+  RecordProperty("indexed_ns", std::to_string(indexed));
+}
+
+INSTANTIATE_TEST_SUITE_P(RegisterCount, SysRegLookupBench, ::testing::Values(14, 128, 1024));
+
+TEST(SysRegLookupBench, SysRegGetU32) {
+  EXPECT_EQ(sysreg_init(), SYSREG_OK);
+  const size_t offsets[] = {SYSREG_GPU32, SYSREG_GPU32_UL, SYSREG_UUID, SYSREG_HW_VERSION, SYSREG_FW_VERSION};
+  const size_t num_offsets = sizeof(offsets) / sizeof(offsets[0]);
+  volatile uint32_t sink = 0;
+  double get = ns_per_op([&](size_t i) {
+    uint32_t value;
+    sysreg_get_u32(offsets[i % num_offsets], &value);
+    sink += value;
+  });
+  printf("[ BENCH    ] %4d registers: sysreg_get_u32 %8.2f ns/op\n", SYSREG_COUNT, get);
+  RecordProperty("sysreg_get_u32_ns", std::to_string(get));
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_sysreg_stress.cc
+ * @brief Sysreg concurrent snapshot stress tests
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "sysreg.h"
+}
+
+namespace {
+
+constexpr int kNumReaders = 4;
+constexpr uint32_t kNumWrites = 200000;
+
+/**
+ * @brief Writer applies a setpoint group as one transaction where every register holds the same
+ * sequence number. Any snapshot with mismatched values is torn.
+ */
+void writer(std::atomic<bool> *done) {
+  for (uint32_t i = 1; i <= kNumWrites; i++) {
+    sysreg_op_t ops[] = {
+      {.offset = SYSREG_SETPOINT, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_F32, .value = {.f32 = (float)i}},
+      {.offset = SYSREG_GPU32_UL, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_U32, .value = {.u32 = i}},
+      {.offset = SYSREG_GPU16_UL, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_U16, .value = {.u16 = (uint16_t)i}},
+      {.offset = SYSREG_GPU8_UL, .op = SYSREG_OP_WRITE, .dtype = SYSREG_DTYPE_U8, .value = {.u8 = (uint8_t)i}},
+    };
+    ASSERT_EQ(sysreg_transact(ops, 4), SYSREG_OK);
+  }
+  done->store(true);
+}
+
+void reader(std::atomic<bool> *done, std::atomic<uint64_t> *snapshots, std::atomic<uint64_t> *torn) {
+  uint32_t last = 0;
+  while (!done->load()) {
+    sysreg_t snapshot;
+    ASSERT_EQ(sysreg_snapshot(&snapshot), SYSREG_OK);
+    const uint32_t seq = snapshot.gpu32_ul;
+    if (snapshot.setpoint != (float)seq || snapshot.gpu16_ul != (uint16_t)seq || snapshot.gpu8_ul != (uint8_t)seq || seq < last) {
+      torn->fetch_add(1);
+    }
+    last = seq;
+    snapshots->fetch_add(1);
+  }
+}
+
+} // namespace
+
+TEST(SysRegStressTest, SnapshotNeverTorn) {
+  ASSERT_EQ(sysreg_init(), SYSREG_OK);
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> snapshots(0);
+  std::atomic<uint64_t> torn(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < kNumReaders; i++) {
+    readers.emplace_back(reader, &done, &snapshots, &torn);
+  }
+  std::thread write_thread(writer, &done);
+  write_thread.join();
+  for (std::thread &t : readers) {
+    t.join();
+  }
+  EXPECT_GT(snapshots.load(), 0u) << "readers did not take any snapshots";
+  EXPECT_EQ(torn.load(), 0u) << "observed torn snapshots";
+}
+
+TEST(SysRegStressTest, SnapshotNull) {
+  EXPECT_EQ(sysreg_snapshot(NULL), SYSREG_MEMORY_ERR);
+}
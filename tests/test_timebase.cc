@@ -0,0 +1,62 @@
+/**
+ * @file test_timebase.cc
+ * @brief 64 bit timebase tests
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "timebase.h"
+}
+
+TEST(Timebase, ExtendCountsWraps) {
+  struct timebase_extension ext = {0, 0};
+  EXPECT_EQ(timebase_extend(&ext, 10), 10u);
+  EXPECT_EQ(timebase_extend(&ext, 0xFFFFFFF0u), 0xFFFFFFF0u);
+  // counter wrapped between samples
+  EXPECT_EQ(timebase_extend(&ext, 5), 0x100000005u);
+  EXPECT_EQ(timebase_extend(&ext, 5), 0x100000005u);
+  EXPECT_EQ(timebase_extend(&ext, 0x80000000u), 0x180000000u);
+  EXPECT_EQ(timebase_extend(&ext, 0), 0x200000000u);
+}
+
+TEST(Timebase, ExtendIsMonotonicAcrossWraps) {
+  struct timebase_extension ext = {0, 0};
+  uint64_t last = 0;
+  uint32_t counter = 0;
+  // sample a counter advancing by just under a quarter period per step for several wraps
+  for (int i = 0; i < 64; i++) {
+    counter += 0x3FFFFFFFu;
+    const uint64_t now = timebase_extend(&ext, counter);
+    ASSERT_GT(now, last);
+    last = now;
+  }
+  EXPECT_EQ(last, 64ull * 0x3FFFFFFFu);
+}
+
+TEST(Timebase, HostClock) {
+  timebase_init();
+  EXPECT_EQ(timebase_frequency(), 1000000000u);
+  uint64_t last = timebase_now();
+  for (int i = 0; i < 1000; i++) {
+    const uint64_t now = timebase_now();
+    ASSERT_GE(now, last);
+    last = now;
+  }
+  // origin is reset by init
+  EXPECT_LT(last, 1000000000ull);
+}
+
+TEST(Timebase, ToMicroseconds) {
+  // host ticks are nanoseconds
+  EXPECT_EQ(timebase_to_us(0), 0u);
+  EXPECT_EQ(timebase_to_us(999), 0u);
+  EXPECT_EQ(timebase_to_us(1000), 1u);
+  EXPECT_EQ(timebase_to_us(1500000000ull), 1500000u);
+  // no intermediate overflow for large tick counts
+  EXPECT_EQ(timebase_to_us(0xFFFFFFFFFFFFFFFFull), 0xFFFFFFFFFFFFFFFFull / 1000u);
+}
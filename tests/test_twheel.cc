@@ -0,0 +1,181 @@
+/**
+ * @file test_twheel.cc
+ * @brief Hierarchical timer wheel tests
+ * @date 2026-10
+ *
+ * @copyright Copyright © 2026 dronectl
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "twheel.h"
+}
+
+namespace {
+
+struct Timer {
+  struct twheel_timer node;  // first member: the callback casts back to the owner
+  uint32_t fired_at = 0;
+  uint32_t fired = 0;
+  uint32_t period = 0;       // re-armed from the callback when non zero
+  Timer *cancel = nullptr;   // cancelled from the callback when set
+};
+
+struct Context {
+  struct twheel *wheel;
+  std::vector<Timer *> order;
+};
+
+void on_expire(struct twheel_timer *node, void *arg) {
+  Context *context = static_cast<Context *>(arg);
+  Timer *timer = reinterpret_cast<Timer *>(node);
+  timer->fired_at = context->wheel->now;
+  timer->fired++;
+  context->order.push_back(timer);
+  if (timer->period != 0) {
+    twheel_add(context->wheel, &timer->node, node->expires + timer->period);
+  }
+  if (timer->cancel != nullptr) {
+    twheel_cancel(context->wheel, &timer->cancel->node);
+  }
+}
+
+class TwheelTest : public ::testing::TestWithParam<uint32_t> {
+protected:
+  struct twheel wheel;
+  Context context{&wheel, {}};
+
+  void SetUp() override {
+    twheel_init(&wheel, GetParam());
+  }
+
+  void arm(Timer &timer, uint32_t delay) {
+    twheel_timer_init(&timer.node);
+    twheel_add(&wheel, &timer.node, wheel.now + delay);
+  }
+
+  void advance(uint32_t ticks) {
+    twheel_advance(&wheel, wheel.now + ticks, on_expire, &context);
+  }
+};
+
+TEST_P(TwheelTest, ExpiresOnItsTick) {
+  const uint32_t start = wheel.now;
+  for (uint32_t delay : {1u, 63u, 64u, 65u, 4095u, 4096u, 100000u}) {
+    Timer timer;
+    arm(timer, delay);
+    EXPECT_TRUE(twheel_timer_pending(&timer.node));
+    advance(delay - 1);
+    EXPECT_EQ(timer.fired, 0u) << "delay " << delay;
+    advance(1);
+    EXPECT_EQ(timer.fired, 1u) << "delay " << delay;
+    EXPECT_EQ(timer.fired_at, start + delay) << "delay " << delay;
+    EXPECT_FALSE(twheel_timer_pending(&timer.node));
+    advance(TWHEEL_SLOTS * 2);
+    EXPECT_EQ(timer.fired, 1u);
+    twheel_init(&wheel, start);
+  }
+}
+
+TEST_P(TwheelTest, PastAndFarExpiry) {
+  Timer past, far;
+  twheel_timer_init(&past.node);
+  twheel_timer_init(&far.node);
+  twheel_add(&wheel, &past.node, wheel.now - 10);
+  twheel_add(&wheel, &far.node, wheel.now + TWHEEL_MAX_DELAY + 1000);
+  advance(1);
+  EXPECT_EQ(past.fired, 1u);
+  advance(TWHEEL_MAX_DELAY - 2);
+  EXPECT_EQ(far.fired, 0u);
+  advance(1);
+  EXPECT_EQ(far.fired, 1u);
+}
+
+TEST_P(TwheelTest, CancelAndReschedule) {
+  Timer a, b;
+  arm(a, 100);
+  arm(b, 5000);
+  twheel_cancel(&wheel, &a.node);
+  EXPECT_FALSE(twheel_timer_pending(&a.node));
+  twheel_cancel(&wheel, &a.node);
+  // rescheduling a pending timer moves it
+  twheel_add(&wheel, &b.node, wheel.now + 10);
+  advance(10000);
+  EXPECT_EQ(a.fired, 0u);
+  EXPECT_EQ(b.fired, 1u);
+  EXPECT_EQ(wheel.count[0] + wheel.count[1] + wheel.count[2], 0u);
+}
+
+TEST_P(TwheelTest, CallbackRearmAndCancel) {
+  Timer periodic, victim, same;
+  periodic.period = 10;
+  arm(periodic, 10);
+  arm(same, 10);
+  arm(victim, 10);
+  // the first of the three to fire cancels a sibling due on the same tick
+  same.cancel = &victim;
+  victim.cancel = &same;
+  advance(10);
+  EXPECT_EQ(same.fired + victim.fired, 1u);
+  EXPECT_EQ(periodic.fired, 1u);
+  advance(990);
+  EXPECT_EQ(periodic.fired, 100u);
+  EXPECT_EQ(periodic.fired_at, wheel.now);
+}
+
+TEST_P(TwheelTest, NextExpiry) {
+  uint32_t expires;
+  EXPECT_FALSE(twheel_next_expiry(&wheel, &expires));
+  Timer near, mid, far;
+  arm(far, 70000);
+  ASSERT_TRUE(twheel_next_expiry(&wheel, &expires));
+  EXPECT_EQ(expires, wheel.now + 70000);
+  arm(mid, 3000);
+  ASSERT_TRUE(twheel_next_expiry(&wheel, &expires));
+  EXPECT_EQ(expires, wheel.now + 3000);
+  arm(near, 20);
+  ASSERT_TRUE(twheel_next_expiry(&wheel, &expires));
+  EXPECT_EQ(expires, wheel.now + 20);
+  advance(20);
+  ASSERT_TRUE(twheel_next_expiry(&wheel, &expires));
+  EXPECT_EQ(expires, wheel.now + 2980);
+}
+
+TEST_P(TwheelTest, MatchesReferenceOrder) {
+  // random timers advanced in random steps fire on their exact tick, in expiry order
+  std::mt19937 rng(GetParam());
+  std::vector<Timer> timers(500);
+  std::vector<uint32_t> due(timers.size());
+  const uint32_t start = wheel.now;
+  for (size_t i = 0; i < timers.size(); i++) {
+    const uint32_t delay = 1 + rng() % (i % 2 ? 200000u : 500u);
+    arm(timers[i], delay);
+    due[i] = start + delay;
+  }
+  while (context.order.size() < timers.size()) {
+    uint32_t next;
+    ASSERT_TRUE(twheel_next_expiry(&wheel, &next));
+    const uint32_t step = 1 + rng() % 300;
+    const uint32_t target = (int32_t)(next - (wheel.now + step)) < 0 ? next : wheel.now + step;
+    twheel_advance(&wheel, target, on_expire, &context);
+  }
+  uint32_t last = start;
+  for (Timer *timer : context.order) {
+    const size_t i = timer - timers.data();
+    EXPECT_EQ(timer->fired, 1u);
+    EXPECT_EQ(timer->fired_at, due[i]);
+    EXPECT_GE((int32_t)(timer->fired_at - last), 0);
+    last = timer->fired_at;
+  }
+}
+
+// start ticks exercise cascades and wrap of the 32 bit tick counter
+INSTANTIATE_TEST_SUITE_P(StartTicks, TwheelTest, ::testing::Values(0u, 63u, 4095u, 0xFFFFFF00u));
+
+} // namespace
@@ -0,0 +1,260 @@
+"""
+System register map generator.
+
+Generates the sysreg_t layout, SYSREG_* offset and reset macros, the SYSREG_MAP register
+configuration list and the SYSREG_NV_MAP list of registers persisted to flash from a single
+declarative schema. Optionally rewrites the register table in the
+sysreg design document.
+
+usage: sysreg_gen.py --schema sysreg.json --header sysreg_map.h [--doc docs/design/sysreg.md]
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+FLT_MAX = 3.4028234663852886e38
+
+DTYPES = {
+    "u8": {"ctype": "uint8_t", "enum": "SYSREG_DTYPE_U8", "min": 0, "max": 0xFF},
+    "u16": {"ctype": "uint16_t", "enum": "SYSREG_DTYPE_U16", "min": 0, "max": 0xFFFF},
+    "u32": {"ctype": "uint32_t", "enum": "SYSREG_DTYPE_U32", "min": 0, "max": 0xFFFFFFFF},
+    "f32": {"ctype": "float", "enum": "SYSREG_DTYPE_F32", "min": -FLT_MAX, "max": FLT_MAX},
+}
+
+ACCESS = {"L": "SYSREG_ACCESS_L", "R": "SYSREG_ACCESS_R", "W": "SYSREG_ACCESS_W"}
+
+DOC_BEGIN = "<!-- sysreg-table:begin -->"
+DOC_END = "<!-- sysreg-table:end -->"
+
+
+class SchemaError(Exception):
+    pass
+
+
+def parse_number(value, dtype, field, name):
+    if isinstance(value, str):
+        try:
+            value = int(value, 0)
+        except ValueError:
+            raise SchemaError(f"{name}: {field} '{value}' is not a number")
+    if dtype != "f32" and (isinstance(value, float) and not value.is_integer()):
+        raise SchemaError(f"{name}: {field} {value} is not an integer")
+    return value if dtype == "f32" else int(value)
+
+
+def load_schema(path):
+    with open(path) as f:
+        schema = json.load(f)
+    registers = []
+    names = set()
+    for entry in schema["registers"]:
+        name = entry["name"]
+        if not re.fullmatch(r"[a-z][a-z0-9_]*", name):
+            raise SchemaError(f"{name}: register names must be lower snake case")
+        if name in names:
+            raise SchemaError(f"{name}: duplicate register")
+        names.add(name)
+        dtype = entry["dtype"]
+        if dtype not in DTYPES:
+            raise SchemaError(f"{name}: unsupported dtype '{dtype}'")
+        access = entry["access"].upper()
+        if not access or any(a not in ACCESS for a in access):
+            raise SchemaError(f"{name}: access must be a combination of {''.join(ACCESS)}")
+        limits = DTYPES[dtype]
+        reset = parse_number(entry.get("reset", 0), dtype, "reset", name)
+        vmin = parse_number(entry.get("min", limits["min"]), dtype, "min", name)
+        vmax = parse_number(entry.get("max", limits["max"]), dtype, "max", name)
+        if not limits["min"] <= vmin <= vmax <= limits["max"]:
+            raise SchemaError(f"{name}: min/max [{vmin}, {vmax}] invalid for {dtype}")
+        if not vmin <= reset <= vmax:
+            raise SchemaError(f"{name}: reset {reset} outside of [{vmin}, {vmax}]")
+        nv = entry.get("nv", False)
+        if not isinstance(nv, bool):
+            raise SchemaError(f"{name}: nv must be true or false")
+        if nv and "W" not in access:
+            raise SchemaError(f"{name}: nv registers must be writable to be restored")
+        registers.append({
+            "name": name,
+            "dtype": dtype,
+            "access": access,
+            "reset": reset,
+            "reset_str": entry.get("reset", 0),
+            "min": vmin,
+            "max": vmax,
+            "description": entry.get("description", ""),
+            "nv": nv,
+        })
+    return registers
+
+
+def c_literal(value, dtype):
+    if dtype == "f32":
+        if value == FLT_MAX:
+            return "FLT_MAX"
+        if value == -FLT_MAX:
+            return "-FLT_MAX"
+        return f"{float(value)!r}f"
+    return f"{value}u"
+
+
+def c_reset(reg):
+    ctype = DTYPES[reg["dtype"]]["ctype"]
+    if reg["dtype"] == "f32":
+        return f"({ctype}){c_literal(reg['reset'], 'f32')}"
+    if isinstance(reg["reset_str"], str):
+        return f"({ctype}){reg['reset_str']}"
+    return f"({ctype}){reg['reset']}"
+
+
+def c_access(access):
+    return " | ".join(ACCESS[a] for a in "LRW" if a in access)
+
+
+def render_header(registers, schema_name):
+    out = []
+    out.append("/**")
+    out.append(" * @file sysreg_map.h")
+    out.append(f" * @brief System register map generated from {schema_name} by utils/sysreg_gen.py")
+    out.append(" * @warning DO NOT MODIFY")
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef __SYSREG_MAP_H__")
+    out.append("#define __SYSREG_MAP_H__")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("#include <stddef.h>")
+    out.append("")
+    out.append("typedef struct sysreg_t {")
+    for reg in registers:
+        ctype = DTYPES[reg["dtype"]]["ctype"]
+        comment = f" // {reg['description']}" if reg["description"] else ""
+        out.append(f"  {ctype} {reg['name']};{comment}")
+    out.append("} sysreg_t;")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief System register access offsets")
+    out.append(" */")
+    for reg in registers:
+        out.append(f"#define SYSREG_{reg['name'].upper()} offsetof(sysreg_t, {reg['name']})")
+    out.append(f"#define SYSREG_COUNT {len(registers)}")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief System register reset")
+    out.append(" */")
+    for reg in registers:
+        out.append(f"#define SYSREG_{reg['name'].upper()}_RESET {c_reset(reg)}")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief System register map")
+    out.append(" *")
+    out.append(" * X(name, member, dtype, field, access, reset, min, max)")
+    out.append(" */")
+    out.append("// clang-format off")
+    out.append("#define SYSREG_MAP(X) \\")
+    rows = []
+    for reg in registers:
+        upper = reg["name"].upper()
+        dtype = reg["dtype"]
+        rows.append(
+            f"  X({upper}, {reg['name']}, {DTYPES[dtype]['enum']}, {dtype}, {c_access(reg['access'])}, "
+            f"SYSREG_{upper}_RESET, {c_literal(reg['min'], dtype)}, {c_literal(reg['max'], dtype)})"
+        )
+    out.append(" \\\n".join(rows))
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Integer register reset range checks (f32 ranges are checked by the generator)")
+    out.append(" *")
+    out.append(" * X(name, reset, min, max)")
+    out.append(" */")
+    out.append("#define SYSREG_RESET_CHECKS(X) \\")
+    rows = []
+    for reg in registers:
+        if reg["dtype"] == "f32":
+            continue
+        upper = reg["name"].upper()
+        rows.append(f"  X({upper}, SYSREG_{upper}_RESET, {c_literal(reg['min'], reg['dtype'])}, {c_literal(reg['max'], reg['dtype'])})")
+    out.append(" \\\n".join(rows))
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Registers persisted to flash")
+    out.append(" *")
+    out.append(" * X(name, dtype)")
+    out.append(" */")
+    nv = [reg for reg in registers if reg["nv"]]
+    out.append(f"#define SYSREG_NV_COUNT {len(nv)}")
+    out.append("#define SYSREG_NV_MAP(X) \\")
+    out.append(" \\\n".join(f"  X({reg['name'].upper()}, {DTYPES[reg['dtype']]['enum']})" for reg in nv))
+    out.append("// clang-format on")
+    out.append("")
+    out.append("#endif // __SYSREG_MAP_H__")
+    out.append("")
+    return "\n".join(out)
+
+
+def doc_value(value, dtype):
+    if dtype == "f32":
+        if value == FLT_MAX:
+            return "FLT_MAX"
+        if value == -FLT_MAX:
+            return "-FLT_MAX"
+        return f"{float(value):g}"
+    return str(value)
+
+
+def render_doc_table(registers):
+    out = ["| Register | Offset | Type | Access | Reset | Min | Max | NV | Description |", "|---|---|---|---|---|---|---|---|---|"]
+    offset = 0
+    for reg in registers:
+        size = {"u8": 1, "u16": 2, "u32": 4, "f32": 4}[reg["dtype"]]
+        offset = (offset + size - 1) // size * size
+        reset = reg["reset_str"] if isinstance(reg["reset_str"], str) else doc_value(reg["reset"], reg["dtype"])
+        out.append(
+            f"| `SYSREG_{reg['name'].upper()}` | {offset} | `{reg['dtype']}` | {reg['access']} | {reset} | "
+            f"{doc_value(reg['min'], reg['dtype'])} | {doc_value(reg['max'], reg['dtype'])} | {'yes' if reg['nv'] else ''} | "
+            f"{reg['description']} |"
+        )
+        offset += size
+    return "\n".join(out)
+
+
+def update_doc(path, registers):
+    text = Path(path).read_text()
+    begin = text.find(DOC_BEGIN)
+    end = text.find(DOC_END)
+    if begin < 0 or end < begin:
+        raise SchemaError(f"{path}: missing {DOC_BEGIN} / {DOC_END} markers")
+    text = text[: begin + len(DOC_BEGIN)] + "\n" + render_doc_table(registers) + "\n" + text[end:]
+    Path(path).write_text(text)
+
+
+def write_if_changed(path, content):
+    path = Path(path)
+    if path.exists() and path.read_text() == content:
+        return
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_text(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--schema", required=True, help="register schema (json)")
+    parser.add_argument("--header", help="output register map header")
+    parser.add_argument("--doc", help="markdown document containing the register table markers")
+    args = parser.parse_args()
+    try:
+        registers = load_schema(args.schema)
+        if args.header:
+            write_if_changed(args.header, render_header(registers, Path(args.schema).name))
+        if args.doc:
+            update_doc(args.doc, registers)
+    except (SchemaError, KeyError) as e:
+        print(f"sysreg_gen: {args.schema}: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())